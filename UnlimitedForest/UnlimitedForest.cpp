@@ -3,10 +3,21 @@
 #include "UnlimitedForest.h"
 #include "core/application/App.h"
 #include "log/Log.h"
+#include "benchmark/Benchmark.h"
+#include "impostor/ImpostorBaker.h"
 
 int main(int argc, char* argv[]) {
 	Log::init();
 
+	// headless benchmarks run instead of the game when requested
+	if (Benchmark::run_from_args(argc, argv)) {
+		return 0;
+	}
+	// offline impostor bake in a hidden window, the atlases are written out as images
+	if (ImpostorBaker::run_from_args(argc, argv)) {
+		return 0;
+	}
+
 	App* app = new App();
 	app->start();
 
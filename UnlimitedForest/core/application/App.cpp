@@ -1,19 +1,25 @@
 #include "App.h"
+#include "memory/AllocationCounter.h"
+#include "impostor/ImpostorBaker.h"
+#include "mesh_manager/DemoMeshes.h"
+#include "gl_state/GLStateCache.h"
+#include "log/GLDebug.h"
+#include "shader/ProgramCache.h"
 
 #include <iostream>	
 #include <cassert>
 #include <vector>
-#include <fstream>
+#include <cmath>
 
 App* App::m_app = nullptr;
 
-App::App() {
-	m_graphicsPipelineShaderProgram = 0;
+App::App() : m_launchTime(std::chrono::steady_clock::now()), m_jobSystem(m_engineConfig.m_workerThreads), m_frameArena(m_engineConfig.m_frameArenaBytes), m_nodeManager(&m_meshManager, &m_jobSystem) {
+	// members are constructed by now, scene setup below already goes through App::get()
+	m_app = this;
 	m_running = false;
+	m_engineConfig.validate();
 	initialize_sdl();
 	create_graphics_pipeline();
-
-	m_app = this;
 }
 
 App::~App() {
@@ -33,6 +39,10 @@ void App::initialize_sdl(){
 	// render flags
 	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+#if UF_GL_DEBUG
+	// errors are reported through KHR_debug instead of polling glGetError, release builds skip both
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+#endif
 
 	// creating the window handler
 	Uint32 flags = SDL_WINDOW_OPENGL  
@@ -43,6 +53,12 @@ void App::initialize_sdl(){
 
 	// initializing opengl context
 	m_openGLContext = SDL_GL_CreateContext(m_graphicsApplicationWindow);
+	if (!m_openGLContext) {
+		// mesa llvmpipe stops at 4.5, the shaders only need 4.5 + ARB_shader_draw_parameters
+		UF_LOG_WARN("no opengl 4.6 context ({}), falling back to 4.5", SDL_GetError());
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+		m_openGLContext = SDL_GL_CreateContext(m_graphicsApplicationWindow);
+	}
 	assert(m_openGLContext);
 
 	// init glad, loading OpenGL function pointers
@@ -51,12 +67,29 @@ void App::initialize_sdl(){
 		cleanup();
 		std::exit(-1);
 	}
+	// nothing has been set through the cache on this context yet
+	GLStateCache::get().reset();
+#if UF_GL_DEBUG
+	GLDebug::init();
+#endif
 	get_opengl_version_info();
 
+	ProgramCache::get().init(make_absolute_path("shader_cache"), (GLADloadproc)SDL_GL_GetProcAddress);
+	prefetch_programs();
+	create_scene();
+
+	// keep mouse in center
+	SDL_WarpMouseInWindow(m_graphicsApplicationWindow, m_engineConfig.m_screenWidth / 2, m_engineConfig.m_screenHeight / 2);
+	SDL_SetRelativeMouseMode(SDL_TRUE);
+}
+
+void App::create_scene() {
 	// creating inital nodes
 	m_nodeManager.create_camera();
 	// TODO: find a better place to define render objects
-	m_nodeManager.create_render_item(
+	// the quad is uploaded once, every item below is an instance of it
+	// it is open, so it carries both windings to stay visible from behind with back face culling on
+	MeshId quad = m_meshManager.create_mesh("demo/quad",
 		{
 			//   x      y      z// quad
 			// vec 1
@@ -74,41 +107,58 @@ void App::initialize_sdl(){
 		},
 		{
 		0, 1, 2,
-		1, 3, 2
-		},
+		1, 3, 2,
+		// back side
+		0, 2, 1,
+		1, 2, 3
+		}
+	);
+	// the forest's species, solid enough to double as its own occluder, which is rasterized from the cpu copy
+	std::vector<GLfloat> treeVertices;
+	std::vector<GLuint> treeIndices;
+	build_demo_tree(treeVertices, treeIndices);
+	MeshId treeMesh = m_meshManager.create_mesh(DEMO_TREE_ASSET,
+		treeVertices,
+		treeIndices,
+		m_engineConfig.m_occlusionCulling ? static_cast<uint32_t>(MESH_KEEP_CPU_COPY) : 0u
+	);
+
+	m_nodeManager.create_render_item(quad,
 		glm::vec3(0.0f, 0.0f, 0.0f),
 		glm::vec3(0.0f, 0.0f, 0.0f),
 		glm::vec3(1.0f, 1.0f, 1.0f)
 	);
-
-	m_nodeManager.create_render_item(
-		{
-			//   x      y      z// quad
-			// vec 1
-			-0.5f, -0.5f, 0.0f, // x y z bottom left
-			1.0f, 0.0f, 0.0f,   // r g b
-			// vec 2
-			0.5f, -0.5f, 0.0f,  // x y z bottom right
-			0.0f, 1.0f, 0.0f,   // r g b
-			// vec 3
-			-0.5f,  0.5f, 0.0f, // x y z top left
-			0.0f, 0.0f, 1.0f,   // r g b
-			// vec 4
-			0.5f, 0.5f, 0.0f,  // x y z top right
-			0.0f, 1.0f, 0.0f,   // r g b
-		},
-		{
-		0, 1, 2,
-		1, 3, 2
-		},
+	m_nodeManager.create_render_item(quad,
 		glm::vec3(0.0f, 0.0f, -2.0f),
 		glm::vec3(0.0f, 0.0f, 0.0f),
 		glm::vec3(1.0f, 1.0f, 1.0f)
 	);
 
-	// keep mouse in center
-	SDL_WarpMouseInWindow(m_graphicsApplicationWindow, m_engineConfig.m_screenWidth / 2, m_engineConfig.m_screenHeight / 2);
-	SDL_SetRelativeMouseMode(SDL_TRUE);
+	// stress grid on the ground plane, all of it collapses into a single indirect draw
+	uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(m_engineConfig.m_forestInstances))));
+	for (uint32_t i = 0; i < m_engineConfig.m_forestInstances; i++) {
+		float x = (static_cast<float>(i % side) - side * 0.5f) * m_engineConfig.m_forestSpacing;
+		float z = -static_cast<float>(i / side) * m_engineConfig.m_forestSpacing - 4.0f;
+		float shade = 0.5f + 0.5f * static_cast<float>((i * 2654435761u) >> 24) / 255.0f;
+		NodeId tree = m_nodeManager.create_render_item(treeMesh,
+			glm::vec3(x, 0.0f, z),
+			glm::vec3(0.0f, static_cast<float>(i % 360), 0.0f),
+			glm::vec3(1.0f, 1.0f, 1.0f),
+			glm::vec4(shade, shade, shade, 1.0f)
+		);
+		if (m_engineConfig.m_occlusionCulling && tree.is_valid()) {
+			static_cast<RenderItem*>(m_nodeManager.get_node(tree))->set_occluder(treeMesh);
+		}
+	}
+	// every item holds its own reference now
+	m_meshManager.release_mesh(quad);
+	m_meshManager.release_mesh(treeMesh);
+	UF_LOG_INFO("scene created with {} render items over {} meshes ({} dedup hits, {} bytes of cpu mesh data kept)",
+		m_nodeManager.get_node_count() - 1,
+		m_meshManager.get_mesh_count(),
+		m_meshManager.get_dedup_hits(),
+		m_meshManager.get_cpu_bytes()
+	);
 }
 
 void App::get_opengl_version_info() {
@@ -125,6 +175,13 @@ void App::get_opengl_version_info() {
 }
 
 void App::cleanup() {
+	// nodes own gpu objects, free them before the context goes away
+	m_nodeManager.clear();
+	m_meshManager.clear();
+	m_meshManager.set_release_listener(nullptr, nullptr);
+	m_renderer.destroy();
+	m_graphicsPipelinePrograms.destroy();
+	ProgramCache::get().clear();
 	// cleanup sdl window and opengl context
 	SDL_GL_DeleteContext(m_openGLContext);
 	SDL_DestroyWindow(m_graphicsApplicationWindow);
@@ -137,15 +194,21 @@ void App::start() {
 }
 
 void App::main_loop() {
+	uint64_t frameIdx = 0;
 	while (m_running) {
-		// init and clear screen per loop
-		// TODO: this should be somewhere else
-		glDisable(GL_DEPTH_TEST);
-		glDisable(GL_CULL_FACE);
-
-		glViewport(0, 0, m_engineConfig.m_screenWidth, m_engineConfig.m_screenHeight);
+		AllocationScope frameAllocations;
+		m_frameArena.begin_frame();
+		GLStateCache& state = GLStateCache::get();
+		state.begin_frame();
+
+		// init and clear screen per loop, depth / cull state is set per pass by the renderer
+		// the clear honours the write masks whatever the last pass left them at
+		state.bind_framebuffer(GL_FRAMEBUFFER, 0);
+		state.set_viewport(0, 0, m_engineConfig.m_screenWidth, m_engineConfig.m_screenHeight);
+		state.set_clear_color(0.0f, 0.0f, 0.0f, 1.0f);
+		state.set_depth_mask(true);
+		state.set_color_mask(true);
 		CATCH_GL_ERROR("screen init error");
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
 
@@ -157,6 +220,28 @@ void App::main_loop() {
 
 		// swap double buffer / update window
 		SDL_GL_SwapWindow(this->get_graphics_application_window());
+
+		if (frameIdx == 0) {
+			UF_LOG_INFO("time to first frame: {:.1f} ms",
+				std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_launchTime).count()
+			);
+		}
+
+		UF_LOG_TRACE("frame {} | gl state calls issued: {} | filtered: {}",
+			frameIdx,
+			state.get_frame_stats().m_issued,
+			state.get_frame_stats().m_filtered
+		);
+
+		// the frame loop is meant to stay off the heap, flag any frame that does not
+		if (frameAllocations.get_allocations() > 0) {
+			UF_LOG_TRACE("frame {} made {} heap allocations ({} bytes)",
+				frameIdx,
+				frameAllocations.get_allocations(),
+				frameAllocations.get_bytes()
+			);
+		}
+		frameIdx++;
 	}
 }
 
@@ -170,97 +255,117 @@ bool App::is_running() const {
 
 void App::update() {
 	m_nodeManager.update();
+	m_renderer.render(m_nodeManager, m_meshManager, m_frameArena, m_engineConfig, m_graphicsPipelinePrograms);
 }
 
-// TODO: move this to graphics pipeline / shader handler
-GLuint App::compile_shader(GLuint type, const std::string& source) {
-	GLuint shaderObject = glCreateShader(type);
-	const char* src = source.c_str();
-	glShaderSource(shaderObject, 1, &src, nullptr);
-	glCompileShader(shaderObject);
-
-	CATCH_GL_ERROR("error compiling shader object");
-
-	// Check if compilation succeeded
-	GLint status;
-	glGetShaderiv(shaderObject, GL_COMPILE_STATUS, &status);
-	if (status == GL_FALSE) {
-		GLint length;
-		glGetShaderiv(shaderObject, GL_INFO_LOG_LENGTH, &length);
-		std::vector<char> log(length);
-		glGetShaderInfoLog(shaderObject, length, nullptr, log.data());
-		std::cerr << "Shader compilation failed (type "
-			<< (type == GL_VERTEX_SHADER ? "vertex" : "fragment")
-			<< "): " << log.data() << std::endl;
-		glDeleteShader(shaderObject);
-		return 0;
+void App::prefetch_programs() {
+	// same programs and conditions as create_graphics_pipeline(), a program missing here is only built serially
+	// the mesh queue's programs are needed with and without the lod dither from the first frame on
+	auto prefetchQueueVariants = [](const std::string& vertexPath, const std::string& fragmentPath) {
+		ShaderPermutations::prefetch_from_files(vertexPath, fragmentPath, 0);
+		ShaderPermutations::prefetch_from_files(vertexPath, fragmentPath, SHADER_FEATURE_LOD_DITHER);
+	};
+	prefetchQueueVariants(make_absolute_path("shaders", "vert.glsl"), make_absolute_path("shaders", "frag.glsl"));
+	if (m_engineConfig.m_gpuCulling) {
+		ShaderProgram::prefetch_compute_from_file(make_absolute_path("shaders", "cull.comp"));
+		ShaderProgram::prefetch_compute_from_file(make_absolute_path("shaders", "depth_pyramid.comp"));
+	}
+	if (m_engineConfig.m_depthPrepass) {
+		prefetchQueueVariants(make_absolute_path("shaders", "vert.glsl"), make_absolute_path("shaders", "depth_prepass.frag"));
+	}
+	if (m_engineConfig.m_overdrawView) {
+		prefetchQueueVariants(make_absolute_path("shaders", "vert.glsl"), make_absolute_path("shaders", "overdraw.frag"));
+	}
+	if (m_engineConfig.m_impostorDistance > 0.0f) {
+		ShaderProgram::prefetch_from_files(make_absolute_path("shaders", "impostor.vert"), make_absolute_path("shaders", "impostor.frag"));
+		ShaderProgram::prefetch_from_files(make_absolute_path("shaders", "impostor_bake.vert"), make_absolute_path("shaders", "impostor_bake.frag"));
+	}
+	if (m_engineConfig.m_farField) {
+		ShaderProgram::prefetch_from_files(make_absolute_path("shaders", "fullscreen.vert"), make_absolute_path("shaders", "far_field_capture.frag"));
+		ShaderProgram::prefetch_from_files(make_absolute_path("shaders", "fullscreen.vert"), make_absolute_path("shaders", "far_field_composite.frag"));
 	}
-
-	return shaderObject;
 }
 
-GLuint App::create_shader_program(const std::string& vertexShaderSource, const std::string& fragmentShaderSource) {
-	GLuint programObject = glCreateProgram();
-
-	GLuint myVertexShader = compile_shader(GL_VERTEX_SHADER, vertexShaderSource);
-	GLuint myFragmentShader = compile_shader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-
-	if (!myVertexShader || !myFragmentShader) {
-		glDeleteProgram(programObject);
-		std::cerr << "Failed to build shader program" << std::endl;
-		return 0;
+void App::create_graphics_pipeline() {
+	auto pipelineStart = std::chrono::steady_clock::now();
+	// the variant every instance that is not cross-fading draws with, the renderer checks its interface
+	ShaderProgram* program = m_graphicsPipelinePrograms.create_from_files(
+		make_absolute_path("shaders", "vert.glsl"),
+		make_absolute_path("shaders", "frag.glsl")) ? m_graphicsPipelinePrograms.get(0) : nullptr;
+	if (program == nullptr) {
+		UF_LOG_ERROR("failed to create graphics pipeline");
+		return;
 	}
-
-	glAttachShader(programObject, myVertexShader);
-	glAttachShader(programObject, myFragmentShader);
-	glLinkProgram(programObject);
-
-	// Check if linking succeeded
-	GLint status;
-	glGetProgramiv(programObject, GL_LINK_STATUS, &status);
-	if (status == GL_FALSE) {
-		GLint length;
-		glGetProgramiv(programObject, GL_INFO_LOG_LENGTH, &length);
-		std::vector<char> log(length);
-		glGetProgramInfoLog(programObject, length, nullptr, log.data());
-		std::cerr << "Program linking failed: " << log.data() << std::endl;
-		glDeleteProgram(programObject);
-		return 0;
+	if (!m_renderer.init(*program)) {
+		UF_LOG_ERROR("failed to initialize renderer");
+		return;
+	}
+	if (m_engineConfig.m_gpuCulling && !m_renderer.init_gpu_culling(
+		make_absolute_path("shaders", "cull.comp"),
+		make_absolute_path("shaders", "depth_pyramid.comp"))) {
+		UF_LOG_WARN("gpu culling unavailable, culling on the cpu");
+		m_engineConfig.m_gpuCulling = false;
+	}
+	if (m_engineConfig.m_depthPrepass && !m_renderer.init_depth_prepass(
+		make_absolute_path("shaders", "vert.glsl"),
+		make_absolute_path("shaders", "depth_prepass.frag"))) {
+		UF_LOG_WARN("depth prepass unavailable, shading every fragment that passes");
+		m_engineConfig.m_depthPrepass = false;
+	}
+	if (m_engineConfig.m_overdrawView && !m_renderer.init_overdraw_view(
+		make_absolute_path("shaders", "vert.glsl"),
+		make_absolute_path("shaders", "overdraw.frag"))) {
+		UF_LOG_WARN("overdraw view unavailable, drawing the scene as usual");
+		m_engineConfig.m_overdrawView = false;
+	}
+	if (m_engineConfig.m_impostorDistance > 0.0f) {
+		create_impostors();
+	}
+	if (m_engineConfig.m_farField && !m_renderer.init_far_field(
+		make_absolute_path("shaders", "fullscreen.vert"),
+		make_absolute_path("shaders", "far_field_capture.frag"),
+		make_absolute_path("shaders", "far_field_composite.frag"),
+		m_engineConfig.m_farFieldResolution)) {
+		UF_LOG_WARN("far field unavailable, nothing is drawn past the near scene");
+		m_engineConfig.m_farField = false;
 	}
 
-	// Clean up
-	glDetachShader(programObject, myVertexShader);
-	glDetachShader(programObject, myFragmentShader);
-	glDeleteShader(myVertexShader);
-	glDeleteShader(myFragmentShader);
-
-	return programObject;
+	const ProgramCacheStats& programs = ProgramCache::get().get_stats();
+	UF_LOG_INFO("graphics pipeline ready in {:.1f} ms: {} programs from disk, {} compiled ({} prefetched), {:.1f} ms waiting on the driver",
+		std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - pipelineStart).count(),
+		programs.m_binaryHits,
+		programs.m_compiled,
+		programs.m_prefetched,
+		programs.m_waitMs
+	);
 }
 
-void App::create_graphics_pipeline() {
-	const std::string vertexShaderSource = load_shader_as_string(make_absolute_path("shaders", "vert.glsl"));
-	const std::string fragmentShaderSource = load_shader_as_string(make_absolute_path("shaders", "frag.glsl"));
-	m_graphicsPipelineShaderProgram = create_shader_program(vertexShaderSource, fragmentShaderSource);
-
-	CATCH_GL_ERROR("error creating graphics pipeline");
+void App::create_impostors() {
+	if (!m_renderer.init_impostors(
+		make_absolute_path("shaders", "impostor.vert"),
+		make_absolute_path("shaders", "impostor.frag"))) {
+		UF_LOG_WARN("impostors unavailable, distant trees are drawn as meshes");
+		return;
+	}
+	// an impostor's atlas goes with its mesh
+	m_meshManager.set_release_listener([](void* data, const MeshId& mesh) {
+		static_cast<ImpostorRenderer*>(data)->remove_impostor(mesh);
+	}, &m_renderer.get_impostors());
+
+	// the baker is only needed while baking, the atlases live on in the renderer
+	ImpostorBaker baker;
+	if (!baker.create(
+		make_absolute_path("shaders", "impostor_bake.vert"),
+		make_absolute_path("shaders", "impostor_bake.frag"))) {
+		return;
+	}
+	MeshId tree = m_meshManager.find_mesh(DEMO_TREE_ASSET);
+	ImpostorRenderer& impostors = m_renderer.get_impostors();
+	if (tree.is_valid() && !baker.bake(m_meshManager, tree, m_engineConfig.m_impostorFrames, m_engineConfig.m_impostorFrameSize, *impostors.add_impostor(tree))) {
+		impostors.remove_impostor(tree);
+	}
 }
 
 void App::resize_window(int w, int h) {
 	SDL_SetWindowSize(m_graphicsApplicationWindow, w, h);
 }
-
-std::string App::load_shader_as_string(const std::string& filename) {
-	// Open the file
-	std::ifstream file(filename);
-	if (!file.is_open()) {
-		std::cerr << "Error: could not open file: " << filename << std::endl;
-		return "";
-	}
-
-	// Use a string stream to read the file contents
-	std::stringstream shaderStream;
-	shaderStream << file.rdbuf();
-
-	// No need to manually close, as the ifstream destructor will handle it.
-	return shaderStream.str();
-}
@@ -4,10 +4,17 @@
 #include "node_manager/NodeManager.h"
 #include "camera/Camera.h"
 #include "input/InputHandler.h"
+#include "job_system/JobSystem.h"
+#include "memory/FrameArena.h"
+#include "mesh_manager/MeshManager.h"
+#include "renderer/Renderer.h"
+#include "shader/ShaderPermutations.h"
+#include "shader/ShaderProgram.h"
 #include "log/Log.h"
 
 #include "glad/glad.h"
 #include <SDL2/SDL.h>
+#include <chrono>
 #include <filesystem>
 #include <initializer_list>
 #include <string>
@@ -29,17 +36,30 @@ public:
 		return &m_nodeManager;
 	}
 
+	MeshManager* get_mesh_manager() {
+		return &m_meshManager;
+	}
+
 	SDL_Window* get_graphics_application_window() {
 		return m_graphicsApplicationWindow;
 	}
 
-	GLuint& get_graphics_pipeline_shader_program() {
-		return m_graphicsPipelineShaderProgram;
+	ShaderPermutations& get_graphics_pipeline_programs() {
+		return m_graphicsPipelinePrograms;
 	}
 	EngineConfig& get_engine_config() {
 		return m_engineConfig;
 	}
 
+	JobSystem* get_job_system() {
+		return &m_jobSystem;
+	}
+
+	// transient allocations that only live for this frame (and are readable during the next)
+	FrameArena* get_frame_arena() {
+		return &m_frameArena;
+	}
+
 	void resize_window(int w, int h);
 
 private:
@@ -48,17 +68,26 @@ private:
 	void get_opengl_version_info(void);
 	void cleanup(void);
 
-	// TODO: move this to graphics pipeline / shader handler
-	GLuint compile_shader(GLuint type, const std::string& source);
-	GLuint create_shader_program(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
+	// hands every program create_graphics_pipeline() will build to the driver at once, so they compile
+	// in parallel (and while the scene is set up) instead of one after another
+	void prefetch_programs(void);
 	void create_graphics_pipeline(void);
-	std::string load_shader_as_string(const std::string& filename);
+	// bakes the demo species' impostor atlases, distant items fall back to meshes if this fails
+	void create_impostors(void);
+	void create_scene(void);
 
+	// declared first so startup timing covers the construction of everything below
+	std::chrono::steady_clock::time_point m_launchTime;
 	EngineConfig m_engineConfig;
+	// declared before the node manager so workers outlive anything that schedules on them
+	JobSystem m_jobSystem;
+	FrameArena m_frameArena;
 	SDL_Window* m_graphicsApplicationWindow;
 	SDL_GLContext m_openGLContext;
-	GLuint m_graphicsPipelineShaderProgram;
+	ShaderPermutations m_graphicsPipelinePrograms;
+	MeshManager m_meshManager;
 	NodeManager m_nodeManager;
+	Renderer m_renderer;
 	InputHandler m_inputHandler;
 	bool m_running;
 
@@ -0,0 +1,23 @@
+#include "EngineConfig.h"
+#include <log/Log.h>
+
+namespace {
+	// nearest the far field may start, the capture marches outwards from there
+	constexpr float MIN_FAR_FIELD_RADIUS = 1.0f;
+}
+
+bool EngineConfig::validate() {
+	bool valid = true;
+	// the capture steps geometrically by (distance / radius) ^ (1 / steps), negated comparisons also catch nan
+	if (!(m_farFieldRadius > 0.0f)) {
+		UF_LOG_WARN("far field radius {} is not positive, using {}", m_farFieldRadius, MIN_FAR_FIELD_RADIUS);
+		m_farFieldRadius = MIN_FAR_FIELD_RADIUS;
+		valid = false;
+	}
+	if (!(m_farFieldDistance > m_farFieldRadius)) {
+		UF_LOG_WARN("far field distance {} does not lie beyond its radius {}, using {}", m_farFieldDistance, m_farFieldRadius, m_farFieldRadius * 2.0f);
+		m_farFieldDistance = m_farFieldRadius * 2.0f;
+		valid = false;
+	}
+	return valid;
+}
@@ -1,6 +1,59 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 struct EngineConfig {
 	int m_screenWidth = 640;
 	int m_screenHeight = 480;
+	// 0 uses every hardware thread
+	uint32_t m_workerThreads = 0;
+	// per buffer size of the double buffered frame arena, check the logged high water mark when tuning
+	size_t m_frameArenaBytes = 4 * 1024 * 1024;
+	// instances of the demo mesh laid out in a grid, for stress testing the render path
+	uint32_t m_forestInstances = 0;
+	float m_forestSpacing = 1.5f;
+	// scales every item's projected size before its lod is picked, below 1 switches to coarser levels earlier
+	float m_lodBias = 1.0f;
+	// levels cross-fade while the projected size is within this fraction above the switch threshold
+	float m_lodFadeBand = 0.15f;
+	// items of a species with a baked impostor are drawn as two triangle billboards beyond this distance, 0 disables
+	float m_impostorDistance = 0.0f;
+	// hemi-octahedral view directions per atlas side and pixels per frame, baked at startup
+	uint32_t m_impostorFrames = 8;
+	int m_impostorFrameSize = 128;
+	// panorama of the forest past the near scene, composited behind it in one fullscreen pass
+	bool m_farField = false;
+	// where the far field starts (everything closer is the near scene) and where it fades into the sky,
+	// the start has to be positive and the fade beyond it (see validate())
+	float m_farFieldRadius = 150.0f;
+	float m_farFieldDistance = 4000.0f;
+	// a new capture starts once the camera is this far from the last one, and takes this many faces per frame
+	float m_farFieldUpdateDistance = 25.0f;
+	uint32_t m_farFieldFacesPerFrame = 1;
+	int m_farFieldResolution = 256;
+	// cull back faces in the opaque pass, meshes have to be closed or carry both windings where they are seen
+	// from behind (the demo quad does), anything single sided disappears from the back
+	bool m_backfaceCulling = true;
+	// lay down the queue's depth first with a shader that only dithers, shading then runs once per pixel,
+	// worth it once fragment shading outweighs drawing the geometry twice
+	bool m_depthPrepass = false;
+	// replace the queue's shading with an additive heat map of fragments shaded per pixel, far field and impostors
+	// are left out, Renderer::get_overdraw_stats() measures the same thing with or without it
+	bool m_overdrawView = false;
+	// test every item's bounds against the camera frustum before it is queued
+	bool m_frustumCulling = true;
+	// cull in a compute pass instead (frustum + occlusion against last frame's depth), the cpu still queues, sorts
+	// and uploads every item, it only skips the visibility tests
+	bool m_gpuCulling = false;
+	// rasterize occluder meshes into a small depth buffer on the workers and drop items hidden behind them
+	bool m_occlusionCulling = false;
+	uint32_t m_occlusionBufferWidth = 256;
+	uint32_t m_occlusionBufferHeight = 128;
+	// occluders farther away are skipped, they cover few pixels and cost as much as near ones
+	float m_occluderMaxDistance = 50.0f;
+
+	// clamps settings that would divide by zero or invert a range in the renderer, logging each one it changes,
+	// returns false if anything had to be changed
+	bool validate(void);
 };
@@ -0,0 +1,342 @@
+#include "Benchmark.h"
+#include <component_store/ComponentStore.h>
+#include <culling/Frustum.h>
+#include <culling/OcclusionBuffer.h>
+#include <job_system/JobSystem.h>
+#include <mesh_manager/DemoMeshes.h>
+#include <mesh_manager/MeshOptimizer.h>
+#include <log/Log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+	using BenchClock = std::chrono::high_resolution_clock;
+
+	double elapsed_ms(const BenchClock::time_point& start) {
+		return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+	}
+}
+
+bool Benchmark::run_from_args(int argc, char* argv[]) {
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--bench") {
+			std::string name = i + 1 < argc ? argv[i + 1] : "all";
+			if (!run(name)) {
+				UF_LOG_ERROR("unknown benchmark: {}", name);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Benchmark::run(const std::string& name) {
+	bool all = name == "all";
+	bool found = false;
+	if (all || name == "jobs") {
+		job_scaling();
+		found = true;
+	}
+	if (all || name == "cull") {
+		frustum_culling();
+		found = true;
+	}
+	if (all || name == "occlusion") {
+		occlusion_culling();
+		found = true;
+	}
+	if (all || name == "mesh_optimizer") {
+		mesh_optimizer();
+		found = true;
+	}
+	return found;
+}
+
+void Benchmark::job_scaling() {
+	// forest shaped scene, every tree is a root with a handful of branch children
+	constexpr uint32_t TREE_COUNT = 50000;
+	constexpr uint32_t BRANCHES_PER_TREE = 4;
+	constexpr int WARMUP_FRAMES = 5;
+	constexpr int FRAMES = 50;
+
+	ComponentStore store;
+	uint32_t nextIdx = 0;
+	std::vector<uint32_t> treeRows;
+	treeRows.reserve(TREE_COUNT);
+	for (uint32_t t = 0; t < TREE_COUNT; t++) {
+		NodeId tree(nextIdx++, 0);
+		uint32_t row = store.add_entity(tree, COMPONENT_TRANSFORM);
+		store.get_transforms().m_positions[row] = glm::vec3(float(t % 256), 0.0f, float(t / 256));
+		treeRows.push_back(row);
+		for (uint32_t b = 0; b < BRANCHES_PER_TREE; b++) {
+			NodeId branch(nextIdx++, 0);
+			uint32_t branchRow = store.add_entity(branch, COMPONENT_TRANSFORM);
+			store.get_transforms().m_positions[branchRow] = glm::vec3(0.0f, 1.0f + b, 0.0f);
+			store.set_parent(branch, tree);
+		}
+	}
+
+	// 1, 2, 4 ... up to and including every hardware thread
+	uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t t = 1; t < hardwareThreads; t *= 2) {
+		threadCounts.push_back(t);
+	}
+	threadCounts.push_back(hardwareThreads);
+
+	UF_LOG_INFO("[bench jobs] {} entities ({} roots), every root moves each frame", store.size(), TREE_COUNT);
+	double singleThreadMs = 0.0;
+	for (uint32_t threads : threadCounts) {
+		JobSystem jobSystem(threads);
+
+		double totalMs = 0.0;
+		for (int frame = -WARMUP_FRAMES; frame < FRAMES; frame++) {
+			// worst case, the whole forest is dirty
+			for (uint32_t row : treeRows) {
+				store.get_transforms().m_rotations[row].y += 1.0f;
+				store.mark_transform_dirty(row);
+			}
+			BenchClock::time_point start = BenchClock::now();
+			store.update_transforms(&jobSystem);
+			if (frame >= 0) {
+				totalMs += elapsed_ms(start);
+			}
+		}
+
+		double frameMs = totalMs / FRAMES;
+		if (threads == 1) {
+			singleThreadMs = frameMs;
+		}
+		UF_LOG_INFO("[bench jobs] threads: {:2} | {:8.3f} ms/update | {:8.0f} entities/ms | speedup x{:.2f}",
+			threads,
+			frameMs,
+			store.size() / frameMs,
+			singleThreadMs / frameMs
+		);
+	}
+}
+
+void Benchmark::frustum_culling() {
+	// trees scattered around a camera at the origin looking down -z, most of them end up outside the frustum
+	constexpr uint32_t OBJECT_COUNT = 200000;
+	constexpr float WORLD_HALF_SIZE = 500.0f;
+	constexpr int WARMUP_RUNS = 5;
+	constexpr int RUNS = 50;
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> position(-WORLD_HALF_SIZE, WORLD_HALF_SIZE);
+	std::uniform_real_distribution<float> size(0.5f, 4.0f);
+
+	std::vector<float> minX(OBJECT_COUNT), minY(OBJECT_COUNT), minZ(OBJECT_COUNT);
+	std::vector<float> maxX(OBJECT_COUNT), maxY(OBJECT_COUNT), maxZ(OBJECT_COUNT);
+	std::vector<float> centerX(OBJECT_COUNT), centerY(OBJECT_COUNT), centerZ(OBJECT_COUNT), radius(OBJECT_COUNT);
+	for (uint32_t i = 0; i < OBJECT_COUNT; i++) {
+		glm::vec3 center(position(rng), position(rng) * 0.05f, position(rng));
+		glm::vec3 extent(size(rng), size(rng) * 3.0f, size(rng));
+		minX[i] = center.x - extent.x;
+		minY[i] = center.y - extent.y;
+		minZ[i] = center.z - extent.z;
+		maxX[i] = center.x + extent.x;
+		maxY[i] = center.y + extent.y;
+		maxZ[i] = center.z + extent.z;
+		centerX[i] = center.x;
+		centerY[i] = center.y;
+		centerZ[i] = center.z;
+		radius[i] = glm::length(extent);
+	}
+	BoundsSoA bounds = { minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data() };
+	SpheresSoA spheres = { centerX.data(), centerY.data(), centerZ.data(), radius.data() };
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 2.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum(projection * view);
+
+	std::vector<uint8_t> visible(OBJECT_COUNT);
+	std::vector<uint8_t> reference(OBJECT_COUNT);
+
+	// times one culling function over every object, returns ms per run and how many it culled
+	auto measure = [&](const char* label, auto&& cull) {
+		uint32_t culled = 0;
+		double totalMs = 0.0;
+		for (int run = -WARMUP_RUNS; run < RUNS; run++) {
+			BenchClock::time_point start = BenchClock::now();
+			culled = cull();
+			if (run >= 0) {
+				totalMs += elapsed_ms(start);
+			}
+		}
+		double runMs = totalMs / RUNS;
+		UF_LOG_INFO("[bench cull] {:14} | {:8.3f} ms | {:6} culled | {:10.0f} objects culled/ms | {:10.0f} objects tested/ms",
+			label,
+			runMs,
+			culled,
+			culled / runMs,
+			OBJECT_COUNT / runMs
+		);
+		return culled;
+	};
+
+	UF_LOG_INFO("[bench cull] {} objects, batch path: {}", OBJECT_COUNT, Frustum::get_simd_name());
+	measure("aabb scalar", [&]() { return frustum.cull_aabbs_scalar(bounds, 0, OBJECT_COUNT, reference.data()); });
+	measure("aabb simd", [&]() { return frustum.cull_aabbs(bounds, 0, OBJECT_COUNT, visible.data()); });
+	if (std::memcmp(visible.data(), reference.data(), OBJECT_COUNT) != 0) {
+		UF_LOG_ERROR("[bench cull] simd aabb results differ from the scalar reference");
+	}
+	measure("sphere scalar", [&]() { return frustum.cull_spheres_scalar(spheres, 0, OBJECT_COUNT, reference.data()); });
+	measure("sphere simd", [&]() { return frustum.cull_spheres(spheres, 0, OBJECT_COUNT, visible.data()); });
+	if (std::memcmp(visible.data(), reference.data(), OBJECT_COUNT) != 0) {
+		UF_LOG_ERROR("[bench cull] simd sphere results differ from the scalar reference");
+	}
+}
+
+void Benchmark::occlusion_culling() {
+	// trunk boxes close to the camera hide a good part of a dense forest further back
+	constexpr uint32_t OCCLUDER_COUNT = 60;
+	constexpr uint32_t OCCLUDEE_COUNT = 100000;
+	constexpr int WARMUP_RUNS = 5;
+	constexpr int RUNS = 50;
+
+	// unit box as 12 triangles, the occluder mesh every trunk instances
+	const std::vector<glm::vec3> boxPositions = {
+		{ -0.5f, -0.5f, -0.5f }, { 0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f },
+		{ -0.5f, -0.5f, 0.5f }, { 0.5f, -0.5f, 0.5f }, { 0.5f, 0.5f, 0.5f }, { -0.5f, 0.5f, 0.5f },
+	};
+	const std::vector<uint32_t> boxIndices = {
+		0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6,
+		0, 4, 5, 0, 5, 1, 3, 2, 6, 3, 6, 7,
+		0, 3, 7, 0, 7, 4, 1, 5, 6, 1, 6, 2,
+	};
+
+	std::mt19937 rng(4321);
+	std::uniform_real_distribution<float> nearX(-12.0f, 12.0f);
+	std::uniform_real_distribution<float> nearZ(-14.0f, -4.0f);
+	std::uniform_real_distribution<float> farX(-200.0f, 200.0f);
+	std::uniform_real_distribution<float> farZ(-300.0f, -20.0f);
+
+	std::vector<glm::mat4> occluders(OCCLUDER_COUNT);
+	for (glm::mat4& world : occluders) {
+		world = glm::translate(glm::mat4(1.0f), glm::vec3(nearX(rng), 2.0f, nearZ(rng)));
+		world = glm::scale(world, glm::vec3(0.8f, 8.0f, 0.8f));
+	}
+	std::vector<glm::vec3> occludeeMin(OCCLUDEE_COUNT), occludeeMax(OCCLUDEE_COUNT);
+	for (uint32_t i = 0; i < OCCLUDEE_COUNT; i++) {
+		glm::vec3 base(farX(rng), 0.0f, farZ(rng));
+		occludeeMin[i] = base - glm::vec3(1.0f, 0.0f, 1.0f);
+		occludeeMax[i] = base + glm::vec3(1.0f, 6.0f, 1.0f);
+	}
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 2.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 viewProjection = projection * view;
+	Frustum frustum(viewProjection);
+
+	OcclusionBuffer buffer(256, 128);
+	std::vector<OccluderTriangle> triangles(OCCLUDER_COUNT * boxIndices.size() / 3);
+	uint32_t triangleCount = 0;
+	uint32_t tested = 0;
+	uint32_t occluded = 0;
+	double rasterMs = 0.0;
+	double testMs = 0.0;
+	for (int run = -WARMUP_RUNS; run < RUNS; run++) {
+		BenchClock::time_point start = BenchClock::now();
+		buffer.clear(viewProjection);
+		triangleCount = 0;
+		for (const glm::mat4& world : occluders) {
+			triangleCount += buffer.project_triangles(world, boxPositions.data(), boxIndices.data(), static_cast<uint32_t>(boxIndices.size()), triangles.data() + triangleCount);
+		}
+		buffer.rasterize(triangles.data(), triangleCount, 0, buffer.get_height());
+		double runRasterMs = elapsed_ms(start);
+
+		start = BenchClock::now();
+		tested = 0;
+		occluded = 0;
+		for (uint32_t i = 0; i < OCCLUDEE_COUNT; i++) {
+			if (!frustum.test_aabb(occludeeMin[i], occludeeMax[i])) {
+				continue;
+			}
+			tested++;
+			occluded += buffer.test_aabb(occludeeMin[i], occludeeMax[i]) ? 0 : 1;
+		}
+		if (run >= 0) {
+			rasterMs += runRasterMs;
+			testMs += elapsed_ms(start);
+		}
+	}
+
+	UF_LOG_INFO("[bench occlusion] {}x{} buffer ({}), {} occluders ({} triangles), {} objects in the frustum",
+		buffer.get_width(),
+		buffer.get_height(),
+		OcclusionBuffer::get_simd_name(),
+		OCCLUDER_COUNT,
+		triangleCount,
+		tested
+	);
+	UF_LOG_INFO("[bench occlusion] raster {:8.3f} ms | test {:8.3f} ms | {:6} occluded ({:.1f}%) | {:10.0f} objects tested/ms",
+		rasterMs / RUNS,
+		testMs / RUNS,
+		occluded,
+		tested ? 100.0 * occluded / tested : 0.0,
+		tested / (testMs / RUNS)
+	);
+}
+
+void Benchmark::mesh_optimizer() {
+	// a grid the way a naive exporter writes it, three vertices of its own per triangle in no particular order
+	constexpr uint32_t GRID_SIDE = 128;
+	constexpr int RUNS = 10;
+
+	std::vector<GLfloat> gridVertices;
+	std::vector<GLuint> gridIndices;
+	std::vector<uint32_t> cells(GRID_SIDE * GRID_SIDE * 2);
+	for (uint32_t i = 0; i < cells.size(); i++) {
+		cells[i] = i;
+	}
+	std::mt19937 rng(97);
+	std::shuffle(cells.begin(), cells.end(), rng);
+	for (uint32_t cell : cells) {
+		float x = static_cast<float>((cell / 2) % GRID_SIDE);
+		float z = static_cast<float>((cell / 2) / GRID_SIDE);
+		const float corners[2][6] = {
+			{ x, z, x + 1.0f, z, x, z + 1.0f },
+			{ x + 1.0f, z, x + 1.0f, z + 1.0f, x, z + 1.0f },
+		};
+		for (int corner = 0; corner < 3; corner++) {
+			gridIndices.push_back(static_cast<GLuint>(gridVertices.size() / 6));
+			gridVertices.insert(gridVertices.end(), { corners[cell & 1][corner * 2], 0.0f, corners[cell & 1][corner * 2 + 1], 0.2f, 0.6f, 0.2f });
+		}
+	}
+
+	std::vector<GLfloat> treeVertices;
+	std::vector<GLuint> treeIndices;
+	build_demo_tree(treeVertices, treeIndices);
+
+	auto measure = [](const char* label, const std::vector<GLfloat>& sourceVertices, const std::vector<GLuint>& sourceIndices) {
+		MeshOptimizeStats stats;
+		double totalMs = 0.0;
+		for (int run = 0; run < RUNS; run++) {
+			std::vector<GLfloat> vertexData(sourceVertices);
+			std::vector<GLuint> indices(sourceIndices);
+			BenchClock::time_point start = BenchClock::now();
+			stats = MeshOptimizer::optimize(vertexData, indices);
+			totalMs += elapsed_ms(start);
+		}
+		UF_LOG_INFO("[bench mesh_optimizer] {:5} | {:6} -> {:6} vertices | {:6} -> {:6} triangles | acmr {:.3f} -> {:.3f} | {:8.3f} ms",
+			label,
+			stats.m_vertexCountBefore,
+			stats.m_vertexCountAfter,
+			stats.m_triangleCountBefore,
+			stats.m_triangleCountAfter,
+			stats.m_acmrBefore,
+			stats.m_acmrAfter,
+			totalMs / RUNS
+		);
+	};
+	measure("grid", gridVertices, gridIndices);
+	measure("tree", treeVertices, treeIndices);
+}
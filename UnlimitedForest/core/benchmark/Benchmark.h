@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+// headless micro benchmarks for engine systems, no window or gl context is created
+// run with: UnlimitedForest --bench <name> (or --bench all)
+class Benchmark {
+public:
+	// returns true if a benchmark was requested, in which case the app should not start
+	static bool run_from_args(int argc, char* argv[]);
+
+private:
+	static bool run(const std::string& name);
+
+	// transform update throughput of a forest sized scene as worker count grows
+	static void job_scaling(void);
+	// batched simd frustum tests against the scalar reference, reported as objects culled per ms
+	static void frustum_culling(void);
+	// software occluder rasterization + occludee tests of a forest behind a row of near trunks
+	static void occlusion_culling(void);
+	// weld + cache / overdraw / fetch reordering of a shuffled, unwelded grid and the demo tree, acmr before and after
+	static void mesh_optimizer(void);
+};
@@ -11,12 +11,13 @@
 
 class Camera : public Node {
 public:
-	Camera(const uint8_t& id);
-	Camera(const uint8_t& id, const glm::vec3 &eye,const glm::vec3 &viewDirectio, const glm::vec3 &up);
+	Camera(const NodeId& id);
+	Camera(const NodeId& id, const glm::vec3 &eye,const glm::vec3 &viewDirectio, const glm::vec3 &up);
 	~Camera();
 
 	//ultimate view matrix
 	glm::mat4 get_view_matrix();
+	const glm::vec3& get_position(void) const { return m_eye; }
 
 	void set_location(const glm::vec3& loc);
 	void translate(const glm::vec3& translation);
@@ -0,0 +1,295 @@
+#include "ComponentStore.h"
+#include <job_system/JobSystem.h>
+#include <log/Log.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+	// rows per job when the transform pass runs in parallel
+	constexpr uint32_t TRANSFORM_JOB_GRAIN = 1024;
+
+	// same ordering the render items always used: translate, yaw, pitch, then scale
+	glm::mat4 compose_transform(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale) {
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+		model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+		model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+		return glm::scale(model, scale);
+	}
+}
+
+ComponentStore::ComponentStore() {}
+
+ComponentStore::~ComponentStore() {}
+
+uint32_t ComponentStore::add_entity(const NodeId& id, ComponentMask mask) {
+	if (get_row(id) != INVALID_ROW) {
+		UF_LOG_ERROR("node with id: {} already has components", id.m_value);
+		return INVALID_ROW;
+	}
+
+	uint32_t row = static_cast<uint32_t>(m_masks.size());
+	if (id.index() >= m_nodeToRow.size()) {
+		m_nodeToRow.resize(id.index() + 1, INVALID_ROW);
+	}
+	m_nodeToRow[id.index()] = row;
+	m_rowToNode.push_back(id);
+	m_masks.push_back(mask);
+
+	// every pool gets a row so columns stay aligned, the mask says which are meaningful
+	m_transforms.m_positions.emplace_back(0.0f);
+	m_transforms.m_rotations.emplace_back(0.0f);
+	m_transforms.m_scales.emplace_back(1.0f);
+	m_transforms.m_localMatrices.emplace_back(1.0f);
+	m_transforms.m_worldMatrices.emplace_back(1.0f);
+	m_transforms.m_dirty.push_back(TRANSFORM_LOCAL_DIRTY | TRANSFORM_WORLD_DIRTY);
+	m_transforms.m_parents.emplace_back();
+	m_transforms.m_firstChildren.emplace_back();
+	m_transforms.m_nextSiblings.emplace_back();
+	m_meshes.m_meshes.emplace_back();
+	m_meshes.m_colors.emplace_back(1.0f);
+	m_visibility.m_visible.push_back(1);
+	m_bounds.m_localMin.emplace_back(0.0f);
+	m_bounds.m_localMax.emplace_back(0.0f);
+	m_bounds.m_minX.push_back(-FLT_MAX);
+	m_bounds.m_minY.push_back(-FLT_MAX);
+	m_bounds.m_minZ.push_back(-FLT_MAX);
+	m_bounds.m_maxX.push_back(FLT_MAX);
+	m_bounds.m_maxY.push_back(FLT_MAX);
+	m_bounds.m_maxZ.push_back(FLT_MAX);
+	m_bounds.m_centerX.push_back(0.0f);
+	m_bounds.m_centerY.push_back(0.0f);
+	m_bounds.m_centerZ.push_back(0.0f);
+	m_bounds.m_radius.push_back(FLT_MAX);
+	m_occluders.m_meshes.emplace_back();
+
+	return row;
+}
+
+bool ComponentStore::remove_entity(const NodeId& id) {
+	uint32_t row = get_row(id);
+	if (row == INVALID_ROW) {
+		return false;
+	}
+
+	// unlink from the hierarchy first, children fall back to the root keeping their local transform
+	detach_from_parent(row);
+	NodeId child = m_transforms.m_firstChildren[row];
+	while (child.is_valid()) {
+		uint32_t childRow = get_row(child);
+		NodeId next = m_transforms.m_nextSiblings[childRow];
+		m_transforms.m_parents[childRow] = NodeId();
+		m_transforms.m_nextSiblings[childRow] = NodeId();
+		m_transforms.m_dirty[childRow] |= TRANSFORM_WORLD_DIRTY;
+		child = next;
+	}
+
+	uint32_t last = static_cast<uint32_t>(m_masks.size() - 1);
+	if (row != last) {
+		for_each_column([row, last](auto& column) {
+			column[row] = column[last];
+		});
+		m_nodeToRow[m_rowToNode[row].index()] = row;
+	}
+	for_each_column([](auto& column) {
+		column.pop_back();
+	});
+
+	m_nodeToRow[id.index()] = INVALID_ROW;
+	return true;
+}
+
+uint32_t ComponentStore::get_row(const NodeId& id) const {
+	if (!id.is_valid() || id.index() >= m_nodeToRow.size()) {
+		return INVALID_ROW;
+	}
+	uint32_t row = m_nodeToRow[id.index()];
+	// a recycled slot index with an older generation must not resolve
+	if (row == INVALID_ROW || m_rowToNode[row] != id) {
+		return INVALID_ROW;
+	}
+	return row;
+}
+
+bool ComponentStore::has_components(const NodeId& id, ComponentMask mask) const {
+	uint32_t row = get_row(id);
+	return row != INVALID_ROW && (m_masks[row] & mask) == mask;
+}
+
+bool ComponentStore::add_components(const NodeId& id, ComponentMask mask) {
+	uint32_t row = get_row(id);
+	if (row == INVALID_ROW) {
+		return false;
+	}
+	m_masks[row] |= mask;
+	return true;
+}
+
+bool ComponentStore::remove_components(const NodeId& id, ComponentMask mask) {
+	uint32_t row = get_row(id);
+	if (row == INVALID_ROW) {
+		return false;
+	}
+	m_masks[row] &= ~mask;
+	return true;
+}
+
+bool ComponentStore::set_parent(const NodeId& child, const NodeId& parent) {
+	uint32_t childRow = get_row(child);
+	if (childRow == INVALID_ROW || !(m_masks[childRow] & COMPONENT_TRANSFORM)) {
+		UF_LOG_ERROR("node with id: {} has no transform to parent", child.m_value);
+		return false;
+	}
+
+	uint32_t parentRow = INVALID_ROW;
+	if (parent.is_valid()) {
+		parentRow = get_row(parent);
+		if (parentRow == INVALID_ROW || !(m_masks[parentRow] & COMPONENT_TRANSFORM)) {
+			UF_LOG_ERROR("node with id: {} has no transform to parent to", parent.m_value);
+			return false;
+		}
+		// refuse cycles, the new parent can not be the child or one of its descendants
+		for (NodeId ancestor = parent; ancestor.is_valid(); ancestor = m_transforms.m_parents[get_row(ancestor)]) {
+			if (ancestor == child) {
+				UF_LOG_ERROR("parenting node {} to {} would create a cycle", child.m_value, parent.m_value);
+				return false;
+			}
+		}
+	}
+
+	detach_from_parent(childRow);
+	if (parentRow != INVALID_ROW) {
+		m_transforms.m_parents[childRow] = parent;
+		m_transforms.m_nextSiblings[childRow] = m_transforms.m_firstChildren[parentRow];
+		m_transforms.m_firstChildren[parentRow] = child;
+	}
+	m_transforms.m_dirty[childRow] |= TRANSFORM_WORLD_DIRTY;
+	return true;
+}
+
+NodeId ComponentStore::get_parent(const NodeId& id) const {
+	uint32_t row = get_row(id);
+	return row == INVALID_ROW ? NodeId() : m_transforms.m_parents[row];
+}
+
+void ComponentStore::detach_from_parent(uint32_t row) {
+	NodeId parent = m_transforms.m_parents[row];
+	if (!parent.is_valid()) {
+		return;
+	}
+	NodeId id = m_rowToNode[row];
+	uint32_t parentRow = get_row(parent);
+
+	// unlink from the parent's singly linked child list
+	NodeId* link = &m_transforms.m_firstChildren[parentRow];
+	while (link->is_valid()) {
+		if (*link == id) {
+			*link = m_transforms.m_nextSiblings[row];
+			break;
+		}
+		link = &m_transforms.m_nextSiblings[get_row(*link)];
+	}
+	m_transforms.m_parents[row] = NodeId();
+	m_transforms.m_nextSiblings[row] = NodeId();
+	m_transforms.m_dirty[row] |= TRANSFORM_WORLD_DIRTY;
+}
+
+void ComponentStore::update_transforms(JobSystem* jobSystem) {
+	const ComponentMask* masks = m_masks.data();
+	const NodeId* parents = m_transforms.m_parents.data();
+
+	// roots are found linearly, each one carries its subtree so parents are always resolved before children
+	// and no two ranges ever write the same row
+	auto updateRoots = [this, masks, parents](uint32_t begin, uint32_t end) {
+		std::vector<PendingTransform> stack;
+		for (uint32_t row = begin; row < end; row++) {
+			if ((masks[row] & COMPONENT_TRANSFORM) && !parents[row].is_valid()) {
+				update_subtree(row, stack);
+			}
+		}
+	};
+
+	uint32_t rowCount = static_cast<uint32_t>(m_masks.size());
+	if (jobSystem) {
+		jobSystem->parallel_for(rowCount, TRANSFORM_JOB_GRAIN, updateRoots);
+	}
+	else {
+		updateRoots(0, rowCount);
+	}
+}
+
+void ComponentStore::update_subtree(uint32_t root, std::vector<PendingTransform>& stack) {
+	// depth first on an explicit stack so a deep hierarchy can not overflow a worker's call stack,
+	// a root without children (the common case) never touches it
+	push_children(root, update_transform(root, nullptr, false), stack);
+	while (!stack.empty()) {
+		PendingTransform pending = stack.back();
+		stack.pop_back();
+		bool changed = update_transform(pending.m_row, &m_transforms.m_worldMatrices[pending.m_parentRow], pending.m_parentChanged);
+		push_children(pending.m_row, changed, stack);
+	}
+}
+
+bool ComponentStore::update_transform(uint32_t row, const glm::mat4* parentWorld, bool parentChanged) {
+	uint8_t& dirty = m_transforms.m_dirty[row];
+	if (dirty & TRANSFORM_LOCAL_DIRTY) {
+		m_transforms.m_localMatrices[row] = compose_transform(
+			m_transforms.m_positions[row],
+			m_transforms.m_rotations[row],
+			m_transforms.m_scales[row]
+		);
+	}
+
+	// a moved ancestor dirties the whole subtree below it
+	bool changed = parentChanged || (dirty & TRANSFORM_WORLD_DIRTY);
+	if (changed) {
+		m_transforms.m_worldMatrices[row] = parentWorld
+			? *parentWorld * m_transforms.m_localMatrices[row]
+			: m_transforms.m_localMatrices[row];
+		if (m_masks[row] & COMPONENT_BOUNDS) {
+			update_world_bounds(row);
+		}
+	}
+	dirty = TRANSFORM_CLEAN;
+	return changed;
+}
+
+void ComponentStore::push_children(uint32_t row, bool changed, std::vector<PendingTransform>& stack) const {
+	for (NodeId child = m_transforms.m_firstChildren[row]; child.is_valid();) {
+		uint32_t childRow = get_row(child);
+		stack.push_back({ childRow, row, changed });
+		child = m_transforms.m_nextSiblings[childRow];
+	}
+}
+
+void ComponentStore::update_world_bounds(uint32_t row) {
+	const glm::mat4& world = m_transforms.m_worldMatrices[row];
+	glm::vec3 localCenter = (m_bounds.m_localMin[row] + m_bounds.m_localMax[row]) * 0.5f;
+	glm::vec3 localExtent = (m_bounds.m_localMax[row] - m_bounds.m_localMin[row]) * 0.5f;
+
+	// arvo: the world extent along each axis is the local extent projected through the absolute matrix
+	glm::vec3 center = glm::vec3(world * glm::vec4(localCenter, 1.0f));
+	glm::vec3 extent(0.0f);
+	for (int axis = 0; axis < 3; axis++) {
+		extent += glm::abs(glm::vec3(world[axis])) * localExtent[axis];
+	}
+	m_bounds.m_minX[row] = center.x - extent.x;
+	m_bounds.m_minY[row] = center.y - extent.y;
+	m_bounds.m_minZ[row] = center.z - extent.z;
+	m_bounds.m_maxX[row] = center.x + extent.x;
+	m_bounds.m_maxY[row] = center.y + extent.y;
+	m_bounds.m_maxZ[row] = center.z + extent.z;
+
+	// the local box's sphere scaled by the largest axis scale still encloses the rotated mesh
+	float maxScale = std::sqrt(std::max({
+		glm::dot(glm::vec3(world[0]), glm::vec3(world[0])),
+		glm::dot(glm::vec3(world[1]), glm::vec3(world[1])),
+		glm::dot(glm::vec3(world[2]), glm::vec3(world[2]))
+	}));
+	m_bounds.m_centerX[row] = center.x;
+	m_bounds.m_centerY[row] = center.y;
+	m_bounds.m_centerZ[row] = center.z;
+	m_bounds.m_radius[row] = glm::length(localExtent) * maxScale;
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <node/Node.h>
+#include <culling/Frustum.h>
+#include <mesh_manager/MeshManager.h>
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// bit per component type, an entity's mask says which pools hold live data for its row
+enum ComponentFlag : uint32_t {
+	COMPONENT_TRANSFORM = 1 << 0,
+	COMPONENT_MESH = 1 << 1,
+	COMPONENT_VISIBILITY = 1 << 2,
+	COMPONENT_BOUNDS = 1 << 3,
+	COMPONENT_OCCLUDER = 1 << 4,
+};
+using ComponentMask = uint32_t;
+
+// reference to the gpu side of a mesh, enough to issue a draw out of the shared mesh arenas
+// items sharing a mesh id are batched into one indirect draw
+struct MeshRef {
+	MeshId m_mesh;
+	GLsizei m_indexCount = 0;
+	uint32_t m_firstIndex = 0;
+	uint32_t m_baseVertex = 0;
+};
+
+// transform dirty bits, local means position / rotation / scale changed,
+// world means the cached world matrix is stale (own local changed or an ancestor moved)
+enum TransformDirtyFlag : uint8_t {
+	TRANSFORM_CLEAN = 0,
+	TRANSFORM_LOCAL_DIRTY = 1 << 0,
+	TRANSFORM_WORLD_DIRTY = 1 << 1,
+};
+
+// structure of arrays pools, every column is indexed by the entity's row in the store
+// so passes that only touch one attribute stream through contiguous memory
+struct TransformPool {
+	std::vector<glm::vec3> m_positions;
+	std::vector<glm::vec3> m_rotations; // euler degrees
+	std::vector<glm::vec3> m_scales;
+	std::vector<glm::mat4> m_localMatrices;
+	std::vector<glm::mat4> m_worldMatrices;
+	std::vector<uint8_t> m_dirty;
+
+	// hierarchy as intrusive child lists, stored as node ids since rows move on removal
+	std::vector<NodeId> m_parents;
+	std::vector<NodeId> m_firstChildren;
+	std::vector<NodeId> m_nextSiblings;
+};
+
+struct MeshPool {
+	std::vector<MeshRef> m_meshes;
+	// per-instance tint multiplied with the vertex colors
+	std::vector<glm::vec4> m_colors;
+};
+
+struct VisibilityPool {
+	std::vector<uint8_t> m_visible;
+};
+
+// rows without bounds keep the max float defaults and are never culled
+struct BoundsPool {
+	// mesh space box the world bounds are derived from whenever the world matrix changes
+	std::vector<glm::vec3> m_localMin;
+	std::vector<glm::vec3> m_localMax;
+
+	// world space box and enclosing sphere, one column per component for the simd frustum tests
+	std::vector<float> m_minX;
+	std::vector<float> m_minY;
+	std::vector<float> m_minZ;
+	std::vector<float> m_maxX;
+	std::vector<float> m_maxY;
+	std::vector<float> m_maxZ;
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_radius;
+
+	BoundsSoA get_aabbs(void) const {
+		return { m_minX.data(), m_minY.data(), m_minZ.data(), m_maxX.data(), m_maxY.data(), m_maxZ.data() };
+	}
+	SpheresSoA get_spheres(void) const {
+		return { m_centerX.data(), m_centerY.data(), m_centerZ.data(), m_radius.data() };
+	}
+};
+
+// simplified stand-in meshes (trunks, hills) drawn into the software occlusion buffer
+// the mesh has to be created with MESH_KEEP_CPU_COPY, it is rasterized on the cpu
+struct OccluderPool {
+	std::vector<MeshId> m_meshes;
+};
+
+class JobSystem;
+
+class ComponentStore {
+public:
+	static constexpr uint32_t INVALID_ROW = 0xFFFFFFFFu;
+
+	ComponentStore();
+	~ComponentStore();
+
+	// adds a row for the node with default component values, returns the row
+	uint32_t add_entity(const NodeId& id, ComponentMask mask);
+	// swap removes the node's row, the last row moves into the hole
+	bool remove_entity(const NodeId& id);
+
+	// rows move when other entities are removed, so look them up instead of caching them
+	uint32_t get_row(const NodeId& id) const;
+	NodeId get_node_id(uint32_t row) const { return m_rowToNode[row]; }
+	bool has_components(const NodeId& id, ComponentMask mask) const;
+	// flips mask bits of an existing row, the pools keep their values either way
+	bool add_components(const NodeId& id, ComponentMask mask);
+	bool remove_components(const NodeId& id, ComponentMask mask);
+
+	TransformPool& get_transforms(void) { return m_transforms; }
+	MeshPool& get_meshes(void) { return m_meshes; }
+	VisibilityPool& get_visibility(void) { return m_visibility; }
+	BoundsPool& get_bounds(void) { return m_bounds; }
+	OccluderPool& get_occluders(void) { return m_occluders; }
+	const TransformPool& get_transforms(void) const { return m_transforms; }
+	const MeshPool& get_meshes(void) const { return m_meshes; }
+	const VisibilityPool& get_visibility(void) const { return m_visibility; }
+	const BoundsPool& get_bounds(void) const { return m_bounds; }
+	const OccluderPool& get_occluders(void) const { return m_occluders; }
+
+	// calls fn(row) for every entity whose mask contains all requested components, in row order
+	template<typename Fn>
+	void query(ComponentMask mask, Fn&& fn) const {
+		query_range(mask, 0, static_cast<uint32_t>(m_masks.size()), fn);
+	}
+
+	template<typename Fn>
+	void query_range(ComponentMask mask, uint32_t begin, uint32_t end, Fn&& fn) const {
+		const ComponentMask* masks = m_masks.data();
+		for (uint32_t row = begin; row < end; row++) {
+			if ((masks[row] & mask) == mask) {
+				fn(row);
+			}
+		}
+	}
+
+	// attach child under parent so it inherits the parent's world transform,
+	// an invalid parent id detaches the child back to the root
+	bool set_parent(const NodeId& child, const NodeId& parent);
+	NodeId get_parent(const NodeId& id) const;
+
+	// flag a row after editing its position / rotation / scale, descendants pick it up during update
+	void mark_transform_dirty(uint32_t row) { m_transforms.m_dirty[row] |= TRANSFORM_LOCAL_DIRTY | TRANSFORM_WORLD_DIRTY; }
+
+	// recomputes cached local / world matrices (and world bounds), only rows that changed
+	// (or whose ancestors changed) do matrix work
+	// root subtrees are independent so with a job system they are split across workers
+	void update_transforms(JobSystem* jobSystem = nullptr);
+
+	size_t size(void) const { return m_masks.size(); }
+
+private:
+	// a row whose parent is already up to date, waiting on the subtree walk's stack
+	struct PendingTransform {
+		uint32_t m_row;
+		uint32_t m_parentRow;
+		bool m_parentChanged;
+	};
+
+	// walks a subtree from the root down, recomputing world matrices below the first dirty node,
+	// stack is scratch reused across the roots of a job
+	void update_subtree(uint32_t root, std::vector<PendingTransform>& stack);
+	// one row's local / world matrix, returns whether its world matrix changed
+	bool update_transform(uint32_t row, const glm::mat4* parentWorld, bool parentChanged);
+	void push_children(uint32_t row, bool changed, std::vector<PendingTransform>& stack) const;
+	void detach_from_parent(uint32_t row);
+	void update_world_bounds(uint32_t row);
+
+	// applies fn to every per-row column so adding a column only means touching add_entity and this
+	template<typename Fn>
+	void for_each_column(Fn&& fn) {
+		fn(m_masks);
+		fn(m_rowToNode);
+		fn(m_transforms.m_positions);
+		fn(m_transforms.m_rotations);
+		fn(m_transforms.m_scales);
+		fn(m_transforms.m_localMatrices);
+		fn(m_transforms.m_worldMatrices);
+		fn(m_transforms.m_dirty);
+		fn(m_transforms.m_parents);
+		fn(m_transforms.m_firstChildren);
+		fn(m_transforms.m_nextSiblings);
+		fn(m_meshes.m_meshes);
+		fn(m_meshes.m_colors);
+		fn(m_visibility.m_visible);
+		fn(m_bounds.m_localMin);
+		fn(m_bounds.m_localMax);
+		fn(m_bounds.m_minX);
+		fn(m_bounds.m_minY);
+		fn(m_bounds.m_minZ);
+		fn(m_bounds.m_maxX);
+		fn(m_bounds.m_maxY);
+		fn(m_bounds.m_maxZ);
+		fn(m_bounds.m_centerX);
+		fn(m_bounds.m_centerY);
+		fn(m_bounds.m_centerZ);
+		fn(m_bounds.m_radius);
+		fn(m_occluders.m_meshes);
+	}
+
+	std::vector<ComponentMask> m_masks;
+	std::vector<NodeId> m_rowToNode;
+	// indexed by NodeId::index(), generation is checked through m_rowToNode
+	std::vector<uint32_t> m_nodeToRow;
+
+	TransformPool m_transforms;
+	MeshPool m_meshes;
+	VisibilityPool m_visibility;
+	BoundsPool m_bounds;
+	OccluderPool m_occluders;
+};
@@ -0,0 +1,233 @@
+#include "Frustum.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define UF_CULL_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UF_CULL_SSE 1
+#endif
+
+Frustum::Frustum() {
+	for (glm::vec4& plane : m_planes) {
+		plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+	// gribb / hartmann, planes are sums of the matrix rows (glm is column major so row i is m[c][i])
+	auto row = [&viewProjection](int i) {
+		return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	};
+	glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+	m_planes[PLANE_LEFT] = r3 + r0;
+	m_planes[PLANE_RIGHT] = r3 - r0;
+	m_planes[PLANE_BOTTOM] = r3 + r1;
+	m_planes[PLANE_TOP] = r3 - r1;
+	m_planes[PLANE_NEAR] = r3 + r2;
+	m_planes[PLANE_FAR] = r3 - r2;
+
+	// normalized so sphere radii can be compared against plane distances directly
+	for (glm::vec4& plane : m_planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+}
+
+bool Frustum::test_aabb(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const {
+	for (const glm::vec4& plane : m_planes) {
+		// corner furthest along the plane normal, if even that is behind the plane the box is outside
+		glm::vec3 positive(
+			plane.x >= 0.0f ? boundsMax.x : boundsMin.x,
+			plane.y >= 0.0f ? boundsMax.y : boundsMin.y,
+			plane.z >= 0.0f ? boundsMax.z : boundsMin.z
+		);
+		if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::test_sphere(const glm::vec3& center, float radius) const {
+	for (const glm::vec4& plane : m_planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+uint32_t Frustum::cull_aabbs_scalar(const BoundsSoA& bounds, uint32_t begin, uint32_t end, uint8_t* visible) const {
+	uint32_t culled = 0;
+	for (uint32_t i = begin; i < end; i++) {
+		bool inside = test_aabb(
+			glm::vec3(bounds.m_minX[i], bounds.m_minY[i], bounds.m_minZ[i]),
+			glm::vec3(bounds.m_maxX[i], bounds.m_maxY[i], bounds.m_maxZ[i])
+		);
+		visible[i] = inside ? 1 : 0;
+		culled += inside ? 0 : 1;
+	}
+	return culled;
+}
+
+uint32_t Frustum::cull_spheres_scalar(const SpheresSoA& spheres, uint32_t begin, uint32_t end, uint8_t* visible) const {
+	uint32_t culled = 0;
+	for (uint32_t i = begin; i < end; i++) {
+		bool inside = test_sphere(glm::vec3(spheres.m_centerX[i], spheres.m_centerY[i], spheres.m_centerZ[i]), spheres.m_radius[i]);
+		visible[i] = inside ? 1 : 0;
+		culled += inside ? 0 : 1;
+	}
+	return culled;
+}
+
+#if defined(UF_CULL_AVX)
+
+const char* Frustum::get_simd_name() {
+	return "avx";
+}
+
+uint32_t Frustum::cull_aabbs(const BoundsSoA& bounds, uint32_t begin, uint32_t end, uint8_t* visible) const {
+	uint32_t culled = 0;
+	uint32_t i = begin;
+	const __m256 zero = _mm256_setzero_ps();
+	for (; i + 8 <= end; i += 8) {
+		__m256 minX = _mm256_loadu_ps(bounds.m_minX + i);
+		__m256 minY = _mm256_loadu_ps(bounds.m_minY + i);
+		__m256 minZ = _mm256_loadu_ps(bounds.m_minZ + i);
+		__m256 maxX = _mm256_loadu_ps(bounds.m_maxX + i);
+		__m256 maxY = _mm256_loadu_ps(bounds.m_maxY + i);
+		__m256 maxZ = _mm256_loadu_ps(bounds.m_maxZ + i);
+
+		// lanes stay set while the box is in front of every plane tested so far
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (const glm::vec4& plane : m_planes) {
+			// the plane's sign picks the positive vertex per axis, the same for all 8 boxes
+			__m256 px = plane.x >= 0.0f ? maxX : minX;
+			__m256 py = plane.y >= 0.0f ? maxY : minY;
+			__m256 pz = plane.z >= 0.0f ? maxZ : minZ;
+			__m256 distance = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(px, _mm256_set1_ps(plane.x)), _mm256_mul_ps(py, _mm256_set1_ps(plane.y))),
+				_mm256_add_ps(_mm256_mul_ps(pz, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w))
+			);
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+		}
+
+		int mask = _mm256_movemask_ps(inside);
+		for (int lane = 0; lane < 8; lane++) {
+			visible[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+			culled += ((mask >> lane) & 1) ? 0 : 1;
+		}
+	}
+	return culled + cull_aabbs_scalar(bounds, i, end, visible);
+}
+
+uint32_t Frustum::cull_spheres(const SpheresSoA& spheres, uint32_t begin, uint32_t end, uint8_t* visible) const {
+	uint32_t culled = 0;
+	uint32_t i = begin;
+	for (; i + 8 <= end; i += 8) {
+		__m256 cx = _mm256_loadu_ps(spheres.m_centerX + i);
+		__m256 cy = _mm256_loadu_ps(spheres.m_centerY + i);
+		__m256 cz = _mm256_loadu_ps(spheres.m_centerZ + i);
+		__m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.m_radius + i));
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (const glm::vec4& plane : m_planes) {
+			__m256 distance = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)), _mm256_mul_ps(cy, _mm256_set1_ps(plane.y))),
+				_mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w))
+			);
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+		}
+
+		int mask = _mm256_movemask_ps(inside);
+		for (int lane = 0; lane < 8; lane++) {
+			visible[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+			culled += ((mask >> lane) & 1) ? 0 : 1;
+		}
+	}
+	return culled + cull_spheres_scalar(spheres, i, end, visible);
+}
+
+#elif defined(UF_CULL_SSE)
+
+const char* Frustum::get_simd_name() {
+	return "sse2";
+}
+
+uint32_t Frustum::cull_aabbs(const BoundsSoA& bounds, uint32_t begin, uint32_t end, uint8_t* visible) const {
+	uint32_t culled = 0;
+	uint32_t i = begin;
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= end; i += 4) {
+		__m128 minX = _mm_loadu_ps(bounds.m_minX + i);
+		__m128 minY = _mm_loadu_ps(bounds.m_minY + i);
+		__m128 minZ = _mm_loadu_ps(bounds.m_minZ + i);
+		__m128 maxX = _mm_loadu_ps(bounds.m_maxX + i);
+		__m128 maxY = _mm_loadu_ps(bounds.m_maxY + i);
+		__m128 maxZ = _mm_loadu_ps(bounds.m_maxZ + i);
+
+		// lanes stay set while the box is in front of every plane tested so far
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (const glm::vec4& plane : m_planes) {
+			// the plane's sign picks the positive vertex per axis, the same for all 4 boxes
+			__m128 px = plane.x >= 0.0f ? maxX : minX;
+			__m128 py = plane.y >= 0.0f ? maxY : minY;
+			__m128 pz = plane.z >= 0.0f ? maxZ : minZ;
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(plane.x)), _mm_mul_ps(py, _mm_set1_ps(plane.y))),
+				_mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w))
+			);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (int lane = 0; lane < 4; lane++) {
+			visible[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+			culled += ((mask >> lane) & 1) ? 0 : 1;
+		}
+	}
+	return culled + cull_aabbs_scalar(bounds, i, end, visible);
+}
+
+uint32_t Frustum::cull_spheres(const SpheresSoA& spheres, uint32_t begin, uint32_t end, uint8_t* visible) const {
+	uint32_t culled = 0;
+	uint32_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		__m128 cx = _mm_loadu_ps(spheres.m_centerX + i);
+		__m128 cy = _mm_loadu_ps(spheres.m_centerY + i);
+		__m128 cz = _mm_loadu_ps(spheres.m_centerZ + i);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.m_radius + i));
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (const glm::vec4& plane : m_planes) {
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+				_mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w))
+			);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (int lane = 0; lane < 4; lane++) {
+			visible[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+			culled += ((mask >> lane) & 1) ? 0 : 1;
+		}
+	}
+	return culled + cull_spheres_scalar(spheres, i, end, visible);
+}
+
+#else
+
+const char* Frustum::get_simd_name() {
+	return "scalar";
+}
+
+uint32_t Frustum::cull_aabbs(const BoundsSoA& bounds, uint32_t begin, uint32_t end, uint8_t* visible) const {
+	return cull_aabbs_scalar(bounds, begin, end, visible);
+}
+
+uint32_t Frustum::cull_spheres(const SpheresSoA& spheres, uint32_t begin, uint32_t end, uint8_t* visible) const {
+	return cull_spheres_scalar(spheres, begin, end, visible);
+}
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// world space bounds stored as structure of arrays so the frustum tests can load 4 / 8 entities per register
+struct BoundsSoA {
+	const float* m_minX;
+	const float* m_minY;
+	const float* m_minZ;
+	const float* m_maxX;
+	const float* m_maxY;
+	const float* m_maxZ;
+};
+
+struct SpheresSoA {
+	const float* m_centerX;
+	const float* m_centerY;
+	const float* m_centerZ;
+	const float* m_radius;
+};
+
+// six world space planes (xyz normal pointing inwards, w distance) extracted from a view-projection matrix
+// the batch tests use avx (8 wide) when the build enables it, sse (4 wide) otherwise, with a scalar tail
+class Frustum {
+public:
+	// prefixed since windows headers define NEAR / FAR
+	enum Plane { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+
+	Frustum();
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	const glm::vec4& get_plane(Plane plane) const { return m_planes[plane]; }
+
+	// conservative, only rejects bounds entirely outside one plane
+	bool test_aabb(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+	bool test_sphere(const glm::vec3& center, float radius) const;
+
+	// writes 1 (inside / intersecting) or 0 (outside) to visible[i] for every i in [begin, end),
+	// returns how many were culled
+	uint32_t cull_aabbs(const BoundsSoA& bounds, uint32_t begin, uint32_t end, uint8_t* visible) const;
+	uint32_t cull_spheres(const SpheresSoA& spheres, uint32_t begin, uint32_t end, uint8_t* visible) const;
+
+	// same results without simd, the reference the batch paths are benchmarked against
+	uint32_t cull_aabbs_scalar(const BoundsSoA& bounds, uint32_t begin, uint32_t end, uint8_t* visible) const;
+	uint32_t cull_spheres_scalar(const SpheresSoA& spheres, uint32_t begin, uint32_t end, uint8_t* visible) const;
+
+	// name of the batch instruction set compiled in, for logs
+	static const char* get_simd_name(void);
+
+private:
+	glm::vec4 m_planes[PLANE_COUNT];
+};
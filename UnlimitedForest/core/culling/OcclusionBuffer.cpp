@@ -0,0 +1,225 @@
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UF_OCCLUSION_SSE 1
+#endif
+
+namespace {
+	// clip space w below this counts as touching the camera plane
+	constexpr float MIN_CLIP_W = 1e-4f;
+}
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height) : m_width(0), m_height(0), m_viewProjection(1.0f) {
+	resize(width, height);
+}
+
+void OcclusionBuffer::resize(uint32_t width, uint32_t height) {
+	width = (std::max(width, 4u) + 3) & ~3u;
+	height = std::max(height, 1u);
+	if (width == m_width && height == m_height) {
+		return;
+	}
+	m_width = width;
+	m_height = height;
+	m_depth.assign(static_cast<size_t>(m_width) * m_height, 1.0f);
+}
+
+void OcclusionBuffer::clear(const glm::mat4& viewProjection) {
+	m_viewProjection = viewProjection;
+	std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+}
+
+const char* OcclusionBuffer::get_simd_name() {
+#if defined(UF_OCCLUSION_SSE)
+	return "sse2";
+#else
+	return "scalar";
+#endif
+}
+
+bool OcclusionBuffer::project(const glm::vec4& clip, glm::vec3& screen) const {
+	if (clip.w < MIN_CLIP_W) {
+		return false;
+	}
+	float invW = 1.0f / clip.w;
+	screen.x = (clip.x * invW * 0.5f + 0.5f) * static_cast<float>(m_width);
+	screen.y = (clip.y * invW * 0.5f + 0.5f) * static_cast<float>(m_height);
+	screen.z = clip.z * invW * 0.5f + 0.5f;
+	return true;
+}
+
+uint32_t OcclusionBuffer::project_triangles(const glm::mat4& world, const glm::vec3* positions, const uint32_t* indices, uint32_t indexCount, OccluderTriangle* out) const {
+	glm::mat4 worldViewProjection = m_viewProjection * world;
+	float width = static_cast<float>(m_width);
+	float height = static_cast<float>(m_height);
+
+	uint32_t written = 0;
+	for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+		OccluderTriangle& triangle = out[written];
+		if (!project(worldViewProjection * glm::vec4(positions[indices[i]], 1.0f), triangle.m_v0)
+			|| !project(worldViewProjection * glm::vec4(positions[indices[i + 1]], 1.0f), triangle.m_v1)
+			|| !project(worldViewProjection * glm::vec4(positions[indices[i + 2]], 1.0f), triangle.m_v2)) {
+			continue;
+		}
+		// entirely off screen or beyond the far plane, and the real render clips anything nearer than
+		// the near plane, so a triangle crossing it could hide what is actually visible
+		float minX = std::min({ triangle.m_v0.x, triangle.m_v1.x, triangle.m_v2.x });
+		float maxX = std::max({ triangle.m_v0.x, triangle.m_v1.x, triangle.m_v2.x });
+		float minY = std::min({ triangle.m_v0.y, triangle.m_v1.y, triangle.m_v2.y });
+		float maxY = std::max({ triangle.m_v0.y, triangle.m_v1.y, triangle.m_v2.y });
+		float minZ = std::min({ triangle.m_v0.z, triangle.m_v1.z, triangle.m_v2.z });
+		if (maxX < 0.0f || minX >= width || maxY < 0.0f || minY >= height || minZ < 0.0f || minZ > 1.0f) {
+			continue;
+		}
+		written++;
+	}
+	return written;
+}
+
+void OcclusionBuffer::get_band_range(const OccluderTriangle& triangle, uint32_t& firstBand, uint32_t& lastBand) const {
+	// same rows rasterize covers, clamped as floats first since projected coordinates can be huge
+	float lastRow = static_cast<float>(m_height - 1);
+	float minY = std::clamp(std::min({ triangle.m_v0.y, triangle.m_v1.y, triangle.m_v2.y }), 0.0f, lastRow);
+	float maxY = std::clamp(std::max({ triangle.m_v0.y, triangle.m_v1.y, triangle.m_v2.y }), 0.0f, lastRow);
+	firstBand = static_cast<uint32_t>(minY) / BAND_HEIGHT;
+	lastBand = static_cast<uint32_t>(maxY) / BAND_HEIGHT;
+}
+
+void OcclusionBuffer::rasterize(const OccluderTriangle* triangles, uint32_t triangleCount, uint32_t rowBegin, uint32_t rowEnd) {
+	rowEnd = std::min(rowEnd, m_height);
+	float* depth = m_depth.data();
+
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		glm::vec3 v0 = triangles[t].m_v0;
+		glm::vec3 v1 = triangles[t].m_v1;
+		glm::vec3 v2 = triangles[t].m_v2;
+
+		// occluders are two sided, flip clockwise triangles so inside is always positive
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+		if (std::fabs(area) < 1e-6f) {
+			continue;
+		}
+		if (area < 0.0f) {
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		int minX = std::max(static_cast<int>(std::floor(std::min({ v0.x, v1.x, v2.x }))), 0);
+		int maxX = std::min(static_cast<int>(std::floor(std::max({ v0.x, v1.x, v2.x }))), static_cast<int>(m_width) - 1);
+		int minY = std::max(static_cast<int>(std::floor(std::min({ v0.y, v1.y, v2.y }))), static_cast<int>(rowBegin));
+		int maxY = std::min(static_cast<int>(std::floor(std::max({ v0.y, v1.y, v2.y }))), static_cast<int>(rowEnd) - 1);
+		if (minX > maxX || minY > maxY) {
+			continue;
+		}
+
+		// edge functions a * x + b * y + c, positive on the inner side, evaluated at pixel centers
+		float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v1.y * v2.x;
+		float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v2.y * v0.x;
+		float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v0.y * v1.x;
+		// depth is linear in screen space, weights are the edge functions over the area
+		float invArea = 1.0f / area;
+		float za = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * invArea;
+		float zb = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * invArea;
+		float zc = (c0 * v0.z + c1 * v1.z + c2 * v2.z) * invArea;
+
+		// rows are padded to 4 pixels so aligned groups never run past the end
+		int startX = minX & ~3;
+		for (int y = minY; y <= maxY; y++) {
+			float py = static_cast<float>(y) + 0.5f;
+			float* row = depth + static_cast<size_t>(y) * m_width;
+			float e0Row = b0 * py + c0;
+			float e1Row = b1 * py + c1;
+			float e2Row = b2 * py + c2;
+			float zRow = zb * py + zc;
+#if defined(UF_OCCLUSION_SSE)
+			const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 zero = _mm_setzero_ps();
+			for (int x = startX; x <= maxX; x += 4) {
+				__m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+				__m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), px), _mm_set1_ps(e0Row));
+				__m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a1), px), _mm_set1_ps(e1Row));
+				__m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a2), px), _mm_set1_ps(e2Row));
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if (_mm_movemask_ps(inside) == 0) {
+					continue;
+				}
+				__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), _mm_set1_ps(zRow));
+				__m128 current = _mm_loadu_ps(row + x);
+				__m128 nearest = _mm_min_ps(current, z);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+			}
+#else
+			for (int x = minX; x <= maxX; x++) {
+				float px = static_cast<float>(x) + 0.5f;
+				if (a0 * px + e0Row >= 0.0f && a1 * px + e1Row >= 0.0f && a2 * px + e2Row >= 0.0f) {
+					row[x] = std::min(row[x], za * px + zRow);
+				}
+			}
+#endif
+		}
+	}
+}
+
+bool OcclusionBuffer::test_aabb(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const {
+	float minX = static_cast<float>(m_width), maxX = 0.0f;
+	float minY = static_cast<float>(m_height), maxY = 0.0f;
+	float nearest = 1.0f;
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec3 point(
+			corner & 1 ? boundsMax.x : boundsMin.x,
+			corner & 2 ? boundsMax.y : boundsMin.y,
+			corner & 4 ? boundsMax.z : boundsMin.z
+		);
+		glm::vec3 screen;
+		// reaching behind the camera, nothing to compare against
+		if (!project(m_viewProjection * glm::vec4(point, 1.0f), screen)) {
+			return true;
+		}
+		minX = std::min(minX, screen.x);
+		maxX = std::max(maxX, screen.x);
+		minY = std::min(minY, screen.y);
+		maxY = std::max(maxY, screen.y);
+		nearest = std::min(nearest, screen.z);
+	}
+
+	// every pixel the screen rect touches, off screen boxes are left to the frustum test
+	int x0 = std::max(static_cast<int>(std::floor(minX)), 0);
+	int x1 = std::min(static_cast<int>(std::floor(maxX)), static_cast<int>(m_width) - 1);
+	int y0 = std::max(static_cast<int>(std::floor(minY)), 0);
+	int y1 = std::min(static_cast<int>(std::floor(maxY)), static_cast<int>(m_height) - 1);
+	if (x0 > x1 || y0 > y1 || nearest <= 0.0f) {
+		return true;
+	}
+
+	const float* depth = m_depth.data();
+	for (int y = y0; y <= y1; y++) {
+		const float* row = depth + static_cast<size_t>(y) * m_width;
+#if defined(UF_OCCLUSION_SSE)
+		__m128 boxDepth = _mm_set1_ps(nearest);
+		for (int x = x0 & ~3; x <= x1; x += 4) {
+			// lanes outside [x0, x1] of the first / last group are masked off
+			int lanes = 0xF;
+			if (x < x0) {
+				lanes &= 0xF << (x0 - x);
+			}
+			if (x + 3 > x1) {
+				lanes &= 0xF >> (x + 3 - x1);
+			}
+			if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth)) & lanes) {
+				return true;
+			}
+		}
+#else
+		for (int x = x0; x <= x1; x++) {
+			if (row[x] >= nearest) {
+				return true;
+			}
+		}
+#endif
+	}
+	return false;
+}
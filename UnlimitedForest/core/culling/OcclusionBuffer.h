@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// occluder triangle after projection, xy in buffer pixels and z window depth [0, 1]
+struct OccluderTriangle {
+	glm::vec3 m_v0;
+	glm::vec3 m_v1;
+	glm::vec3 m_v2;
+};
+
+// low resolution depth buffer for software occlusion culling: simplified occluder meshes are rasterized
+// into it on the cpu (4 pixels per sse op), occludee boxes are then tested against it before submission
+// the buffer is split into horizontal bands that never share a row, so bands can be rasterized concurrently
+class OcclusionBuffer {
+public:
+	static constexpr uint32_t BAND_HEIGHT = 16;
+
+	OcclusionBuffer(uint32_t width = 256, uint32_t height = 128);
+
+	// width is rounded up to a multiple of 4 so rows can be read 4 pixels at a time, no-op if the size is unchanged
+	void resize(uint32_t width, uint32_t height);
+	// resets every pixel to the far plane, occluders and occludees are projected with viewProjection
+	void clear(const glm::mat4& viewProjection);
+
+	// writes the triangles of a mesh that can occlude to out (room for indexCount / 3) and returns how many were
+	// written, triangles crossing the near plane are dropped, which is always safe
+	uint32_t project_triangles(const glm::mat4& world, const glm::vec3* positions, const uint32_t* indices, uint32_t indexCount, OccluderTriangle* out) const;
+	// bands [firstBand, lastBand] the triangle's rows fall in, for one project_triangles kept (those always
+	// overlap the buffer), so each band can be handed only the triangles that reach it
+	void get_band_range(const OccluderTriangle& triangle, uint32_t& firstBand, uint32_t& lastBand) const;
+	// keeps the nearest depth per pixel, only rows [rowBegin, rowEnd) are touched
+	void rasterize(const OccluderTriangle* triangles, uint32_t triangleCount, uint32_t rowBegin, uint32_t rowEnd);
+
+	// false only if every pixel the box covers holds an occluder nearer than the box's nearest point
+	bool test_aabb(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+	uint32_t get_width(void) const { return m_width; }
+	uint32_t get_height(void) const { return m_height; }
+	uint32_t get_band_count(void) const { return (m_height + BAND_HEIGHT - 1) / BAND_HEIGHT; }
+	const float* get_depth(void) const { return m_depth.data(); }
+
+	// name of the instruction set the rasterizer and tests use, for logs
+	static const char* get_simd_name(void);
+
+private:
+	// projects to buffer pixels / window depth, false if the point is not in front of the camera
+	bool project(const glm::vec4& clip, glm::vec3& screen) const;
+
+	uint32_t m_width;
+	uint32_t m_height;
+	std::vector<float> m_depth;
+	glm::mat4 m_viewProjection;
+};
@@ -0,0 +1,176 @@
+#include "FarField.h"
+#include <log/Log.h>
+#include <log/GLDebug.h>
+#include <gl_state/GLStateCache.h>
+
+#include <algorithm>
+
+FarField::FarField()
+	: m_vertexArray(0),
+	m_framebuffer(0),
+	m_cubemaps{},
+	m_front(0),
+	m_resolution(0),
+	m_capturePosition(0.0f),
+	m_pendingPosition(0.0f),
+	m_nextFace(0),
+	m_capturing(false),
+	m_hasCapture(false),
+	m_facesRendered(0),
+	m_captureCount(0)
+{}
+
+FarField::~FarField() {
+	destroy();
+}
+
+bool FarField::create(const std::string& vertexPath, const std::string& captureFragmentPath, const std::string& compositeFragmentPath, int resolution) {
+	destroy();
+	if (resolution <= 0) {
+		UF_LOG_ERROR("can not create a far field with {} pixel faces", resolution);
+		return false;
+	}
+	if (!m_captureProgram.create_from_files(vertexPath, captureFragmentPath) || !m_compositeProgram.create_from_files(vertexPath, compositeFragmentPath)) {
+		UF_LOG_ERROR("failed to build the far field programs");
+		destroy();
+		return false;
+	}
+
+	m_resolution = resolution;
+	glCreateTextures(GL_TEXTURE_CUBE_MAP, 2, m_cubemaps);
+	for (GLuint cubemap : m_cubemaps) {
+		glTextureStorage2D(cubemap, 1, GL_RGBA8, m_resolution, m_resolution);
+		glTextureParameteri(cubemap, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTextureParameteri(cubemap, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(cubemap, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(cubemap, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(cubemap, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	}
+	// filtering across face edges, otherwise the cube's seams show on the horizon
+	GLStateCache::get().set_enabled(GL_TEXTURE_CUBE_MAP_SEAMLESS, true);
+
+	glCreateVertexArrays(1, &m_vertexArray);
+	glCreateFramebuffers(1, &m_framebuffer);
+	UF_GL_LABEL(GL_TEXTURE, m_cubemaps[0], "far field panorama");
+	UF_GL_LABEL(GL_TEXTURE, m_cubemaps[1], "far field panorama");
+	UF_GL_LABEL(GL_VERTEX_ARRAY, m_vertexArray, "far field fullscreen triangle");
+	UF_GL_LABEL(GL_FRAMEBUFFER, m_framebuffer, "far field capture");
+	glNamedFramebufferTextureLayer(m_framebuffer, GL_COLOR_ATTACHMENT0, m_cubemaps[0], 0, 0);
+	GLenum status = glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		UF_LOG_ERROR("far field capture framebuffer is incomplete: 0x{:x}", status);
+		destroy();
+		return false;
+	}
+	CATCH_GL_ERROR("error creating far field");
+	return true;
+}
+
+void FarField::destroy() {
+	m_captureProgram.destroy();
+	m_compositeProgram.destroy();
+	GLStateCache& state = GLStateCache::get();
+	if (m_framebuffer) {
+		state.forget_framebuffer(m_framebuffer);
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_vertexArray) {
+		state.forget_vertex_array(m_vertexArray);
+		glDeleteVertexArrays(1, &m_vertexArray);
+		m_vertexArray = 0;
+	}
+	if (m_cubemaps[0]) {
+		state.forget_texture(m_cubemaps[0]);
+		state.forget_texture(m_cubemaps[1]);
+		glDeleteTextures(2, m_cubemaps);
+		m_cubemaps[0] = 0;
+		m_cubemaps[1] = 0;
+	}
+	m_capturing = false;
+	m_hasCapture = false;
+	m_nextFace = 0;
+}
+
+void FarField::update(const glm::vec3& cameraPosition, const EngineConfig& cfg) {
+	m_facesRendered = 0;
+	if (!is_valid()) {
+		return;
+	}
+
+	glm::vec3 offset = cameraPosition - m_capturePosition;
+	float updateDistanceSq = cfg.m_farFieldUpdateDistance * cfg.m_farFieldUpdateDistance;
+	if (!m_capturing && (!m_hasCapture || glm::dot(offset, offset) > updateDistanceSq)) {
+		// the whole capture is taken from where it started, later camera motion waits for the next one
+		m_capturing = true;
+		m_pendingPosition = cameraPosition;
+		m_nextFace = 0;
+	}
+	if (!m_capturing) {
+		return;
+	}
+
+	uint32_t faceBudget = m_hasCapture ? std::max(cfg.m_farFieldFacesPerFrame, 1u) : CUBE_FACES;
+	// the fullscreen triangle has no depth attachment to test against and no facing worth culling
+	GLStateCache& state = GLStateCache::get();
+	state.bind_framebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	state.set_viewport(0, 0, m_resolution, m_resolution);
+	state.set_enabled(GL_DEPTH_TEST, false);
+	state.set_enabled(GL_CULL_FACE, false);
+	state.set_enabled(GL_BLEND, false);
+	state.set_color_mask(true);
+	m_captureProgram.bind();
+	state.bind_vertex_array(m_vertexArray);
+	while (m_facesRendered < faceBudget && m_nextFace < CUBE_FACES) {
+		render_face(m_nextFace, cfg);
+		m_nextFace++;
+		m_facesRendered++;
+	}
+	state.bind_framebuffer(GL_FRAMEBUFFER, 0);
+	state.set_viewport(0, 0, cfg.m_screenWidth, cfg.m_screenHeight);
+
+	if (m_nextFace == CUBE_FACES) {
+		m_front ^= 1;
+		m_capturePosition = m_pendingPosition;
+		m_capturing = false;
+		m_hasCapture = true;
+		m_captureCount++;
+		UF_LOG_TRACE("far field capture {} done at ({:.1f}, {:.1f}, {:.1f})",
+			m_captureCount,
+			m_capturePosition.x,
+			m_capturePosition.y,
+			m_capturePosition.z
+		);
+	}
+	CATCH_GL_ERROR("error capturing far field");
+}
+
+void FarField::render_face(uint32_t face, const EngineConfig& cfg) {
+	glNamedFramebufferTextureLayer(m_framebuffer, GL_COLOR_ATTACHMENT0, m_cubemaps[m_front ^ 1], 0, static_cast<GLint>(face));
+	m_captureProgram.set_int(m_captureProgram.get_uniform_location("u_Face"), static_cast<GLint>(face));
+	m_captureProgram.set_vec3(m_captureProgram.get_uniform_location("u_CapturePosition"), m_pendingPosition);
+	m_captureProgram.set_float(m_captureProgram.get_uniform_location("u_NearRadius"), cfg.m_farFieldRadius);
+	m_captureProgram.set_float(m_captureProgram.get_uniform_location("u_FarDistance"), cfg.m_farFieldDistance);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void FarField::composite(const glm::mat4& view, const glm::mat4& projection) {
+	if (!is_valid() || !m_hasCapture) {
+		return;
+	}
+	// a panorama has no position, only the camera's rotation turns clip space into view rays
+	glm::mat4 inverseRays = glm::inverse(projection * glm::mat4(glm::mat3(view)));
+
+	// behind everything, so it neither tests nor writes depth
+	GLStateCache& state = GLStateCache::get();
+	state.set_enabled(GL_DEPTH_TEST, false);
+	state.set_depth_mask(false);
+	state.set_enabled(GL_CULL_FACE, false);
+	state.set_enabled(GL_BLEND, false);
+	state.set_color_mask(true);
+	m_compositeProgram.bind();
+	m_compositeProgram.set_mat4(m_compositeProgram.get_uniform_location("u_InverseViewRays"), inverseRays);
+	state.bind_texture_unit(0, m_cubemaps[m_front]);
+	state.bind_vertex_array(m_vertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
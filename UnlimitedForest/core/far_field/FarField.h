@@ -0,0 +1,60 @@
+#pragma once
+
+#include <application/EngineConfig.h>
+#include <shader/ShaderProgram.h>
+
+#include <cstdint>
+#include <string>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// horizon ring of the unlimited forest: everything past the near scene's radius is a cubemap panorama
+// (procedural terrain + canopy) captured around the camera, so the far field costs one fullscreen pass
+// a capture is only started once the camera moved far enough from the last one and is spread over
+// several frames into a back cubemap, the front one keeps being composited until it is complete
+class FarField {
+public:
+	static constexpr uint32_t CUBE_FACES = 6;
+
+	FarField();
+	~FarField();
+
+	FarField(const FarField&) = delete;
+	FarField& operator=(const FarField&) = delete;
+
+	// compiles both programs and allocates the cubemaps, returns false (and logs why) on failure
+	bool create(const std::string& vertexPath, const std::string& captureFragmentPath, const std::string& compositeFragmentPath, int resolution);
+	void destroy(void);
+	bool is_valid(void) const { return m_framebuffer != 0; }
+
+	// renders this frame's share of a capture, the very first capture is done in one go so there is
+	// never a frame without a panorama, leaves the default framebuffer bound with its viewport restored
+	void update(const glm::vec3& cameraPosition, const EngineConfig& cfg);
+	// fullscreen pass of the front panorama, meant to go first with depth testing off so the scene covers it
+	void composite(const glm::mat4& view, const glm::mat4& projection);
+
+	// faces rendered by the last update, 0 on frames without a capture in flight
+	uint32_t get_faces_rendered(void) const { return m_facesRendered; }
+	uint64_t get_capture_count(void) const { return m_captureCount; }
+
+private:
+	void render_face(uint32_t face, const EngineConfig& cfg);
+
+	ShaderProgram m_captureProgram;
+	ShaderProgram m_compositeProgram;
+	// the fullscreen triangle comes from gl_VertexID but core profile still wants a vao bound
+	GLuint m_vertexArray;
+	GLuint m_framebuffer;
+	// front is composited, back is being captured into
+	GLuint m_cubemaps[2];
+	uint32_t m_front;
+	int m_resolution;
+
+	glm::vec3 m_capturePosition;
+	glm::vec3 m_pendingPosition;
+	uint32_t m_nextFace;
+	bool m_capturing;
+	bool m_hasCapture;
+	uint32_t m_facesRendered;
+	uint64_t m_captureCount;
+};
@@ -0,0 +1,287 @@
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+GLStateCache& GLStateCache::get() {
+	static GLStateCache cache;
+	return cache;
+}
+
+GLStateCache::GLStateCache() {
+	reset();
+}
+
+void GLStateCache::reset() {
+	m_program = UNKNOWN;
+	m_vertexArray = UNKNOWN;
+	std::fill(std::begin(m_buffers), std::end(m_buffers), UNKNOWN);
+	std::fill(std::begin(m_uniformBindings), std::end(m_uniformBindings), UNKNOWN);
+	std::fill(std::begin(m_storageBindings), std::end(m_storageBindings), UNKNOWN);
+	std::fill(std::begin(m_textures), std::end(m_textures), UNKNOWN);
+	std::fill(std::begin(m_images), std::end(m_images), ImageBinding{ UNKNOWN, 0, 0, 0 });
+	m_drawFramebuffer = UNKNOWN;
+	m_readFramebuffer = UNKNOWN;
+	std::fill(std::begin(m_capabilities), std::end(m_capabilities), UNKNOWN);
+	m_depthFunc = UNKNOWN;
+	m_depthMask = UNKNOWN;
+	m_cullFace = UNKNOWN;
+	m_frontFace = UNKNOWN;
+	m_blendSource = UNKNOWN;
+	m_blendDestination = UNKNOWN;
+	m_colorMask = UNKNOWN;
+	m_viewportKnown = false;
+	m_clearColorKnown = false;
+}
+
+void GLStateCache::begin_frame() {
+	m_lastFrameStats = m_frameStats;
+	m_frameStats = GLStateStats();
+}
+
+template<typename T>
+bool GLStateCache::unchanged(T& cached, const T& value) {
+	if (cached == value) {
+		m_frameStats.m_filtered++;
+		return true;
+	}
+	cached = value;
+	m_frameStats.m_issued++;
+	return false;
+}
+
+int GLStateCache::buffer_target_slot(GLenum target) {
+	switch (target) {
+		case GL_ARRAY_BUFFER: return 0;
+		case GL_UNIFORM_BUFFER: return 1;
+		case GL_SHADER_STORAGE_BUFFER: return 2;
+		case GL_DRAW_INDIRECT_BUFFER: return 3;
+		case GL_DISPATCH_INDIRECT_BUFFER: return 4;
+		case GL_COPY_READ_BUFFER: return 5;
+		case GL_COPY_WRITE_BUFFER: return 6;
+		case GL_PIXEL_PACK_BUFFER: return 7;
+		case GL_PIXEL_UNPACK_BUFFER: return 8;
+		default: return -1;
+	}
+}
+
+int GLStateCache::capability_slot(GLenum capability) {
+	switch (capability) {
+		case GL_DEPTH_TEST: return 0;
+		case GL_CULL_FACE: return 1;
+		case GL_BLEND: return 2;
+		case GL_SCISSOR_TEST: return 3;
+		default: return -1;
+	}
+}
+
+void GLStateCache::use_program(GLuint program) {
+	if (!unchanged(m_program, program)) {
+		glUseProgram(program);
+	}
+}
+
+void GLStateCache::bind_vertex_array(GLuint vertexArray) {
+	if (!unchanged(m_vertexArray, vertexArray)) {
+		glBindVertexArray(vertexArray);
+	}
+}
+
+void GLStateCache::bind_buffer(GLenum target, GLuint buffer) {
+	int slot = buffer_target_slot(target);
+	if (slot < 0) {
+		m_frameStats.m_issued++;
+		glBindBuffer(target, buffer);
+		return;
+	}
+	if (!unchanged(m_buffers[slot], buffer)) {
+		glBindBuffer(target, buffer);
+	}
+}
+
+void GLStateCache::bind_buffer_base(GLenum target, GLuint index, GLuint buffer) {
+	GLuint* bindings = target == GL_UNIFORM_BUFFER ? m_uniformBindings : target == GL_SHADER_STORAGE_BUFFER ? m_storageBindings : nullptr;
+	int slot = buffer_target_slot(target);
+	if (bindings == nullptr || index >= MAX_INDEXED_BINDINGS) {
+		m_frameStats.m_issued++;
+		glBindBufferBase(target, index, buffer);
+		if (slot >= 0) {
+			m_buffers[slot] = buffer;
+		}
+		return;
+	}
+	if (!unchanged(bindings[index], buffer)) {
+		glBindBufferBase(target, index, buffer);
+		m_buffers[slot] = buffer;
+	}
+}
+
+void GLStateCache::bind_texture_unit(GLuint unit, GLuint texture) {
+	if (unit >= MAX_TEXTURE_UNITS) {
+		m_frameStats.m_issued++;
+		glBindTextureUnit(unit, texture);
+		return;
+	}
+	if (!unchanged(m_textures[unit], texture)) {
+		glBindTextureUnit(unit, texture);
+	}
+}
+
+void GLStateCache::bind_image_texture(GLuint unit, GLuint texture, GLint level, GLenum access, GLenum format) {
+	if (unit >= MAX_IMAGE_UNITS) {
+		m_frameStats.m_issued++;
+		glBindImageTexture(unit, texture, level, GL_FALSE, 0, access, format);
+		return;
+	}
+	if (!unchanged(m_images[unit], ImageBinding{ texture, level, access, format })) {
+		glBindImageTexture(unit, texture, level, GL_FALSE, 0, access, format);
+	}
+}
+
+void GLStateCache::bind_framebuffer(GLenum target, GLuint framebuffer) {
+	if (target == GL_FRAMEBUFFER) {
+		if (m_drawFramebuffer == framebuffer && m_readFramebuffer == framebuffer) {
+			m_frameStats.m_filtered++;
+			return;
+		}
+		m_drawFramebuffer = framebuffer;
+		m_readFramebuffer = framebuffer;
+		m_frameStats.m_issued++;
+		glBindFramebuffer(target, framebuffer);
+		return;
+	}
+	if (!unchanged(target == GL_DRAW_FRAMEBUFFER ? m_drawFramebuffer : m_readFramebuffer, framebuffer)) {
+		glBindFramebuffer(target, framebuffer);
+	}
+}
+
+void GLStateCache::set_enabled(GLenum capability, bool enabled) {
+	int slot = capability_slot(capability);
+	if (slot >= 0 && unchanged(m_capabilities[slot], static_cast<GLuint>(enabled))) {
+		return;
+	}
+	if (slot < 0) {
+		m_frameStats.m_issued++;
+	}
+	if (enabled) {
+		glEnable(capability);
+	}
+	else {
+		glDisable(capability);
+	}
+}
+
+void GLStateCache::set_depth_func(GLenum func) {
+	if (!unchanged(m_depthFunc, func)) {
+		glDepthFunc(func);
+	}
+}
+
+void GLStateCache::set_depth_mask(bool write) {
+	if (!unchanged(m_depthMask, static_cast<GLuint>(write))) {
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+	}
+}
+
+void GLStateCache::set_cull_face(GLenum face) {
+	if (!unchanged(m_cullFace, face)) {
+		glCullFace(face);
+	}
+}
+
+void GLStateCache::set_front_face(GLenum mode) {
+	if (!unchanged(m_frontFace, mode)) {
+		glFrontFace(mode);
+	}
+}
+
+void GLStateCache::set_blend_func(GLenum source, GLenum destination) {
+	if (m_blendSource == source && m_blendDestination == destination) {
+		m_frameStats.m_filtered++;
+		return;
+	}
+	m_blendSource = source;
+	m_blendDestination = destination;
+	m_frameStats.m_issued++;
+	glBlendFunc(source, destination);
+}
+
+void GLStateCache::set_color_mask(bool write) {
+	if (!unchanged(m_colorMask, static_cast<GLuint>(write))) {
+		GLboolean mask = write ? GL_TRUE : GL_FALSE;
+		glColorMask(mask, mask, mask, mask);
+	}
+}
+
+void GLStateCache::set_viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+	GLint viewport[4] = { x, y, width, height };
+	if (m_viewportKnown && std::memcmp(m_viewport, viewport, sizeof(viewport)) == 0) {
+		m_frameStats.m_filtered++;
+		return;
+	}
+	std::memcpy(m_viewport, viewport, sizeof(viewport));
+	m_viewportKnown = true;
+	m_frameStats.m_issued++;
+	glViewport(x, y, width, height);
+}
+
+void GLStateCache::set_clear_color(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+	GLfloat color[4] = { r, g, b, a };
+	if (m_clearColorKnown && std::memcmp(m_clearColor, color, sizeof(color)) == 0) {
+		m_frameStats.m_filtered++;
+		return;
+	}
+	std::memcpy(m_clearColor, color, sizeof(color));
+	m_clearColorKnown = true;
+	m_frameStats.m_issued++;
+	glClearColor(r, g, b, a);
+}
+
+// a deleted name that is still cached would filter the first bind of whatever object reuses it,
+// those entries go back to unknown instead of guessing what gl reverted them to
+
+void GLStateCache::forget_program(GLuint program) {
+	if (program != 0 && m_program == program) {
+		m_program = UNKNOWN;
+	}
+}
+
+void GLStateCache::forget_vertex_array(GLuint vertexArray) {
+	if (vertexArray != 0 && m_vertexArray == vertexArray) {
+		m_vertexArray = UNKNOWN;
+	}
+}
+
+void GLStateCache::forget_buffer(GLuint buffer) {
+	if (buffer == 0) {
+		return;
+	}
+	std::replace(std::begin(m_buffers), std::end(m_buffers), buffer, UNKNOWN);
+	std::replace(std::begin(m_uniformBindings), std::end(m_uniformBindings), buffer, UNKNOWN);
+	std::replace(std::begin(m_storageBindings), std::end(m_storageBindings), buffer, UNKNOWN);
+}
+
+void GLStateCache::forget_texture(GLuint texture) {
+	if (texture == 0) {
+		return;
+	}
+	std::replace(std::begin(m_textures), std::end(m_textures), texture, UNKNOWN);
+	for (ImageBinding& image : m_images) {
+		if (image.m_texture == texture) {
+			image.m_texture = UNKNOWN;
+		}
+	}
+}
+
+void GLStateCache::forget_framebuffer(GLuint framebuffer) {
+	if (framebuffer == 0) {
+		return;
+	}
+	if (m_drawFramebuffer == framebuffer) {
+		m_drawFramebuffer = UNKNOWN;
+	}
+	if (m_readFramebuffer == framebuffer) {
+		m_readFramebuffer = UNKNOWN;
+	}
+}
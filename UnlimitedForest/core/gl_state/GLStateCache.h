@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+
+// binds and state changes the cache passed on to gl versus dropped because they changed nothing
+struct GLStateStats {
+	uint32_t m_issued = 0;
+	uint32_t m_filtered = 0;
+};
+
+// shadow of the gl context's binding and fixed function state, every engine bind / state change goes
+// through here and is only forwarded when it differs from what the context already has
+// state the cache has not seen set is unknown and never filtered, so foreign code only costs a reset()
+// deleting a tracked object has to be reported (forget_*), gl hands its name out again
+class GLStateCache {
+public:
+	static constexpr uint32_t MAX_TEXTURE_UNITS = 16;
+	static constexpr uint32_t MAX_IMAGE_UNITS = 8;
+	// indexed uniform / shader storage binding points tracked, higher ones are always forwarded
+	static constexpr uint32_t MAX_INDEXED_BINDINGS = 16;
+
+	// the engine renders through a single context, so there is a single cache
+	static GLStateCache& get(void);
+
+	// everything back to unknown, after a context was made current or state was changed behind the cache
+	void reset(void);
+	// per frame counters start over, the finished frame's stay readable through get_last_frame_stats()
+	void begin_frame(void);
+
+	void use_program(GLuint program);
+	void bind_vertex_array(GLuint vertexArray);
+	// element array bindings belong to the vertex array and are set through it, they are forwarded untracked
+	void bind_buffer(GLenum target, GLuint buffer);
+	// also moves the target's generic binding, like gl does
+	void bind_buffer_base(GLenum target, GLuint index, GLuint buffer);
+	void bind_texture_unit(GLuint unit, GLuint texture);
+	void bind_image_texture(GLuint unit, GLuint texture, GLint level, GLenum access, GLenum format);
+	// GL_FRAMEBUFFER binds both the draw and the read framebuffer
+	void bind_framebuffer(GLenum target, GLuint framebuffer);
+
+	// depth test, face culling, blending, scissor test, other capabilities are forwarded untracked
+	void set_enabled(GLenum capability, bool enabled);
+	void set_depth_func(GLenum func);
+	void set_depth_mask(bool write);
+	void set_cull_face(GLenum face);
+	void set_front_face(GLenum mode);
+	void set_blend_func(GLenum source, GLenum destination);
+	void set_color_mask(bool write);
+	void set_viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+	void set_clear_color(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+
+	void forget_program(GLuint program);
+	void forget_vertex_array(GLuint vertexArray);
+	void forget_buffer(GLuint buffer);
+	void forget_texture(GLuint texture);
+	void forget_framebuffer(GLuint framebuffer);
+
+	const GLStateStats& get_frame_stats(void) const { return m_frameStats; }
+	const GLStateStats& get_last_frame_stats(void) const { return m_lastFrameStats; }
+
+private:
+	GLStateCache();
+
+	// true (and counted as filtered) if the cached value already matches, otherwise stores it and counts an issue
+	template<typename T>
+	bool unchanged(T& cached, const T& value);
+	static int buffer_target_slot(GLenum target);
+	static int capability_slot(GLenum capability);
+
+	static constexpr GLuint UNKNOWN = 0xFFFFFFFFu;
+	static constexpr uint32_t BUFFER_TARGETS = 9;
+	static constexpr uint32_t CAPABILITIES = 4;
+
+	struct ImageBinding {
+		GLuint m_texture;
+		GLint m_level;
+		GLenum m_access;
+		GLenum m_format;
+		bool operator==(const ImageBinding& other) const {
+			return m_texture == other.m_texture && m_level == other.m_level && m_access == other.m_access && m_format == other.m_format;
+		}
+	};
+
+	GLuint m_program;
+	GLuint m_vertexArray;
+	GLuint m_buffers[BUFFER_TARGETS];
+	GLuint m_uniformBindings[MAX_INDEXED_BINDINGS];
+	GLuint m_storageBindings[MAX_INDEXED_BINDINGS];
+	GLuint m_textures[MAX_TEXTURE_UNITS];
+	ImageBinding m_images[MAX_IMAGE_UNITS];
+	GLuint m_drawFramebuffer;
+	GLuint m_readFramebuffer;
+	// 0 disabled, 1 enabled, UNKNOWN
+	GLuint m_capabilities[CAPABILITIES];
+	GLenum m_depthFunc;
+	GLuint m_depthMask;
+	GLenum m_cullFace;
+	GLenum m_frontFace;
+	GLenum m_blendSource;
+	GLenum m_blendDestination;
+	GLuint m_colorMask;
+	GLint m_viewport[4];
+	GLfloat m_clearColor[4];
+	bool m_viewportKnown;
+	bool m_clearColorKnown;
+
+	GLStateStats m_frameStats;
+	GLStateStats m_lastFrameStats;
+};
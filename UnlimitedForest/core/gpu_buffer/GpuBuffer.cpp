@@ -0,0 +1,103 @@
+#include "GpuBuffer.h"
+#include <log/Log.h>
+#include <log/GLDebug.h>
+#include <gl_state/GLStateCache.h>
+
+GpuBuffer::GpuBuffer() : m_buffer(0), m_target(GL_UNIFORM_BUFFER), m_usage(GL_DYNAMIC_DRAW), m_size(0), m_label(nullptr) {}
+
+GpuBuffer::~GpuBuffer() {
+	destroy();
+}
+
+bool GpuBuffer::create(GLenum target, size_t size, GLenum usage) {
+	destroy();
+	if (size == 0) {
+		UF_LOG_ERROR("can not create an empty gpu buffer");
+		return false;
+	}
+
+	m_target = target;
+	m_usage = usage;
+	m_size = size;
+	glCreateBuffers(1, &m_buffer);
+	glNamedBufferData(m_buffer, static_cast<GLsizeiptr>(m_size), nullptr, m_usage);
+	if (m_label) {
+		UF_GL_LABEL(GL_BUFFER, m_buffer, m_label);
+	}
+	CATCH_GL_ERROR("error creating gpu buffer");
+	return true;
+}
+
+void GpuBuffer::destroy() {
+	if (m_buffer) {
+		GLStateCache::get().forget_buffer(m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+	}
+	m_size = 0;
+}
+
+void GpuBuffer::update(const void* data, size_t size, size_t offset) {
+	if (offset + size > m_size) {
+		UF_LOG_WARN("gpu buffer {} write of {} bytes at {} overflows its {} bytes", m_buffer, size, offset, m_size);
+		return;
+	}
+	glNamedBufferSubData(m_buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+}
+
+void GpuBuffer::reserve(size_t size) {
+	if (size <= m_size) {
+		return;
+	}
+	// grow geometrically so a slowly growing scene does not reallocate every frame
+	size_t newSize = m_size == 0 ? size : m_size;
+	while (newSize < size) {
+		newSize *= 2;
+	}
+	m_size = newSize;
+	if (!m_buffer) {
+		glCreateBuffers(1, &m_buffer);
+		if (m_label) {
+			UF_GL_LABEL(GL_BUFFER, m_buffer, m_label);
+		}
+	}
+	glNamedBufferData(m_buffer, static_cast<GLsizeiptr>(m_size), nullptr, m_usage);
+}
+
+void GpuBuffer::grow_preserving(size_t size, size_t preserveBytes) {
+	if (size <= m_size) {
+		return;
+	}
+	GLuint newBuffer = 0;
+	glCreateBuffers(1, &newBuffer);
+	glNamedBufferData(newBuffer, static_cast<GLsizeiptr>(size), nullptr, m_usage);
+	if (m_buffer && preserveBytes > 0) {
+		// copy stays on the gpu, nothing is read back
+		glCopyNamedBufferSubData(m_buffer, newBuffer, 0, 0, static_cast<GLsizeiptr>(preserveBytes < m_size ? preserveBytes : m_size));
+	}
+	if (m_buffer) {
+		GLStateCache::get().forget_buffer(m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+	}
+	m_buffer = newBuffer;
+	m_size = size;
+	if (m_label) {
+		UF_GL_LABEL(GL_BUFFER, m_buffer, m_label);
+	}
+	CATCH_GL_ERROR("error growing gpu buffer");
+}
+
+void GpuBuffer::bind() const {
+	GLStateCache::get().bind_buffer(m_target, m_buffer);
+}
+
+void GpuBuffer::bind_base(GLuint binding) const {
+	GLStateCache::get().bind_buffer_base(m_target, binding, m_buffer);
+}
+
+void GpuBuffer::set_label(const char* label) {
+	m_label = label;
+	if (m_buffer && m_label) {
+		UF_GL_LABEL(GL_BUFFER, m_buffer, m_label);
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+
+// owns a single gl buffer object of a fixed size, meant for data the cpu rewrites (uniform / storage / indirect buffers)
+// indexed targets (uniform, storage) are attached to a binding point once and stay there for the program's lifetime
+// writes go through direct state access, so only bind() / bind_base() touch the context's bindings
+class GpuBuffer {
+public:
+	GpuBuffer();
+	~GpuBuffer();
+
+	GpuBuffer(const GpuBuffer&) = delete;
+	GpuBuffer& operator=(const GpuBuffer&) = delete;
+
+	// allocates size bytes of storage, returns false (and logs why) on failure
+	bool create(GLenum target, size_t size, GLenum usage = GL_DYNAMIC_DRAW);
+	void destroy(void);
+
+	// overwrites [offset, offset + size), the write is dropped if it does not fit
+	void update(const void* data, size_t size, size_t offset = 0);
+	// grows the storage (dropping its contents) if it is smaller than size
+	void reserve(size_t size);
+	// grows the storage to size keeping the first preserveBytes, the buffer gets a new name so
+	// anything that captured the old one (vao bindings, indexed bindings) has to be re-pointed
+	void grow_preserving(size_t size, size_t preserveBytes);
+
+	void bind(void) const;
+	void bind_base(GLuint binding) const;
+	// debug name for gl messages and capture tools, reapplied whenever the buffer gets a new name,
+	// so it has to outlive the buffer (a literal)
+	void set_label(const char* label);
+
+	GLuint get_id(void) const { return m_buffer; }
+	GLenum get_target(void) const { return m_target; }
+	size_t get_size(void) const { return m_size; }
+	bool is_valid(void) const { return m_buffer != 0; }
+
+private:
+	GLuint m_buffer;
+	GLenum m_target;
+	GLenum m_usage;
+	size_t m_size;
+	const char* m_label;
+};
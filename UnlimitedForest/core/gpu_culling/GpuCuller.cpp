@@ -0,0 +1,187 @@
+#include "GpuCuller.h"
+#include <log/Log.h>
+#include <log/GLDebug.h>
+#include <gl_state/GLStateCache.h>
+#include <renderer/DrawData.h>
+
+#include <algorithm>
+
+namespace {
+	// largest power of two not above value
+	int floor_power_of_two(int value) {
+		int result = 1;
+		while (result * 2 <= value) {
+			result *= 2;
+		}
+		return result;
+	}
+}
+
+GpuCuller::GpuCuller()
+	: m_pyramid(0),
+	m_pyramidWidth(0),
+	m_pyramidHeight(0),
+	m_pyramidLevels(0),
+	m_pyramidViewProjection(1.0f),
+	m_pyramidValid(false),
+	m_readbackFences{},
+	m_readbackIdx(0),
+	m_visibleCount(0)
+{}
+
+GpuCuller::~GpuCuller() {
+	destroy();
+}
+
+bool GpuCuller::create(const std::string& cullShaderPath, const std::string& pyramidShaderPath) {
+	destroy();
+	if (!m_cullProgram.create_compute_from_file(cullShaderPath) || !m_pyramidProgram.create_compute_from_file(pyramidShaderPath)) {
+		UF_LOG_ERROR("failed to build the gpu culling programs");
+		destroy();
+		return false;
+	}
+	if (!m_counter.create(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t))) {
+		destroy();
+		return false;
+	}
+	m_counter.set_label("cull visible counter");
+	for (GpuBuffer& readback : m_readbacks) {
+		if (!readback.create(GL_COPY_WRITE_BUFFER, sizeof(uint32_t), GL_STREAM_READ)) {
+			destroy();
+			return false;
+		}
+		readback.set_label("cull counter readback");
+	}
+	return true;
+}
+
+void GpuCuller::destroy() {
+	m_cullProgram.destroy();
+	m_pyramidProgram.destroy();
+	if (m_pyramid) {
+		GLStateCache::get().forget_texture(m_pyramid);
+		glDeleteTextures(1, &m_pyramid);
+		m_pyramid = 0;
+	}
+	m_pyramidWidth = 0;
+	m_pyramidHeight = 0;
+	m_pyramidLevels = 0;
+	m_pyramidValid = false;
+	m_counter.destroy();
+	for (uint32_t i = 0; i < READBACK_FRAMES; i++) {
+		m_readbacks[i].destroy();
+		if (m_readbackFences[i]) {
+			glDeleteSync(m_readbackFences[i]);
+			m_readbackFences[i] = nullptr;
+		}
+	}
+	m_visibleCount = 0;
+}
+
+void GpuCuller::cull(DrawBuffers& buffers, uint32_t instanceCount, const Frustum& frustum) {
+	if (!is_valid() || instanceCount == 0) {
+		return;
+	}
+	read_back_visible_count();
+
+	uint32_t zero = 0;
+	m_counter.update(&zero, sizeof(zero));
+
+	buffers.m_culledInstances.bind_base(INSTANCE_BUFFER_BINDING);
+	buffers.m_instances.bind_base(CULL_SOURCE_INSTANCE_BINDING);
+	buffers.m_cullData.bind_base(CULL_DATA_BINDING);
+	// the indirect commands are written as storage, the shader bumps their instance counts
+	GLStateCache& state = GLStateCache::get();
+	state.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, CULL_COMMAND_BINDING, buffers.m_indirect.get_id());
+	m_counter.bind_base(CULL_COUNTER_BINDING);
+
+	m_cullProgram.bind();
+	// explicit location in the shader, so the plane array's locations are consecutive
+	GLint planesLocation = m_cullProgram.get_uniform_location("u_Planes");
+	for (int plane = 0; plane < Frustum::PLANE_COUNT; plane++) {
+		m_cullProgram.set_vec4(planesLocation + plane, frustum.get_plane(static_cast<Frustum::Plane>(plane)));
+	}
+	m_cullProgram.set_int(m_cullProgram.get_uniform_location("u_InstanceCount"), static_cast<GLint>(instanceCount));
+	m_cullProgram.set_int(m_cullProgram.get_uniform_location("u_OcclusionCulling"), m_pyramidValid ? 1 : 0);
+	if (m_pyramidValid) {
+		m_cullProgram.set_mat4(m_cullProgram.get_uniform_location("u_PyramidViewProjection"), m_pyramidViewProjection);
+		m_cullProgram.set_int(m_cullProgram.get_uniform_location("u_PyramidLevels"), m_pyramidLevels);
+		state.bind_texture_unit(0, m_pyramid);
+	}
+
+	glDispatchCompute((instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+	// the draw reads the counts as indirect commands and the instances as storage
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	// keep the count on the gpu side, it is picked up frames later once the fence has passed
+	GpuBuffer& readback = m_readbacks[m_readbackIdx];
+	glCopyNamedBufferSubData(m_counter.get_id(), readback.get_id(), 0, 0, sizeof(uint32_t));
+	if (m_readbackFences[m_readbackIdx]) {
+		glDeleteSync(m_readbackFences[m_readbackIdx]);
+	}
+	m_readbackFences[m_readbackIdx] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_readbackIdx = (m_readbackIdx + 1) % READBACK_FRAMES;
+	CATCH_GL_ERROR("error culling on the gpu");
+}
+
+void GpuCuller::read_back_visible_count() {
+	// oldest pending copy first, the slot about to be reused
+	GLsync& fence = m_readbackFences[m_readbackIdx];
+	if (!fence) {
+		return;
+	}
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+		return;
+	}
+	glGetNamedBufferSubData(m_readbacks[m_readbackIdx].get_id(), 0, sizeof(uint32_t), &m_visibleCount);
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void GpuCuller::build_depth_pyramid(GLuint depthTexture, int width, int height, const glm::mat4& viewProjection) {
+	if (!is_valid() || depthTexture == 0 || width <= 0 || height <= 0) {
+		return;
+	}
+
+	int pyramidWidth = floor_power_of_two(width);
+	int pyramidHeight = floor_power_of_two(height);
+	if (pyramidWidth != m_pyramidWidth || pyramidHeight != m_pyramidHeight) {
+		if (m_pyramid) {
+			GLStateCache::get().forget_texture(m_pyramid);
+			glDeleteTextures(1, &m_pyramid);
+		}
+		m_pyramidWidth = pyramidWidth;
+		m_pyramidHeight = pyramidHeight;
+		m_pyramidLevels = 1;
+		for (int size = std::max(pyramidWidth, pyramidHeight); size > 1; size /= 2) {
+			m_pyramidLevels++;
+		}
+		glCreateTextures(GL_TEXTURE_2D, 1, &m_pyramid);
+		UF_GL_LABEL(GL_TEXTURE, m_pyramid, "depth pyramid");
+		glTextureStorage2D(m_pyramid, m_pyramidLevels, GL_R32F, m_pyramidWidth, m_pyramidHeight);
+		glTextureParameteri(m_pyramid, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTextureParameteri(m_pyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTextureParameteri(m_pyramid, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(m_pyramid, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	GLStateCache& state = GLStateCache::get();
+	m_pyramidProgram.bind();
+	GLint sourceLevelLocation = m_pyramidProgram.get_uniform_location("u_SourceLevel");
+	int levelWidth = m_pyramidWidth;
+	int levelHeight = m_pyramidHeight;
+	for (int level = 0; level < m_pyramidLevels; level++) {
+		// level 0 reduces the depth buffer itself, every other level the one above it
+		state.bind_texture_unit(0, level == 0 ? depthTexture : m_pyramid);
+		m_pyramidProgram.set_int(sourceLevelLocation, level == 0 ? 0 : level - 1);
+		state.bind_image_texture(0, m_pyramid, level, GL_WRITE_ONLY, GL_R32F);
+		glDispatchCompute((levelWidth + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE, (levelHeight + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		levelWidth = std::max(levelWidth / 2, 1);
+		levelHeight = std::max(levelHeight / 2, 1);
+	}
+	m_pyramidViewProjection = viewProjection;
+	m_pyramidValid = true;
+	CATCH_GL_ERROR("error building the depth pyramid");
+}
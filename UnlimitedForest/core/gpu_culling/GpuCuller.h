@@ -0,0 +1,66 @@
+#pragma once
+
+#include <culling/Frustum.h>
+#include <gpu_buffer/GpuBuffer.h>
+#include <render_queue/RenderQueue.h>
+#include <shader/ShaderProgram.h>
+
+#include <cstdint>
+#include <string>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// culls the uploaded instances in a compute pass so the cpu never touches per-instance visibility:
+// frustum planes first, then a hi-z test against the depth pyramid built from last frame's depth
+// visible instances are compacted into the culled instance stream and counted into the indirect commands
+// the occlusion test is a single pass against the previous frame: something that was hidden there and comes
+// into view (the camera turning or an occluder moving away) stays culled for that one frame
+// the queue is still built, sorted and uploaded on the cpu (a 96 byte InstanceData and a 32 byte cull record per
+// instance), this only moves the visibility tests
+class GpuCuller {
+public:
+	GpuCuller();
+	~GpuCuller();
+
+	GpuCuller(const GpuCuller&) = delete;
+	GpuCuller& operator=(const GpuCuller&) = delete;
+
+	// compiles both compute programs, returns false (and logs why) on failure
+	bool create(const std::string& cullShaderPath, const std::string& pyramidShaderPath);
+	void destroy(void);
+	bool is_valid(void) const { return m_cullProgram.is_valid() && m_pyramidProgram.is_valid(); }
+
+	// expects the queue's upload with cull spheres, leaves the results ready for the indirect draw
+	void cull(DrawBuffers& buffers, uint32_t instanceCount, const Frustum& frustum);
+	// max-reduces the scene depth into the mip chain next frame's cull tests against
+	void build_depth_pyramid(GLuint depthTexture, int width, int height, const glm::mat4& viewProjection);
+
+	// visible instance count of the newest cull that finished on the gpu, a couple of frames behind
+	uint32_t get_visible_count(void) const { return m_visibleCount; }
+
+private:
+	// picks up finished counts without ever waiting on the gpu
+	void read_back_visible_count(void);
+
+	static constexpr uint32_t CULL_GROUP_SIZE = 64;
+	static constexpr uint32_t PYRAMID_GROUP_SIZE = 8;
+	static constexpr uint32_t READBACK_FRAMES = 3;
+
+	ShaderProgram m_cullProgram;
+	ShaderProgram m_pyramidProgram;
+
+	// r32f mip chain, level 0 is the largest power of two that fits in the depth buffer
+	GLuint m_pyramid;
+	int m_pyramidWidth;
+	int m_pyramidHeight;
+	int m_pyramidLevels;
+	// the pyramid is only meaningful in the view it was rendered from
+	glm::mat4 m_pyramidViewProjection;
+	bool m_pyramidValid;
+
+	GpuBuffer m_counter;
+	GpuBuffer m_readbacks[READBACK_FRAMES];
+	GLsync m_readbackFences[READBACK_FRAMES];
+	uint32_t m_readbackIdx;
+	uint32_t m_visibleCount;
+};
@@ -0,0 +1,242 @@
+#include "ImpostorBaker.h"
+#include <application/App.h>
+#include <application/EngineConfig.h>
+#include <gl_state/GLStateCache.h>
+#include <log/Log.h>
+#include <log/GLDebug.h>
+#include <mesh_manager/DemoMeshes.h>
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <SDL2/SDL.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+	// looking straight down the up vector can not also be the camera's up, the top frame uses -z instead
+	// must match impostor.vert
+	glm::vec3 frame_up(const glm::vec3& direction) {
+		return direction.y > 0.999f ? glm::vec3(0.0f, 0.0f, -1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+}
+
+ImpostorBaker::ImpostorBaker() {}
+
+ImpostorBaker::~ImpostorBaker() {
+	destroy();
+}
+
+bool ImpostorBaker::create(const std::string& vertexPath, const std::string& fragmentPath) {
+	if (!m_program.create_from_files(vertexPath, fragmentPath)) {
+		UF_LOG_ERROR("failed to build the impostor bake program");
+		return false;
+	}
+	return true;
+}
+
+void ImpostorBaker::destroy() {
+	m_program.destroy();
+}
+
+glm::vec3 ImpostorBaker::get_frame_direction(uint32_t x, uint32_t y, uint32_t frames) {
+	// hemi-octahedral: the grid square is the octahedron's upper half unfolded and turned 45 degrees,
+	// the center frame looks straight down, the border frames lie on the horizon
+	float u = static_cast<float>(x) / static_cast<float>(frames - 1) * 2.0f - 1.0f;
+	float v = static_cast<float>(y) / static_cast<float>(frames - 1) * 2.0f - 1.0f;
+	float px = (u + v) * 0.5f;
+	float pz = (u - v) * 0.5f;
+	return glm::normalize(glm::vec3(px, 1.0f - std::abs(px) - std::abs(pz), pz));
+}
+
+bool ImpostorBaker::bake(const MeshManager& meshManager, const MeshId& meshId, uint32_t frames, int frameSize, Impostor& impostor) {
+	const Mesh* mesh = meshManager.get_mesh(meshId);
+	if (mesh == nullptr) {
+		UF_LOG_ERROR("can not bake an impostor of unknown mesh: {}", meshId.m_value);
+		return false;
+	}
+	if (!is_valid() || frames < 2 || frameSize <= 0) {
+		UF_LOG_ERROR("can not bake a {}x{} impostor with {} pixel frames", frames, frames, frameSize);
+		return false;
+	}
+	float radius = glm::length(mesh->m_boundsMax - mesh->m_boundsMin) * 0.5f;
+	if (radius <= 0.0f) {
+		UF_LOG_ERROR("mesh {} has empty bounds, nothing to bake", meshId.m_value);
+		return false;
+	}
+	int atlasSize = static_cast<int>(frames) * frameSize;
+	// normals and depth get half floats, 8 bits of depth would band the depth the billboards write
+	const GLenum atlasFormats[2] = { GL_RGBA8, GL_RGBA16F };
+	if (!impostor.m_atlas.create(atlasSize, atlasSize, atlasFormats, 2)) {
+		return false;
+	}
+	impostor.m_frames = frames;
+	impostor.m_frameSize = frameSize;
+	impostor.m_center = (mesh->m_boundsMin + mesh->m_boundsMax) * 0.5f;
+	impostor.m_radius = radius;
+
+	auto bakeStart = std::chrono::steady_clock::now();
+	// named clears still honour the write masks
+	GLStateCache& state = GLStateCache::get();
+	state.set_depth_mask(true);
+	state.set_color_mask(true);
+	GLuint framebuffer = impostor.m_atlas.get_framebuffer();
+	const GLfloat clearAlbedo[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLfloat clearNormalDepth[4] = { 0.5f, 0.5f, 1.0f, 1.0f };
+	const GLfloat clearDepth = 1.0f;
+	glClearNamedFramebufferfv(framebuffer, GL_COLOR, 0, clearAlbedo);
+	glClearNamedFramebufferfv(framebuffer, GL_COLOR, 1, clearNormalDepth);
+	glClearNamedFramebufferfv(framebuffer, GL_DEPTH, 0, &clearDepth);
+
+	UF_GL_DEBUG_GROUP("impostor bake");
+	impostor.m_atlas.set_label("impostor atlas");
+	impostor.m_atlas.bind();
+	state.set_enabled(GL_DEPTH_TEST, true);
+	state.set_depth_func(GL_LESS);
+	state.set_enabled(GL_CULL_FACE, false);
+	state.set_enabled(GL_BLEND, false);
+	m_program.bind();
+	state.bind_vertex_array(meshManager.get_vertex_array());
+	GLint viewProjectionLocation = m_program.get_uniform_location("u_FrameViewProjection");
+	GLint directionLocation = m_program.get_uniform_location("u_FrameDirection");
+	m_program.set_int(m_program.get_uniform_location("u_Mesh"), static_cast<GLint>(meshId.index()));
+
+	// orthographic box around the bounding sphere, depth runs from its near side (0) to its far side (1)
+	glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius);
+	const MeshLod& lod = mesh->m_lods[0];
+	for (uint32_t y = 0; y < frames; y++) {
+		for (uint32_t x = 0; x < frames; x++) {
+			glm::vec3 direction = get_frame_direction(x, y, frames);
+			glm::mat4 view = glm::lookAt(impostor.m_center + direction * radius, impostor.m_center, frame_up(direction));
+			m_program.set_mat4(viewProjectionLocation, projection * view);
+			m_program.set_vec3(directionLocation, direction);
+			state.set_viewport(static_cast<GLint>(x) * frameSize, static_cast<GLint>(y) * frameSize, frameSize, frameSize);
+			glDrawElementsBaseVertex(GL_TRIANGLES,
+				lod.m_indexCount,
+				meshManager.get_index_type(),
+				reinterpret_cast<const void*>(static_cast<size_t>(lod.m_firstIndex) * meshManager.get_index_size()),
+				static_cast<GLint>(lod.m_baseVertex)
+			);
+		}
+	}
+
+	state.bind_framebuffer(GL_FRAMEBUFFER, 0);
+	CATCH_GL_ERROR("error baking impostor");
+	UF_LOG_INFO("baked impostor of mesh {}: {}x{} frames of {} px in {:.2f} ms",
+		meshId.m_value,
+		frames,
+		frames,
+		frameSize,
+		std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - bakeStart).count()
+	);
+	return true;
+}
+
+bool ImpostorBaker::run_from_args(int argc, char* argv[]) {
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--bake-impostors") {
+			std::string outputDirectory = i + 1 < argc ? argv[i + 1] : "impostors";
+			if (!bake_offline(outputDirectory)) {
+				UF_LOG_ERROR("offline impostor bake failed");
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ImpostorBaker::bake_offline(const std::string& outputDirectory) {
+	if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+		UF_LOG_ERROR("failed to initialize sdl: {}", SDL_GetError());
+		return false;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+#if UF_GL_DEBUG
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+#endif
+
+	// the window only exists to own the context, it is never shown and nothing is drawn to it
+	SDL_Window* window = SDL_CreateWindow("Unlimited Forest impostor bake", 0, 0, 1, 1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	SDL_GLContext context = window ? SDL_GL_CreateContext(window) : nullptr;
+	if (window && !context) {
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+		context = SDL_GL_CreateContext(window);
+	}
+	if (!context || !gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
+		UF_LOG_ERROR("failed to create a hidden gl context: {}", SDL_GetError());
+		if (context) {
+			SDL_GL_DeleteContext(context);
+		}
+		if (window) {
+			SDL_DestroyWindow(window);
+		}
+		SDL_Quit();
+		return false;
+	}
+	GLStateCache::get().reset();
+#if UF_GL_DEBUG
+	GLDebug::init();
+#endif
+
+	bool success = false;
+	{
+		// scoped so every gl object is gone before the context is
+		EngineConfig cfg;
+		MeshManager meshManager;
+		ImpostorBaker baker;
+		Impostor impostor;
+		std::vector<GLfloat> vertexData;
+		std::vector<GLuint> indices;
+		build_demo_tree(vertexData, indices);
+		MeshId tree = meshManager.create_mesh(DEMO_TREE_ASSET, vertexData, indices);
+
+		std::error_code error;
+		std::filesystem::create_directories(outputDirectory, error);
+		std::filesystem::path outputPath(outputDirectory);
+		int atlasSize = static_cast<int>(cfg.m_impostorFrames) * cfg.m_impostorFrameSize;
+		success = tree.is_valid()
+			&& baker.create(make_absolute_path("shaders", "impostor_bake.vert"), make_absolute_path("shaders", "impostor_bake.frag"))
+			&& baker.bake(meshManager, tree, cfg.m_impostorFrames, cfg.m_impostorFrameSize, impostor)
+			&& write_tga((outputPath / "demo_tree_albedo.tga").string(), impostor.m_atlas.get_color_texture(0), atlasSize, atlasSize)
+			&& write_tga((outputPath / "demo_tree_normal_depth.tga").string(), impostor.m_atlas.get_color_texture(1), atlasSize, atlasSize);
+		if (success) {
+			UF_LOG_INFO("impostor atlases written to {}", outputPath.string());
+		}
+
+		impostor.m_atlas.destroy();
+		baker.destroy();
+		meshManager.clear();
+	}
+
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return success;
+}
+
+bool ImpostorBaker::write_tga(const std::string& path, GLuint texture, int width, int height) {
+	std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+	glGetTextureImage(texture, 0, GL_BGRA, GL_UNSIGNED_BYTE, static_cast<GLsizei>(pixels.size()), pixels.data());
+
+	// type 2 is uncompressed true color, descriptor 8 alpha bits with the origin at the bottom left
+	uint8_t header[18] = {};
+	header[2] = 2;
+	header[12] = static_cast<uint8_t>(width & 0xFF);
+	header[13] = static_cast<uint8_t>(width >> 8);
+	header[14] = static_cast<uint8_t>(height & 0xFF);
+	header[15] = static_cast<uint8_t>(height >> 8);
+	header[16] = 32;
+	header[17] = 8;
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		UF_LOG_ERROR("can not open {} for writing", path);
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+	return static_cast<bool>(file);
+}
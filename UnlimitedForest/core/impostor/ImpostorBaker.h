@@ -0,0 +1,52 @@
+#pragma once
+
+#include <mesh_manager/MeshManager.h>
+#include <render_target/RenderTarget.h>
+#include <shader/ShaderProgram.h>
+
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+
+// a mesh pre-rendered from a hemi-octahedral grid of directions around its bounding sphere,
+// frame (x, y) of the grid sits at tile (x, y) of the atlas, see ImpostorBaker.cpp for the mapping
+struct Impostor {
+	// color 0: albedo with coverage in alpha, color 1: mesh space normal (rgb) and depth across the sphere (a)
+	RenderTarget m_atlas;
+	// frames per atlas side
+	uint32_t m_frames = 0;
+	int m_frameSize = 0;
+	// mesh space bounding sphere every frame was framed on
+	glm::vec3 m_center = glm::vec3(0.0f);
+	float m_radius = 0.0f;
+};
+
+// renders a mesh's finest level into an impostor atlas with an orthographic camera per frame
+// baking only needs a gl context, the frames go to an offscreen target so no window has to be shown
+class ImpostorBaker {
+public:
+	ImpostorBaker();
+	~ImpostorBaker();
+
+	// compiles the bake program, returns false (and logs why) on failure
+	bool create(const std::string& vertexPath, const std::string& fragmentPath);
+	void destroy(void);
+	bool is_valid(void) const { return m_program.is_valid(); }
+
+	// (re)creates the impostor's atlas and fills every frame, leaves the default framebuffer bound
+	bool bake(const MeshManager& meshManager, const MeshId& mesh, uint32_t frames, int frameSize, Impostor& impostor);
+
+	// returns true if an offline bake was requested, in which case the app should not start
+	// run with: UnlimitedForest --bake-impostors <output directory>
+	static bool run_from_args(int argc, char* argv[]);
+	// view direction of an atlas frame in mesh space, pointing from the mesh towards the camera
+	static glm::vec3 get_frame_direction(uint32_t x, uint32_t y, uint32_t frames);
+
+private:
+	// creates a hidden window for its gl context, bakes the demo species and writes the atlases as tga files
+	static bool bake_offline(const std::string& outputDirectory);
+	// uncompressed 32 bit tga of an rgba8 texture, bottom up like gl
+	static bool write_tga(const std::string& path, GLuint texture, int width, int height);
+
+	ShaderProgram m_program;
+};
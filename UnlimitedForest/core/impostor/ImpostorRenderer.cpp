@@ -0,0 +1,103 @@
+#include "ImpostorRenderer.h"
+#include <log/Log.h>
+#include <log/GLDebug.h>
+#include <gl_state/GLStateCache.h>
+#include <renderer/DrawData.h>
+
+#include <algorithm>
+
+namespace {
+	constexpr size_t INITIAL_INSTANCE_CAPACITY = 1024;
+	// two triangles per quad, corners come from gl_VertexID
+	constexpr GLsizei QUAD_VERTICES = 6;
+}
+
+ImpostorRenderer::ImpostorRenderer() : m_drawCalls(0) {}
+
+ImpostorRenderer::~ImpostorRenderer() {
+	destroy();
+}
+
+bool ImpostorRenderer::create(const std::string& vertexPath, const std::string& fragmentPath) {
+	destroy();
+	if (!m_program.create_from_files(vertexPath, fragmentPath)) {
+		UF_LOG_ERROR("failed to build the impostor program");
+		return false;
+	}
+	if (!m_instances.create(GL_SHADER_STORAGE_BUFFER, INITIAL_INSTANCE_CAPACITY * sizeof(InstanceData), GL_STREAM_DRAW)) {
+		destroy();
+		return false;
+	}
+	m_instances.set_label("impostor instances");
+	return true;
+}
+
+void ImpostorRenderer::destroy() {
+	m_program.destroy();
+	m_instances.destroy();
+	m_impostors.clear();
+}
+
+Impostor* ImpostorRenderer::add_impostor(const MeshId& mesh) {
+	std::unique_ptr<Impostor>& impostor = m_impostors[mesh.m_value];
+	impostor = std::make_unique<Impostor>();
+	return impostor.get();
+}
+
+void ImpostorRenderer::remove_impostor(const MeshId& mesh) {
+	m_impostors.erase(mesh.m_value);
+}
+
+const Impostor* ImpostorRenderer::find_impostor(const MeshId& mesh) const {
+	auto it = m_impostors.find(mesh.m_value);
+	return it == m_impostors.end() ? nullptr : it->second.get();
+}
+
+void ImpostorRenderer::draw(ImpostorInstance* instances, uint32_t count, const glm::mat4* worldMatrices, const glm::vec4* colors, GLuint vertexArrayObject, FrameArena& frameArena) {
+	m_drawCalls = 0;
+	if (count == 0 || !is_valid()) {
+		return;
+	}
+
+	// group by species so each gets one contiguous instance range
+	std::sort(instances, instances + count, [](const ImpostorInstance& a, const ImpostorInstance& b) {
+		return a.m_mesh < b.m_mesh;
+	});
+	FrameVector<InstanceData> instanceData(count, FrameAllocator<InstanceData>(&frameArena));
+	for (uint32_t i = 0; i < count; i++) {
+		instanceData[i].m_model = worldMatrices[instances[i].m_row];
+		instanceData[i].m_color = colors[instances[i].m_row];
+		instanceData[i].m_params = glm::vec4(0.0f);
+	}
+	size_t bytes = instanceData.size() * sizeof(InstanceData);
+	m_instances.reserve(bytes);
+	m_instances.update(instanceData.data(), bytes);
+	m_instances.bind_base(INSTANCE_BUFFER_BINDING);
+
+	GLStateCache& state = GLStateCache::get();
+	m_program.bind();
+	state.bind_vertex_array(vertexArrayObject);
+	GLint firstInstanceLocation = m_program.get_uniform_location("u_FirstInstance");
+	GLint centerLocation = m_program.get_uniform_location("u_ImpostorCenter");
+	GLint radiusLocation = m_program.get_uniform_location("u_ImpostorRadius");
+	GLint framesLocation = m_program.get_uniform_location("u_ImpostorFrames");
+	for (uint32_t begin = 0; begin < count;) {
+		uint32_t end = begin + 1;
+		while (end < count && instances[end].m_mesh == instances[begin].m_mesh) {
+			end++;
+		}
+		const Impostor* impostor = find_impostor(MeshId(instances[begin].m_mesh));
+		if (impostor != nullptr && impostor->m_atlas.is_valid()) {
+			m_program.set_int(firstInstanceLocation, static_cast<GLint>(begin));
+			m_program.set_vec3(centerLocation, impostor->m_center);
+			m_program.set_float(radiusLocation, impostor->m_radius);
+			m_program.set_int(framesLocation, static_cast<GLint>(impostor->m_frames));
+			state.bind_texture_unit(0, impostor->m_atlas.get_color_texture(0));
+			state.bind_texture_unit(1, impostor->m_atlas.get_color_texture(1));
+			glDrawArraysInstanced(GL_TRIANGLES, 0, QUAD_VERTICES, static_cast<GLsizei>(end - begin));
+			m_drawCalls++;
+		}
+		begin = end;
+	}
+	CATCH_GL_ERROR("error drawing impostors");
+}
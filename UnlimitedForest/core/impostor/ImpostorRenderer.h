@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ImpostorBaker.h"
+#include <gpu_buffer/GpuBuffer.h>
+#include <memory/FrameArena.h>
+#include <mesh_manager/MeshManager.h>
+#include <shader/ShaderProgram.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// an item drawn as its mesh's impostor this frame
+struct ImpostorInstance {
+	uint32_t m_mesh; // MeshId::m_value, what instances are grouped by
+	uint32_t m_row;
+};
+
+// draws distant items as camera facing quads textured with the baked frame nearest to the view direction,
+// two triangles each regardless of the mesh, one instanced draw per species
+class ImpostorRenderer {
+public:
+	ImpostorRenderer();
+	~ImpostorRenderer();
+
+	ImpostorRenderer(const ImpostorRenderer&) = delete;
+	ImpostorRenderer& operator=(const ImpostorRenderer&) = delete;
+
+	// compiles the billboard program, returns false (and logs why) on failure
+	bool create(const std::string& vertexPath, const std::string& fragmentPath);
+	void destroy(void);
+	bool is_valid(void) const { return m_program.is_valid(); }
+
+	// empty impostor for the mesh to bake into, replaces an existing one
+	Impostor* add_impostor(const MeshId& mesh);
+	void remove_impostor(const MeshId& mesh);
+	// nullptr if the mesh has no baked impostor
+	const Impostor* find_impostor(const MeshId& mesh) const;
+	bool has_impostors(void) const { return !m_impostors.empty(); }
+
+	// sorts the instances by species in place, any vao works since the quads are built from gl_VertexID
+	void draw(ImpostorInstance* instances, uint32_t count, const glm::mat4* worldMatrices, const glm::vec4* colors, GLuint vertexArrayObject, FrameArena& frameArena);
+
+	uint32_t get_draw_calls(void) const { return m_drawCalls; }
+
+private:
+	ShaderProgram m_program;
+	GpuBuffer m_instances;
+	// keyed by MeshId::m_value so a recycled mesh slot never picks up a stale impostor
+	std::unordered_map<uint32_t, std::unique_ptr<Impostor>> m_impostors;
+	uint32_t m_drawCalls;
+};
@@ -0,0 +1,198 @@
+#include "JobSystem.h"
+#include <log/Log.h>
+
+namespace {
+	// which system / worker the current thread belongs to, threads outside the system use queue 0
+	thread_local const JobSystem* t_jobSystem = nullptr;
+	thread_local uint32_t t_workerIdx = 0;
+}
+
+bool JobSystem::WorkerQueue::push(const Job& job) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_bottom - m_top >= QUEUE_CAPACITY) {
+		return false;
+	}
+	m_jobs[m_bottom % QUEUE_CAPACITY] = job;
+	m_bottom++;
+	return true;
+}
+
+bool JobSystem::WorkerQueue::pop(Job& job) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_bottom == m_top) {
+		return false;
+	}
+	m_bottom--;
+	job = m_jobs[m_bottom % QUEUE_CAPACITY];
+	return true;
+}
+
+bool JobSystem::WorkerQueue::steal(Job& job) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_bottom == m_top) {
+		return false;
+	}
+	job = m_jobs[m_top % QUEUE_CAPACITY];
+	m_top++;
+	return true;
+}
+
+JobSystem::JobSystem(uint32_t threadCount) {
+	if (threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency();
+	}
+	m_workerCount = threadCount == 0 ? 1 : threadCount;
+
+	for (uint32_t i = 0; i < m_workerCount; i++) {
+		m_queues.push_back(new WorkerQueue());
+	}
+	m_waitingJobs.reserve(QUEUE_CAPACITY);
+
+	// the constructing thread is worker 0, the rest get their own threads
+	t_jobSystem = this;
+	t_workerIdx = 0;
+	for (uint32_t i = 1; i < m_workerCount; i++) {
+		m_threads.emplace_back(&JobSystem::worker_main, this, i);
+	}
+	UF_LOG_INFO("job system started with {} workers", m_workerCount);
+}
+
+JobSystem::~JobSystem() {
+	m_running.store(false);
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_sleepCondition.notify_all();
+	for (std::thread& thread : m_threads) {
+		thread.join();
+	}
+	for (WorkerQueue* queue : m_queues) {
+		delete queue;
+	}
+	if (t_jobSystem == this) {
+		t_jobSystem = nullptr;
+	}
+}
+
+void JobSystem::run(const Job& job) {
+	if (job.m_counter) {
+		job.m_counter->m_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (job.m_dependency && !job.m_dependency->is_done()) {
+		{
+			std::lock_guard<std::mutex> lock(m_waitingMutex);
+			m_waitingJobs.push_back(job);
+			m_waitingCount.fetch_add(1, std::memory_order_seq_cst);
+		}
+		// the dependency may have finished before we were parked, in which case nobody else will release us
+		// seq_cst pairs with execute(): the waiting count store and this load against its counter decrement and
+		// waiting count load, so at least one side sees the other and the job can not be left parked
+		if (job.m_dependency->m_count.load(std::memory_order_seq_cst) == 0) {
+			release_waiting_jobs();
+		}
+		return;
+	}
+
+	enqueue(job);
+}
+
+void JobSystem::wait(const JobCounter& counter) {
+	uint32_t workerIdx = current_worker();
+	while (!counter.is_done()) {
+		if (!try_run_one(workerIdx)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::worker_main(uint32_t workerIdx) {
+	t_jobSystem = this;
+	t_workerIdx = workerIdx;
+
+	while (m_running.load()) {
+		if (try_run_one(workerIdx)) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleepingWorkers.fetch_add(1);
+		m_sleepCondition.wait(lock, [this]() {
+			return m_queuedJobs.load() > 0 || !m_running.load();
+		});
+		m_sleepingWorkers.fetch_sub(1);
+	}
+}
+
+bool JobSystem::try_run_one(uint32_t workerIdx) {
+	Job job;
+	bool found = m_queues[workerIdx]->pop(job);
+	// own queue is empty, steal the oldest job from the next worker that has one
+	for (uint32_t i = 1; !found && i < m_workerCount; i++) {
+		found = m_queues[(workerIdx + i) % m_workerCount]->steal(job);
+	}
+	if (!found) {
+		return false;
+	}
+	m_queuedJobs.fetch_sub(1);
+	execute(job);
+	return true;
+}
+
+void JobSystem::execute(const Job& job) {
+	job.m_function(job.m_data, job.m_begin, job.m_end);
+	// seq_cst, see the parking side in run()
+	if (job.m_counter && job.m_counter->m_count.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+		if (m_waitingCount.load(std::memory_order_seq_cst) > 0) {
+			release_waiting_jobs();
+		}
+	}
+}
+
+void JobSystem::enqueue(const Job& job) {
+	// count before publishing so a thief can never take the count below zero
+	m_queuedJobs.fetch_add(1);
+	if (!m_queues[current_worker()]->push(job)) {
+		// queue is full, running inline is always correct just not parallel
+		m_queuedJobs.fetch_sub(1);
+		execute(job);
+		return;
+	}
+	if (m_sleepingWorkers.load() > 0) {
+		// taking the lock orders us against a worker that is about to sleep so the wake is not lost
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_sleepCondition.notify_one();
+	}
+}
+
+void JobSystem::release_waiting_jobs() {
+	// one job at a time so the lock is never held while running or queueing, execute can recurse back here
+	for (;;) {
+		Job job;
+		bool found = false;
+		{
+			std::lock_guard<std::mutex> lock(m_waitingMutex);
+			for (size_t i = 0, s = m_waitingJobs.size(); i < s; i++) {
+				if (m_waitingJobs[i].m_dependency->is_done()) {
+					job = m_waitingJobs[i];
+					m_waitingJobs[i] = m_waitingJobs.back();
+					m_waitingJobs.pop_back();
+					m_waitingCount.fetch_sub(1);
+					found = true;
+					break;
+				}
+			}
+		}
+		if (!found) {
+			return;
+		}
+		// counter was already bumped when the job was first scheduled
+		job.m_dependency = nullptr;
+		enqueue(job);
+	}
+}
+
+uint32_t JobSystem::current_worker() const {
+	return t_jobSystem == this ? t_workerIdx : 0;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// number of outstanding jobs in a group, jobs decrement it when they finish
+// waiting on a counter (or scheduling a job that depends on one) waits for the whole group
+class JobCounter {
+public:
+	bool is_done(void) const { return m_count.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+	std::atomic<uint32_t> m_count{ 0 };
+};
+
+// plain function pointer + range so jobs never allocate, data points at caller owned state
+using JobFunction = void (*)(void* data, uint32_t begin, uint32_t end);
+
+struct Job {
+	JobFunction m_function = nullptr;
+	void* m_data = nullptr;
+	uint32_t m_begin = 0;
+	uint32_t m_end = 0;
+	// decremented when the job finishes, may be null
+	JobCounter* m_counter = nullptr;
+	// job is held back until this counter reaches zero, may be null
+	const JobCounter* m_dependency = nullptr;
+};
+
+// work stealing job system
+// every worker (the calling thread is worker 0) owns a deque, owners push / pop at the bottom and
+// idle workers steal from the top of someone else's, so recursive splits stay local and cache warm
+class JobSystem {
+public:
+	// 0 threads means one per hardware thread, the calling thread always counts as one of them
+	explicit JobSystem(uint32_t threadCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	void run(const Job& job);
+	// blocks until the counter hits zero, executing other jobs instead of idling
+	void wait(const JobCounter& counter);
+
+	// splits [0, count) into grain sized ranges and calls fn(begin, end) across all workers, returns when done
+	template<typename Fn>
+	void parallel_for(uint32_t count, uint32_t grainSize, Fn&& fn) {
+		if (count == 0) {
+			return;
+		}
+		grainSize = grainSize == 0 ? 1 : grainSize;
+		if (m_workerCount == 1 || count <= grainSize) {
+			fn(0u, count);
+			return;
+		}
+
+		using FnType = std::remove_reference_t<Fn>;
+		JobCounter counter;
+		Job job;
+		job.m_function = [](void* data, uint32_t begin, uint32_t end) {
+			(*static_cast<FnType*>(data))(begin, end);
+		};
+		job.m_data = const_cast<void*>(static_cast<const void*>(&fn));
+		job.m_counter = &counter;
+		for (uint32_t begin = 0; begin < count; begin += grainSize) {
+			job.m_begin = begin;
+			job.m_end = begin + grainSize < count ? begin + grainSize : count;
+			run(job);
+		}
+		wait(counter);
+	}
+
+	uint32_t get_thread_count(void) const { return m_workerCount; }
+
+private:
+	// fixed size ring so queueing never allocates, a full queue runs the job inline
+	static constexpr uint32_t QUEUE_CAPACITY = 4096;
+
+	struct WorkerQueue {
+		std::mutex m_mutex;
+		Job m_jobs[QUEUE_CAPACITY];
+		uint32_t m_top = 0; // steal end
+		uint32_t m_bottom = 0; // owner end
+
+		bool push(const Job& job);
+		bool pop(Job& job);
+		bool steal(Job& job);
+	};
+
+	void worker_main(uint32_t workerIdx);
+	bool try_run_one(uint32_t workerIdx);
+	void enqueue(const Job& job);
+	void execute(const Job& job);
+	void release_waiting_jobs(void);
+	uint32_t current_worker(void) const;
+
+	uint32_t m_workerCount;
+	std::vector<WorkerQueue*> m_queues;
+	std::vector<std::thread> m_threads;
+
+	// jobs whose dependency has not finished yet
+	std::mutex m_waitingMutex;
+	std::vector<Job> m_waitingJobs;
+	std::atomic<uint32_t> m_waitingCount{ 0 };
+
+	// sleeping workers wake when jobs are queued
+	std::mutex m_sleepMutex;
+	std::condition_variable m_sleepCondition;
+	std::atomic<uint32_t> m_queuedJobs{ 0 };
+	std::atomic<uint32_t> m_sleepingWorkers{ 0 };
+	std::atomic<bool> m_running{ true };
+};
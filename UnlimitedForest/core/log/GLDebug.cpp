@@ -0,0 +1,93 @@
+#include "GLDebug.h"
+
+bool GLDebug::s_active = false;
+const char* GLDebug::s_groups[GLDebug::MAX_GROUP_DEPTH] = {};
+uint32_t GLDebug::s_groupDepth = 0;
+
+namespace {
+	const char* source_name(GLenum source) {
+		switch (source) {
+			case GL_DEBUG_SOURCE_API: return "api";
+			case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+			case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+			case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+			case GL_DEBUG_SOURCE_APPLICATION: return "application";
+			default: return "other";
+		}
+	}
+
+	const char* type_name(GLenum type) {
+		switch (type) {
+			case GL_DEBUG_TYPE_ERROR: return "error";
+			case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+			case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+			case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+			case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+			default: return "other";
+		}
+	}
+}
+
+bool GLDebug::init() {
+	s_active = false;
+	s_groupDepth = 0;
+	GLint flags = 0;
+	glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+	if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT)) {
+		UF_LOG_WARN("no debug gl context, gl errors go unreported");
+		return false;
+	}
+
+	glEnable(GL_DEBUG_OUTPUT);
+	// messages arrive on the calling thread inside the offending call, so the log lines up with the code
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(on_message, nullptr);
+	// notifications (buffer placement and the like) and our own group markers would drown everything else
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+	glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+	glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+	s_active = true;
+	UF_LOG_INFO("gl debug output enabled");
+	return true;
+}
+
+void GLDebug::push_group(const char* name) {
+	if (!s_active) {
+		return;
+	}
+	glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+	if (s_groupDepth < MAX_GROUP_DEPTH) {
+		s_groups[s_groupDepth] = name;
+	}
+	s_groupDepth++;
+}
+
+void GLDebug::pop_group() {
+	if (!s_active || s_groupDepth == 0) {
+		return;
+	}
+	glPopDebugGroup();
+	s_groupDepth--;
+}
+
+void GLDebug::label(GLenum identifier, GLuint name, const char* label) {
+	if (!s_active || name == 0) {
+		return;
+	}
+	glObjectLabel(identifier, name, -1, label);
+}
+
+void APIENTRY GLDebug::on_message(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
+	const char* group = s_groupDepth == 0 ? "-" : s_groups[(s_groupDepth < MAX_GROUP_DEPTH ? s_groupDepth : MAX_GROUP_DEPTH) - 1];
+	switch (severity) {
+		case GL_DEBUG_SEVERITY_HIGH:
+			UF_LOG_ERROR("gl {} {} ({}) in {}: {}", source_name(source), type_name(type), id, group, message);
+			break;
+		case GL_DEBUG_SEVERITY_MEDIUM:
+			UF_LOG_WARN("gl {} {} ({}) in {}: {}", source_name(source), type_name(type), id, group, message);
+			break;
+		default:
+			UF_LOG_INFO("gl {} {} ({}) in {}: {}", source_name(source), type_name(type), id, group, message);
+			break;
+	}
+}
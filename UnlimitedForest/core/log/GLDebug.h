@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Log.h"
+
+#include <cstdint>
+#include <glad/glad.h>
+
+// KHR_debug (core since 4.3) on a debug context: the driver reports errors and performance warnings through a
+// callback the moment they happen, so nothing has to poll glGetError and stall on it
+// debug groups name the pass a message came from in the log and in frame capture tools, labels name objects
+class GLDebug {
+public:
+	// installs the callback if the current context was created with the debug flag, returns whether it was
+	static bool init(void);
+	static bool is_active(void) { return s_active; }
+
+	static void push_group(const char* name);
+	static void pop_group(void);
+	// identifier is the object namespace, GL_BUFFER, GL_TEXTURE, GL_FRAMEBUFFER, GL_VERTEX_ARRAY, GL_PROGRAM ...
+	static void label(GLenum identifier, GLuint name, const char* label);
+
+private:
+	static void APIENTRY on_message(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+
+	// innermost group names, the log names the pass a message came from, deeper nesting is only counted
+	static constexpr uint32_t MAX_GROUP_DEPTH = 8;
+	static bool s_active;
+	static const char* s_groups[MAX_GROUP_DEPTH];
+	static uint32_t s_groupDepth;
+};
+
+// pushes a debug group for the rest of the enclosing scope
+class GLDebugScope {
+public:
+	explicit GLDebugScope(const char* name) { GLDebug::push_group(name); }
+	~GLDebugScope() { GLDebug::pop_group(); }
+
+	GLDebugScope(const GLDebugScope&) = delete;
+	GLDebugScope& operator=(const GLDebugScope&) = delete;
+};
+
+#define UF_GL_CONCAT_INNER(a, b) a##b
+#define UF_GL_CONCAT(a, b) UF_GL_CONCAT_INNER(a, b)
+
+#if UF_GL_DEBUG
+#define UF_GL_DEBUG_GROUP(name)                  ::GLDebugScope UF_GL_CONCAT(glDebugScope, __LINE__)(name)
+#define UF_GL_LABEL(identifier, object, text)    ::GLDebug::label(identifier, object, text)
+#else
+#define UF_GL_DEBUG_GROUP(name)                  ((void)0)
+#define UF_GL_LABEL(identifier, object, text)    ((void)0)
+#endif
@@ -1,4 +1,5 @@
 #include "Log.h"
+#include "GLDebug.h"
 
 #include <glad/glad.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
@@ -11,7 +12,11 @@ void Log::init() {
 	s_logger->set_level(spdlog::level::trace);
 }
 
-void Log::catch_gl_error(const std::string& errorMessage) {
+void Log::catch_gl_error(const char* errorMessage) {
+	// polling stalls the driver, only worth it when nothing else reports errors
+	if (GLDebug::is_active()) {
+		return;
+	}
 	GLenum error = glGetError();
 	if (error != GL_NO_ERROR) {
 		UF_LOG_ERROR("GLError [{}] : {}", error, errorMessage);
@@ -9,7 +9,7 @@ public:
 
 	inline static std::shared_ptr<spdlog::logger>& getLogger() { return  s_logger; }
 
-	static void catch_gl_error(const std::string& errorMessage);
+	static void catch_gl_error(const char* errorMessage);
 
 private:
 	static std::shared_ptr<spdlog::logger> s_logger;
@@ -22,4 +22,18 @@ private:
 #define UF_LOG_ERROR(...)      ::Log::getLogger()->error(__VA_ARGS__)
 #define UF_LOG_CRITICAL(...)   ::Log::getLogger()->critical(__VA_ARGS__)
 
+// gl debug output, object labels and error checks, compiled out of release builds unless asked for
+#ifndef UF_GL_DEBUG
+#ifdef NDEBUG
+#define UF_GL_DEBUG 0
+#else
+#define UF_GL_DEBUG 1
+#endif
+#endif
+
+// a fallback for contexts without debug output, with it the callback has already reported the error in place
+#if UF_GL_DEBUG
 #define CATCH_GL_ERROR(...)    ::Log::catch_gl_error(__VA_ARGS__)
+#else
+#define CATCH_GL_ERROR(...)    ((void)0)
+#endif
@@ -0,0 +1,100 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+	std::atomic<uint64_t> s_allocationCount{ 0 };
+	std::atomic<uint64_t> s_freeCount{ 0 };
+	std::atomic<uint64_t> s_allocatedBytes{ 0 };
+
+	void* counted_alloc(size_t bytes) {
+		AllocationCounter::record_allocation(bytes);
+		void* ptr = std::malloc(bytes == 0 ? 1 : bytes);
+		if (!ptr) {
+			throw std::bad_alloc();
+		}
+		return ptr;
+	}
+
+	void* counted_aligned_alloc(size_t bytes, std::align_val_t alignment) {
+		AllocationCounter::record_allocation(bytes);
+		size_t align = static_cast<size_t>(alignment);
+#ifdef _MSC_VER
+		void* ptr = _aligned_malloc(bytes == 0 ? 1 : bytes, align);
+#else
+		// aligned_alloc wants the size to be a non-zero multiple of the alignment
+		size_t size = bytes == 0 ? align : ((bytes + align - 1) / align) * align;
+		void* ptr = std::aligned_alloc(align, size);
+#endif
+		if (!ptr) {
+			throw std::bad_alloc();
+		}
+		return ptr;
+	}
+
+	void counted_free(void* ptr) {
+		if (ptr) {
+			AllocationCounter::record_free();
+			std::free(ptr);
+		}
+	}
+
+	void counted_aligned_free(void* ptr) {
+		if (ptr) {
+			AllocationCounter::record_free();
+#ifdef _MSC_VER
+			_aligned_free(ptr);
+#else
+			std::free(ptr);
+#endif
+		}
+	}
+}
+
+uint64_t AllocationCounter::get_allocation_count() {
+	return s_allocationCount.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::get_free_count() {
+	return s_freeCount.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::get_allocated_bytes() {
+	return s_allocatedBytes.load(std::memory_order_relaxed);
+}
+
+void AllocationCounter::record_allocation(size_t bytes) {
+	s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	s_allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void AllocationCounter::record_free() {
+	s_freeCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+// global replacements, every new / delete in the program goes through the counters
+void* operator new(size_t bytes) { return counted_alloc(bytes); }
+void* operator new[](size_t bytes) { return counted_alloc(bytes); }
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+	try { return counted_alloc(bytes); }
+	catch (...) { return nullptr; }
+}
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept {
+	try { return counted_alloc(bytes); }
+	catch (...) { return nullptr; }
+}
+void* operator new(size_t bytes, std::align_val_t alignment) { return counted_aligned_alloc(bytes, alignment); }
+void* operator new[](size_t bytes, std::align_val_t alignment) { return counted_aligned_alloc(bytes, alignment); }
+
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { counted_aligned_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { counted_aligned_free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { counted_aligned_free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { counted_aligned_free(ptr); }
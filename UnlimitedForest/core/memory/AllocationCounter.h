@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// counts every global operator new / delete in the program (replaced in AllocationCounter.cpp)
+// sample the totals around a block of code to check it stays off the heap, e.g. the frame loop
+class AllocationCounter {
+public:
+	static uint64_t get_allocation_count(void);
+	static uint64_t get_free_count(void);
+	static uint64_t get_allocated_bytes(void);
+
+	static void record_allocation(size_t bytes);
+	static void record_free(void);
+};
+
+// snapshot helper, allocations made since construction
+class AllocationScope {
+public:
+	AllocationScope() : m_startAllocations(AllocationCounter::get_allocation_count()),
+		m_startBytes(AllocationCounter::get_allocated_bytes()) {}
+
+	uint64_t get_allocations(void) const { return AllocationCounter::get_allocation_count() - m_startAllocations; }
+	uint64_t get_bytes(void) const { return AllocationCounter::get_allocated_bytes() - m_startBytes; }
+
+private:
+	uint64_t m_startAllocations;
+	uint64_t m_startBytes;
+};
@@ -0,0 +1,68 @@
+#include "FrameArena.h"
+#include <log/Log.h>
+
+FrameArena::FrameArena(size_t bytesPerFrame)
+	: m_buffers{ nullptr, nullptr },
+	m_offsets{ 0, 0 },
+	m_current(0),
+	m_capacity(bytesPerFrame),
+	m_frameOverflowBytes(0),
+	m_highWaterMark(0),
+	m_overflowCount(0)
+{
+	m_buffers[0] = static_cast<unsigned char*>(::operator new(bytesPerFrame, std::align_val_t(64)));
+	m_buffers[1] = static_cast<unsigned char*>(::operator new(bytesPerFrame, std::align_val_t(64)));
+}
+
+FrameArena::~FrameArena() {
+	UF_LOG_INFO("frame arena high water mark: {} / {} bytes, {} heap overflows",
+		m_highWaterMark,
+		m_capacity,
+		m_overflowCount
+	);
+	::operator delete(m_buffers[0], std::align_val_t(64));
+	::operator delete(m_buffers[1], std::align_val_t(64));
+}
+
+void FrameArena::begin_frame() {
+	// close out the finished frame before rewinding
+	size_t frameBytes = m_offsets[m_current] + m_frameOverflowBytes;
+	if (frameBytes > m_highWaterMark) {
+		m_highWaterMark = frameBytes;
+	}
+	m_frameOverflowBytes = 0;
+
+	m_current ^= 1;
+	m_offsets[m_current] = 0;
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+	size_t offset = m_offsets[m_current];
+	uintptr_t base = reinterpret_cast<uintptr_t>(m_buffers[m_current]);
+	uintptr_t aligned = (base + offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+	size_t newOffset = (aligned - base) + bytes;
+	if (newOffset > m_capacity) {
+		return nullptr;
+	}
+	m_offsets[m_current] = newOffset;
+	return reinterpret_cast<void*>(aligned);
+}
+
+bool FrameArena::owns(const void* ptr) const {
+	const unsigned char* p = static_cast<const unsigned char*>(ptr);
+	for (const unsigned char* buffer : m_buffers) {
+		if (p >= buffer && p < buffer + m_capacity) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void FrameArena::record_overflow(size_t bytes) {
+	// only warn the first time, the high water mark tells how far over we went
+	if (m_overflowCount == 0) {
+		UF_LOG_WARN("frame arena exhausted ({} bytes), falling back to the heap", m_capacity);
+	}
+	m_overflowCount++;
+	m_frameOverflowBytes += bytes;
+}
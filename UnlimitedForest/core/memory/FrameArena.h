@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// double buffered linear allocator for transient per-frame data (draw lists, culling results, sort keys...)
+// allocation is a pointer bump, nothing is freed individually, begin_frame flips to the other buffer and rewinds it
+// so data written last frame stays readable for one more frame
+class FrameArena {
+public:
+	explicit FrameArena(size_t bytesPerFrame);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// called once at the top of the frame loop
+	void begin_frame(void);
+
+	// nullptr when the frame buffer is exhausted, callers fall back to the heap (see FrameAllocator)
+	void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+	bool owns(const void* ptr) const;
+
+	// called on a heap fallback so the high water mark still reflects what the frame wanted
+	void record_overflow(size_t bytes);
+
+	size_t get_capacity(void) const { return m_capacity; }
+	size_t get_used(void) const { return m_offsets[m_current]; }
+	// most bytes any single frame asked for, including overflow, use this to size the arena
+	size_t get_high_water_mark(void) const { return m_highWaterMark; }
+	uint64_t get_overflow_count(void) const { return m_overflowCount; }
+
+private:
+	unsigned char* m_buffers[2];
+	size_t m_offsets[2];
+	uint32_t m_current;
+	size_t m_capacity;
+
+	size_t m_frameOverflowBytes;
+	size_t m_highWaterMark;
+	uint64_t m_overflowCount;
+};
+
+// stl allocator adapter so scratch containers can live in the frame arena
+// deallocate is a no-op for arena memory, it is reclaimed when the buffer is rewound two frames later
+// containers must not outlive the frame after the one they were filled in
+template<typename T>
+class FrameAllocator {
+public:
+	using value_type = T;
+
+	explicit FrameAllocator(FrameArena* arena) : m_arena(arena) {}
+	template<typename U>
+	FrameAllocator(const FrameAllocator<U>& other) : m_arena(other.get_arena()) {}
+
+	T* allocate(size_t count) {
+		size_t bytes = count * sizeof(T);
+		void* ptr = m_arena->allocate(bytes, alignof(T));
+		if (ptr == nullptr) {
+			m_arena->record_overflow(bytes);
+			ptr = ::operator new(bytes);
+		}
+		return static_cast<T*>(ptr);
+	}
+
+	void deallocate(T* ptr, size_t) {
+		if (!m_arena->owns(ptr)) {
+			::operator delete(ptr);
+		}
+	}
+
+	FrameArena* get_arena(void) const { return m_arena; }
+
+	template<typename U>
+	bool operator==(const FrameAllocator<U>& other) const { return m_arena == other.get_arena(); }
+	template<typename U>
+	bool operator!=(const FrameAllocator<U>& other) const { return m_arena != other.get_arena(); }
+
+private:
+	FrameArena* m_arena;
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+// typed fixed size pool, objects are carved out of blocks of SLOTS_PER_BLOCK slots
+// create / destroy are O(1) free list operations and only growing the pool touches the heap
+// release_all destroys every live object and hands whole blocks back at once, e.g. when a chunk unloads
+template<typename T, uint32_t SLOTS_PER_BLOCK = 256>
+class PoolAllocator {
+public:
+	PoolAllocator() = default;
+	~PoolAllocator() { release_all(); }
+
+	PoolAllocator(const PoolAllocator&) = delete;
+	PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+	template<typename... Args>
+	T* create(Args&&... args) {
+		if (m_freeList == nullptr) {
+			add_block();
+		}
+		Slot* slot = m_freeList;
+		m_freeList = slot->m_next;
+
+		T* object = new (slot->m_storage) T(std::forward<Args>(args)...);
+		slot->m_live = true;
+		m_liveCount++;
+		return object;
+	}
+
+	// object must have come from this pool
+	void destroy(T* object) {
+		if (object == nullptr) {
+			return;
+		}
+		object->~T();
+		// storage is the first member so the object address is the slot address
+		Slot* slot = reinterpret_cast<Slot*>(object);
+		slot->m_live = false;
+		slot->m_next = m_freeList;
+		m_freeList = slot;
+		m_liveCount--;
+	}
+
+	// destroys every live object and frees all blocks
+	void release_all(void) {
+		for (Block* block : m_blocks) {
+			for (Slot& slot : block->m_slots) {
+				if (slot.m_live) {
+					reinterpret_cast<T*>(slot.m_storage)->~T();
+				}
+			}
+			delete block;
+		}
+		m_blocks.clear();
+		m_freeList = nullptr;
+		m_liveCount = 0;
+	}
+
+	// calls fn(T*) for every live object in block order
+	template<typename Fn>
+	void for_each(Fn&& fn) {
+		for (Block* block : m_blocks) {
+			for (Slot& slot : block->m_slots) {
+				if (slot.m_live) {
+					fn(reinterpret_cast<T*>(slot.m_storage));
+				}
+			}
+		}
+	}
+
+	uint32_t get_live_count(void) const { return m_liveCount; }
+	uint32_t get_capacity(void) const { return static_cast<uint32_t>(m_blocks.size()) * SLOTS_PER_BLOCK; }
+
+private:
+	struct Slot {
+		union {
+			alignas(T) unsigned char m_storage[sizeof(T)];
+			Slot* m_next;
+		};
+		bool m_live;
+	};
+
+	struct Block {
+		Slot m_slots[SLOTS_PER_BLOCK];
+	};
+
+	void add_block(void) {
+		Block* block = new Block();
+		m_blocks.push_back(block);
+		// thread the new slots onto the free list in address order
+		for (uint32_t i = SLOTS_PER_BLOCK; i > 0; i--) {
+			Slot& slot = block->m_slots[i - 1];
+			slot.m_live = false;
+			slot.m_next = m_freeList;
+			m_freeList = &slot;
+		}
+	}
+
+	std::vector<Block*> m_blocks;
+	Slot* m_freeList = nullptr;
+	uint32_t m_liveCount = 0;
+};
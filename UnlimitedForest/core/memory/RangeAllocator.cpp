@@ -0,0 +1,73 @@
+#include "RangeAllocator.h"
+#include <log/Log.h>
+
+RangeAllocator::RangeAllocator(uint32_t capacity) : m_capacity(0), m_used(0), m_highWaterMark(0) {
+	grow(capacity);
+}
+
+uint32_t RangeAllocator::allocate(uint32_t count) {
+	if (count == 0) {
+		return INVALID_OFFSET;
+	}
+	for (size_t i = 0, s = m_freeRanges.size(); i < s; i++) {
+		Range& range = m_freeRanges[i];
+		if (range.m_count < count) {
+			continue;
+		}
+		uint32_t offset = range.m_offset;
+		range.m_offset += count;
+		range.m_count -= count;
+		if (range.m_count == 0) {
+			m_freeRanges.erase(m_freeRanges.begin() + i);
+		}
+		m_used += count;
+		if (offset + count > m_highWaterMark) {
+			m_highWaterMark = offset + count;
+		}
+		return offset;
+	}
+	return INVALID_OFFSET;
+}
+
+void RangeAllocator::free(uint32_t offset, uint32_t count) {
+	if (count == 0 || offset + count > m_capacity) {
+		UF_LOG_ERROR("freeing range [{}, {}) outside of allocator capacity {}", offset, offset + count, m_capacity);
+		return;
+	}
+
+	// find the first free range after this one and merge with whichever neighbours touch it
+	size_t next = 0;
+	while (next < m_freeRanges.size() && m_freeRanges[next].m_offset < offset) {
+		next++;
+	}
+	bool mergePrev = next > 0 && m_freeRanges[next - 1].m_offset + m_freeRanges[next - 1].m_count == offset;
+	bool mergeNext = next < m_freeRanges.size() && offset + count == m_freeRanges[next].m_offset;
+
+	if (mergePrev && mergeNext) {
+		m_freeRanges[next - 1].m_count += count + m_freeRanges[next].m_count;
+		m_freeRanges.erase(m_freeRanges.begin() + next);
+	}
+	else if (mergePrev) {
+		m_freeRanges[next - 1].m_count += count;
+	}
+	else if (mergeNext) {
+		m_freeRanges[next].m_offset = offset;
+		m_freeRanges[next].m_count += count;
+	}
+	else {
+		m_freeRanges.insert(m_freeRanges.begin() + next, { offset, count });
+	}
+	m_used -= count;
+}
+
+void RangeAllocator::grow(uint32_t newCapacity) {
+	if (newCapacity <= m_capacity) {
+		return;
+	}
+	uint32_t added = newCapacity - m_capacity;
+	uint32_t oldCapacity = m_capacity;
+	m_capacity = newCapacity;
+	// hand the new tail out through free so it merges with a free range ending at the old capacity
+	m_used += added;
+	free(oldCapacity, added);
+}
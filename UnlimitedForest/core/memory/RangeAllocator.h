@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// first fit allocator over an abstract [0, capacity) range of elements, used to sub-allocate big gpu buffers
+// only offsets are handed out, the caller owns the memory; freed ranges are merged with their neighbours
+class RangeAllocator {
+public:
+	static constexpr uint32_t INVALID_OFFSET = 0xFFFFFFFFu;
+
+	explicit RangeAllocator(uint32_t capacity = 0);
+
+	// INVALID_OFFSET when no free range is large enough, grow and retry
+	uint32_t allocate(uint32_t count);
+	void free(uint32_t offset, uint32_t count);
+	// extends the range, existing allocations keep their offsets
+	void grow(uint32_t newCapacity);
+
+	uint32_t get_capacity(void) const { return m_capacity; }
+	uint32_t get_used(void) const { return m_used; }
+	// one past the highest allocated element, what actually has to be copied when the backing store grows
+	uint32_t get_high_water_mark(void) const { return m_highWaterMark; }
+
+private:
+	struct Range {
+		uint32_t m_offset;
+		uint32_t m_count;
+	};
+
+	// sorted by offset so neighbours can be merged on free
+	std::vector<Range> m_freeRanges;
+	uint32_t m_capacity;
+	uint32_t m_used;
+	uint32_t m_highWaterMark;
+};
@@ -0,0 +1,63 @@
+#include "DemoMeshes.h"
+
+#include <cmath>
+#include <glm/glm.hpp>
+
+namespace {
+	constexpr uint32_t FLOATS_PER_VERTEX = 6;
+
+	void append_vertex(std::vector<GLfloat>& vertexData, const glm::vec3& position, const glm::vec3& color) {
+		vertexData.insert(vertexData.end(), { position.x, position.y, position.z, color.x, color.y, color.z });
+	}
+
+	// closed y aligned cone section, a top radius of 0 closes it into an apex
+	void append_cone(std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices, uint32_t segments,
+		float bottomY, float topY, float bottomRadius, float topRadius, const glm::vec3& bottomColor, const glm::vec3& topColor) {
+		GLuint first = static_cast<GLuint>(vertexData.size() / FLOATS_PER_VERTEX);
+		bool apex = topRadius <= 0.0f;
+		for (uint32_t i = 0; i < segments; i++) {
+			float angle = 6.2831853f * static_cast<float>(i) / static_cast<float>(segments);
+			append_vertex(vertexData, glm::vec3(std::cos(angle) * bottomRadius, bottomY, std::sin(angle) * bottomRadius), bottomColor);
+		}
+		if (apex) {
+			append_vertex(vertexData, glm::vec3(0.0f, topY, 0.0f), topColor);
+		}
+		else {
+			for (uint32_t i = 0; i < segments; i++) {
+				float angle = 6.2831853f * static_cast<float>(i) / static_cast<float>(segments);
+				append_vertex(vertexData, glm::vec3(std::cos(angle) * topRadius, topY, std::sin(angle) * topRadius), topColor);
+			}
+		}
+		GLuint bottomCenter = static_cast<GLuint>(vertexData.size() / FLOATS_PER_VERTEX);
+		append_vertex(vertexData, glm::vec3(0.0f, bottomY, 0.0f), bottomColor);
+
+		for (uint32_t i = 0; i < segments; i++) {
+			GLuint b0 = first + i;
+			GLuint b1 = first + (i + 1) % segments;
+			if (apex) {
+				indices.insert(indices.end(), { b0, first + segments, b1 });
+			}
+			else {
+				GLuint t0 = first + segments + i;
+				GLuint t1 = first + segments + (i + 1) % segments;
+				indices.insert(indices.end(), { b0, t0, b1, b1, t0, t1 });
+			}
+			indices.insert(indices.end(), { bottomCenter, b0, b1 });
+		}
+		if (!apex) {
+			GLuint topCenter = static_cast<GLuint>(vertexData.size() / FLOATS_PER_VERTEX);
+			append_vertex(vertexData, glm::vec3(0.0f, topY, 0.0f), topColor);
+			for (uint32_t i = 0; i < segments; i++) {
+				indices.insert(indices.end(), { topCenter, first + segments + (i + 1) % segments, first + segments + i });
+			}
+		}
+	}
+}
+
+void build_demo_tree(std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices) {
+	vertexData.clear();
+	indices.clear();
+	append_cone(vertexData, indices, 6, 0.0f, 0.7f, 0.1f, 0.07f, glm::vec3(0.35f, 0.22f, 0.1f), glm::vec3(0.45f, 0.3f, 0.15f));
+	append_cone(vertexData, indices, 8, 0.5f, 1.4f, 0.7f, 0.0f, glm::vec3(0.1f, 0.35f, 0.12f), glm::vec3(0.2f, 0.55f, 0.2f));
+	append_cone(vertexData, indices, 8, 0.95f, 1.9f, 0.5f, 0.0f, glm::vec3(0.12f, 0.4f, 0.14f), glm::vec3(0.3f, 0.65f, 0.25f));
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <vector>
+#include <glad/glad.h>
+
+// asset id the demo tree species is registered under
+constexpr const char* DEMO_TREE_ASSET = "demo/tree";
+
+// procedural stand-in for a tree species: a tapered trunk under two stacked cone canopies,
+// interleaved position + color vertices in the layout MeshManager::create_mesh expects
+void build_demo_tree(std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices);
@@ -0,0 +1,396 @@
+#include "MeshManager.h"
+#include "MeshOptimizer.h"
+#include <log/Log.h>
+#include <log/GLDebug.h>
+#include <gl_state/GLStateCache.h>
+#include <utilities/Util.h>
+
+#include <algorithm>
+
+namespace {
+	constexpr GLuint VERTEX_FLOATS = VertexFormat::SOURCE_FLOATS;
+	// starting arena sizes, both double when a mesh does not fit
+	constexpr uint32_t INITIAL_VERTEX_CAPACITY = 64 * 1024;
+	constexpr uint32_t INITIAL_INDEX_CAPACITY = 192 * 1024;
+	constexpr uint32_t INITIAL_DECODE_CAPACITY = 256;
+
+	constexpr GLuint VERTEX_STREAM_BINDING = 0;
+}
+
+MeshManager::MeshManager() : m_dedupHits(0), m_cpuBytes(0), m_releaseFunction(nullptr), m_releaseData(nullptr), m_indexType(GL_UNSIGNED_SHORT), m_vertexArrayObject(0) {}
+
+MeshManager::~MeshManager() {
+	clear();
+}
+
+bool MeshManager::set_vertex_format(const VertexFormat& format) {
+	if (m_vertexArrayObject) {
+		UF_LOG_ERROR("the vertex format can not change once meshes live in the arenas");
+		return false;
+	}
+	m_vertexFormat = format;
+	return true;
+}
+
+bool MeshManager::set_index_type(GLenum indexType) {
+	if (m_vertexArrayObject) {
+		UF_LOG_ERROR("the index type can not change once meshes live in the arenas");
+		return false;
+	}
+	if (indexType != GL_UNSIGNED_SHORT && indexType != GL_UNSIGNED_INT) {
+		UF_LOG_ERROR("mesh indices are either GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, got 0x{:x}", indexType);
+		return false;
+	}
+	m_indexType = indexType;
+	return true;
+}
+
+bool MeshManager::create_arenas() {
+	if (!m_vertexArena.create(GL_ARRAY_BUFFER, INITIAL_VERTEX_CAPACITY * m_vertexFormat.get_stride(), GL_STATIC_DRAW)
+		|| !m_indexArena.create(GL_ELEMENT_ARRAY_BUFFER, INITIAL_INDEX_CAPACITY * get_index_size(), GL_STATIC_DRAW)
+		|| !m_decodeBuffer.create(GL_SHADER_STORAGE_BUFFER, INITIAL_DECODE_CAPACITY * sizeof(MeshDecodeData), GL_DYNAMIC_DRAW)) {
+		UF_LOG_ERROR("failed to create mesh arenas");
+		return false;
+	}
+	m_vertexArena.set_label("mesh vertex arena");
+	m_indexArena.set_label("mesh index arena");
+	m_decodeBuffer.set_label("mesh decode data");
+	m_vertexRanges = RangeAllocator(INITIAL_VERTEX_CAPACITY);
+	m_indexRanges = RangeAllocator(INITIAL_INDEX_CAPACITY);
+
+	// attribute formats are fixed, only the buffers behind them change when an arena grows
+	glCreateVertexArrays(1, &m_vertexArrayObject);
+	UF_GL_LABEL(GL_VERTEX_ARRAY, m_vertexArrayObject, "mesh arenas");
+	m_vertexFormat.apply(m_vertexArrayObject, VERTEX_STREAM_BINDING);
+	attach_buffers();
+	UF_LOG_INFO("mesh arenas store {} bytes per vertex and {} per index", m_vertexFormat.get_stride(), get_index_size());
+	CATCH_GL_ERROR("error creating mesh vao");
+	return true;
+}
+
+void MeshManager::attach_buffers() {
+	glVertexArrayVertexBuffer(m_vertexArrayObject, VERTEX_STREAM_BINDING, m_vertexArena.get_id(), 0, m_vertexFormat.get_stride());
+	// the index arena is only ever reached through the vao's element binding, never bound to the context
+	glVertexArrayElementBuffer(m_vertexArrayObject, m_indexArena.get_id());
+	m_decodeBuffer.bind_base(MESH_DECODE_BINDING);
+}
+
+void MeshManager::update_decode(const MeshId& id, const Mesh& mesh) {
+	size_t offset = static_cast<size_t>(id.index()) * sizeof(MeshDecodeData);
+	if (offset + sizeof(MeshDecodeData) > m_decodeBuffer.get_size()) {
+		size_t size = m_decodeBuffer.get_size();
+		while (offset + sizeof(MeshDecodeData) > size) {
+			size *= 2;
+		}
+		m_decodeBuffer.grow_preserving(size, m_decodeBuffer.get_size());
+		m_decodeBuffer.bind_base(MESH_DECODE_BINDING);
+	}
+	MeshDecodeData decode = m_vertexFormat.get_decode(mesh.m_boundsMin, mesh.m_boundsMax);
+	m_decodeBuffer.update(&decode, sizeof(decode), offset);
+}
+
+uint32_t MeshManager::allocate_range(RangeAllocator& ranges, GpuBuffer& buffer, uint32_t count, size_t elementSize) {
+	uint32_t offset = ranges.allocate(count);
+	while (offset == RangeAllocator::INVALID_OFFSET) {
+		uint32_t newCapacity = ranges.get_capacity() * 2;
+		if (newCapacity <= ranges.get_capacity()) {
+			return RangeAllocator::INVALID_OFFSET;
+		}
+		buffer.grow_preserving(newCapacity * elementSize, ranges.get_high_water_mark() * elementSize);
+		ranges.grow(newCapacity);
+		attach_buffers();
+		UF_LOG_DEBUG("mesh arena grown to {} elements", newCapacity);
+		offset = ranges.allocate(count);
+	}
+	return offset;
+}
+
+uint64_t MeshManager::hash_content(const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices) {
+	// sizes go in first so two meshes whose bytes only differ in how they split between the arrays can not collide
+	uint64_t sizes[2] = { vertexData.size(), indices.size() };
+	uint64_t hash = hash_fnv1a(sizes, sizeof(sizes));
+	hash = hash_fnv1a(vertexData.data(), vertexData.size() * sizeof(GLfloat), hash);
+	return hash_fnv1a(indices.data(), indices.size() * sizeof(GLuint), hash);
+}
+
+MeshId MeshManager::create_mesh(const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices, uint32_t flags) {
+	if (vertexData.empty() || vertexData.size() % VERTEX_FLOATS != 0 || indices.empty()) {
+		UF_LOG_ERROR("mesh needs whole position + color vertices and at least one index");
+		return MeshId();
+	}
+
+	uint64_t contentHash = hash_content(vertexData, indices);
+	MeshId id;
+	auto it = m_meshesByContent.find(contentHash);
+	const Mesh* existing = it != m_meshesByContent.end() ? m_meshes.get(it->second) : nullptr;
+	if (existing && existing->m_sourceFloatCount == vertexData.size() && existing->m_sourceIndexCount == indices.size()) {
+		id = it->second;
+		m_dedupHits++;
+	}
+	else {
+		if (existing) {
+			// a collision, the new mesh is uploaded on its own and the hash keeps answering with the first one
+			UF_LOG_WARN("mesh content hash collision, registering the mesh without dedup");
+		}
+		id = upload_mesh(vertexData, indices, contentHash);
+		if (!id.is_valid()) {
+			return id;
+		}
+		if (!existing) {
+			m_meshesByContent.emplace(contentHash, id);
+		}
+	}
+
+	Mesh& mesh = *m_meshes.get(id);
+	mesh.m_refCount++;
+	// an earlier registration may have dropped its copy, this one still has the data at hand
+	if ((flags & MESH_KEEP_CPU_COPY) && !mesh.m_cpuData) {
+		keep_cpu_copy(mesh, vertexData, indices);
+	}
+	return id;
+}
+
+MeshId MeshManager::create_mesh(std::string_view assetId, const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices, uint32_t flags) {
+	uint64_t assetHash = hash_fnv1a(assetId.data(), assetId.size());
+	auto it = m_meshesByAsset.find(assetHash);
+	if (it != m_meshesByAsset.end()) {
+		Mesh& mesh = *m_meshes.get(it->second);
+		mesh.m_refCount++;
+		m_dedupHits++;
+		if ((flags & MESH_KEEP_CPU_COPY) && !mesh.m_cpuData) {
+			keep_cpu_copy(mesh, vertexData, indices);
+		}
+		return it->second;
+	}
+
+	MeshId id = create_mesh(vertexData, indices, flags);
+	if (!id.is_valid()) {
+		return id;
+	}
+	// two asset ids with identical geometry share the mesh
+	m_meshesByAsset.emplace(assetHash, id);
+	m_meshes.get(id)->m_assetHashes.push_back(assetHash);
+	return id;
+}
+
+MeshId MeshManager::find_mesh(std::string_view assetId) const {
+	auto it = m_meshesByAsset.find(hash_fnv1a(assetId.data(), assetId.size()));
+	return it == m_meshesByAsset.end() ? MeshId() : it->second;
+}
+
+MeshId MeshManager::upload_mesh(const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices, uint64_t contentHash) {
+	if (!m_vertexArrayObject && !create_arenas()) {
+		return MeshId();
+	}
+
+	Mesh mesh;
+	mesh.m_contentHash = contentHash;
+	mesh.m_sourceFloatCount = static_cast<uint32_t>(vertexData.size());
+	mesh.m_sourceIndexCount = static_cast<uint32_t>(indices.size());
+	mesh.m_boundsMin = mesh.m_boundsMax = glm::vec3(vertexData[0], vertexData[1], vertexData[2]);
+	for (size_t i = VERTEX_FLOATS; i < vertexData.size(); i += VERTEX_FLOATS) {
+		glm::vec3 position(vertexData[i], vertexData[i + 1], vertexData[i + 2]);
+		mesh.m_boundsMin = glm::min(mesh.m_boundsMin, position);
+		mesh.m_boundsMax = glm::max(mesh.m_boundsMax, position);
+	}
+	if (!upload_lod(mesh.m_lods[0], mesh, vertexData, indices)) {
+		return MeshId();
+	}
+
+	MeshLod lod = mesh.m_lods[0];
+	MeshId id = m_meshes.emplace(std::move(mesh));
+	if (!id.is_valid()) {
+		UF_LOG_ERROR("mesh limit reached");
+		free_lod(lod);
+		return id;
+	}
+	update_decode(id, *m_meshes.get(id));
+	return id;
+}
+
+bool MeshManager::upload_lod(MeshLod& lod, const Mesh& mesh, const std::vector<GLfloat>& sourceVertices, const std::vector<GLuint>& sourceIndices) {
+	uint32_t sourceVertexCount = static_cast<uint32_t>(sourceVertices.size() / VERTEX_FLOATS);
+	if (std::any_of(sourceIndices.begin(), sourceIndices.end(), [sourceVertexCount](GLuint index) { return index >= sourceVertexCount; })) {
+		UF_LOG_ERROR("mesh indices reach past its {} vertices", sourceVertexCount);
+		return false;
+	}
+
+	// arrival order is whatever the importer / generator produced, reorder before anything reaches the gpu
+	std::vector<GLfloat> vertexData(sourceVertices);
+	std::vector<GLuint> indices(sourceIndices);
+	MeshOptimizeStats stats = MeshOptimizer::optimize(vertexData, indices);
+	UF_LOG_INFO("mesh optimized: {} -> {} vertices, {} -> {} triangles, acmr {:.3f} -> {:.3f}",
+		stats.m_vertexCountBefore,
+		stats.m_vertexCountAfter,
+		stats.m_triangleCountBefore,
+		stats.m_triangleCountAfter,
+		stats.m_acmrBefore,
+		stats.m_acmrAfter
+	);
+	if (indices.empty()) {
+		UF_LOG_ERROR("mesh has no triangles left once degenerate ones are dropped");
+		return false;
+	}
+	if (m_indexType == GL_UNSIGNED_SHORT && stats.m_vertexCountAfter > 0x10000u) {
+		UF_LOG_ERROR("mesh has {} vertices, too many for the 16 bit index arena, split it or switch the arena to 32 bit", stats.m_vertexCountAfter);
+		return false;
+	}
+
+	uint32_t stride = m_vertexFormat.get_stride();
+	size_t indexSize = get_index_size();
+	lod.m_vertexCount = stats.m_vertexCountAfter;
+	lod.m_indexCount = static_cast<GLsizei>(indices.size());
+	lod.m_baseVertex = allocate_range(m_vertexRanges, m_vertexArena, lod.m_vertexCount, stride);
+	lod.m_firstIndex = allocate_range(m_indexRanges, m_indexArena, static_cast<uint32_t>(indices.size()), indexSize);
+	if (lod.m_baseVertex == RangeAllocator::INVALID_OFFSET || lod.m_firstIndex == RangeAllocator::INVALID_OFFSET) {
+		UF_LOG_ERROR("mesh arenas are full");
+		if (lod.m_baseVertex != RangeAllocator::INVALID_OFFSET) {
+			m_vertexRanges.free(lod.m_baseVertex, lod.m_vertexCount);
+		}
+		if (lod.m_firstIndex != RangeAllocator::INVALID_OFFSET) {
+			m_indexRanges.free(lod.m_firstIndex, static_cast<uint32_t>(indices.size()));
+		}
+		return false;
+	}
+
+	// indices stay mesh relative, the draw's base vertex offsets them into the arena
+	std::vector<uint8_t> encoded;
+	m_vertexFormat.encode(vertexData, indices, mesh.m_boundsMin, mesh.m_boundsMax, encoded);
+	m_vertexArena.update(encoded.data(), encoded.size(), static_cast<size_t>(lod.m_baseVertex) * stride);
+	if (m_indexType == GL_UNSIGNED_SHORT) {
+		std::vector<uint16_t> narrowIndices(indices.begin(), indices.end());
+		m_indexArena.update(narrowIndices.data(), narrowIndices.size() * indexSize, lod.m_firstIndex * indexSize);
+	}
+	else {
+		m_indexArena.update(indices.data(), indices.size() * indexSize, lod.m_firstIndex * indexSize);
+	}
+	CATCH_GL_ERROR("error uploading mesh");
+	return true;
+}
+
+void MeshManager::free_lod(const MeshLod& lod) {
+	// the ranges are simply reused by later meshes, the arenas never shrink
+	m_vertexRanges.free(lod.m_baseVertex, lod.m_vertexCount);
+	m_indexRanges.free(lod.m_firstIndex, static_cast<uint32_t>(lod.m_indexCount));
+}
+
+bool MeshManager::add_lod(const MeshId& id, const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices, float screenSize) {
+	Mesh* mesh = m_meshes.get(id);
+	if (!mesh) {
+		UF_LOG_ERROR("can not add a lod to unknown mesh {}", id.m_value);
+		return false;
+	}
+	if (mesh->m_lodCount >= MAX_MESH_LODS) {
+		UF_LOG_ERROR("mesh {} already has the maximum of {} lods", id.m_value, MAX_MESH_LODS);
+		return false;
+	}
+	if (vertexData.empty() || vertexData.size() % VERTEX_FLOATS != 0 || indices.empty()) {
+		UF_LOG_ERROR("mesh lod needs whole position + color vertices and at least one index");
+		return false;
+	}
+	const MeshLod& coarsest = mesh->m_lods[mesh->m_lodCount - 1];
+	if (screenSize <= 0.0f || (mesh->m_lodCount > 1 && screenSize >= coarsest.m_screenSize)) {
+		UF_LOG_ERROR("lod {} of mesh {} needs a screen size below the previous level's, got {}", mesh->m_lodCount, id.m_value, screenSize);
+		return false;
+	}
+
+	// there is one position decode per mesh, so every level is quantized (and culled) against level 0's bounds,
+	// a level reaching outside them would be clamped flat, the tolerance absorbs simplifier rounding
+	glm::vec3 extent = mesh->m_boundsMax - mesh->m_boundsMin;
+	float tolerance = std::max({ extent.x, extent.y, extent.z }) * 1e-4f;
+	glm::vec3 lodMin = glm::vec3(vertexData[0], vertexData[1], vertexData[2]);
+	glm::vec3 lodMax = lodMin;
+	for (size_t i = VERTEX_FLOATS; i < vertexData.size(); i += VERTEX_FLOATS) {
+		glm::vec3 position(vertexData[i], vertexData[i + 1], vertexData[i + 2]);
+		lodMin = glm::min(lodMin, position);
+		lodMax = glm::max(lodMax, position);
+	}
+	for (int axis = 0; axis < 3; axis++) {
+		if (lodMin[axis] < mesh->m_boundsMin[axis] - tolerance || lodMax[axis] > mesh->m_boundsMax[axis] + tolerance) {
+			UF_LOG_ERROR("lod {} of mesh {} reaches outside the bounds of level 0", mesh->m_lodCount, id.m_value);
+			return false;
+		}
+	}
+
+	// uploading may grow an arena, which only moves gpu storage, the mesh pointer stays valid
+	MeshLod lod;
+	lod.m_screenSize = screenSize;
+	if (!upload_lod(lod, *mesh, vertexData, indices)) {
+		return false;
+	}
+	mesh->m_lods[mesh->m_lodCount++] = lod;
+	return true;
+}
+
+void MeshManager::keep_cpu_copy(Mesh& mesh, const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices) {
+	mesh.m_cpuData = std::make_unique<MeshCpuData>();
+	mesh.m_cpuData->m_positions.reserve(mesh.m_lods[0].m_vertexCount);
+	for (size_t i = 0; i < vertexData.size(); i += VERTEX_FLOATS) {
+		mesh.m_cpuData->m_positions.emplace_back(vertexData[i], vertexData[i + 1], vertexData[i + 2]);
+	}
+	mesh.m_cpuData->m_indices = indices;
+	m_cpuBytes += mesh.m_cpuData->m_positions.size() * sizeof(glm::vec3) + indices.size() * sizeof(GLuint);
+}
+
+const MeshCpuData* MeshManager::get_cpu_data(const MeshId& id) const {
+	const Mesh* mesh = m_meshes.get(id);
+	return mesh ? mesh->m_cpuData.get() : nullptr;
+}
+
+void MeshManager::add_ref(const MeshId& id) {
+	if (Mesh* mesh = m_meshes.get(id)) {
+		mesh->m_refCount++;
+	}
+}
+
+bool MeshManager::release_mesh(const MeshId& id) {
+	Mesh* mesh = m_meshes.get(id);
+	if (!mesh) {
+		return false;
+	}
+	if (--mesh->m_refCount > 0) {
+		return true;
+	}
+
+	// a mesh that lost a hash collision is not the one registered under its hash
+	auto it = m_meshesByContent.find(mesh->m_contentHash);
+	if (it != m_meshesByContent.end() && it->second == id) {
+		m_meshesByContent.erase(it);
+	}
+	// every asset id that resolved to this mesh goes with it
+	for (uint64_t assetHash : mesh->m_assetHashes) {
+		m_meshesByAsset.erase(assetHash);
+	}
+	if (mesh->m_cpuData) {
+		m_cpuBytes -= mesh->m_cpuData->m_positions.size() * sizeof(glm::vec3) + mesh->m_cpuData->m_indices.size() * sizeof(GLuint);
+	}
+	for (uint32_t lod = 0; lod < mesh->m_lodCount; lod++) {
+		free_lod(mesh->m_lods[lod]);
+	}
+	if (m_releaseFunction) {
+		m_releaseFunction(m_releaseData, id);
+	}
+	return m_meshes.erase(id);
+}
+
+void MeshManager::set_release_listener(MeshReleaseFunction function, void* data) {
+	m_releaseFunction = function;
+	m_releaseData = function ? data : nullptr;
+}
+
+void MeshManager::clear() {
+	m_meshes.clear();
+	m_meshesByContent.clear();
+	m_meshesByAsset.clear();
+	m_cpuBytes = 0;
+	if (m_vertexArrayObject) {
+		GLStateCache::get().forget_vertex_array(m_vertexArrayObject);
+		glDeleteVertexArrays(1, &m_vertexArrayObject);
+		m_vertexArrayObject = 0;
+	}
+	m_vertexArena.destroy();
+	m_indexArena.destroy();
+	m_decodeBuffer.destroy();
+	m_vertexRanges = RangeAllocator();
+	m_indexRanges = RangeAllocator();
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <gpu_buffer/GpuBuffer.h>
+#include <memory/RangeAllocator.h>
+#include <slot_map/SlotMap.h>
+#include "VertexFormat.h"
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+using MeshId = SlotHandle;
+// told about every mesh its last release freed, before the slot can be handed out again
+using MeshReleaseFunction = void (*)(void* data, const MeshId& mesh);
+
+enum MeshFlag : uint32_t {
+	// keep positions + indices in ram after upload, for meshes that collision or picking reads back
+	MESH_KEEP_CPU_COPY = 1 << 0,
+};
+
+// ram side copy of a mesh, only present when it was registered with MESH_KEEP_CPU_COPY
+struct MeshCpuData {
+	std::vector<glm::vec3> m_positions;
+	std::vector<GLuint> m_indices;
+};
+
+// detail levels per mesh, level 0 is the geometry the mesh was registered with
+constexpr uint32_t MAX_MESH_LODS = 4;
+
+// where one detail level of a mesh lives inside the shared vertex / index arenas
+struct MeshLod {
+	uint32_t m_baseVertex = 0;
+	uint32_t m_vertexCount = 0;
+	uint32_t m_firstIndex = 0;
+	GLsizei m_indexCount = 0;
+	// the level takes over once the projected bounding sphere diameter drops below this fraction of the
+	// viewport height, unused for level 0
+	float m_screenSize = 0.0f;
+};
+
+struct Mesh {
+	// finest first, screen sizes strictly decreasing
+	MeshLod m_lods[MAX_MESH_LODS];
+	uint32_t m_lodCount = 1;
+	// mesh space bounding box of level 0, what culling derives world bounds from
+	glm::vec3 m_boundsMin = glm::vec3(0.0f);
+	glm::vec3 m_boundsMax = glm::vec3(0.0f);
+
+	// registry keys, see MeshManager::create_mesh
+	uint64_t m_contentHash = 0;
+	// sizes of the registered geometry, a content hash hit only counts when they match as well
+	uint32_t m_sourceFloatCount = 0;
+	uint32_t m_sourceIndexCount = 0;
+	// every asset id that resolves to this mesh, so releasing it does not have to search the asset map
+	std::vector<uint64_t> m_assetHashes;
+	uint32_t m_refCount = 0;
+	std::unique_ptr<MeshCpuData> m_cpuData;
+};
+
+// owns mesh geometry on the gpu, every mesh is sub-allocated out of one shared vertex buffer and one shared
+// index buffer behind a single vao, so any mix of meshes can go out in one multi draw indirect call
+// a mesh is uploaded once and any number of render items reference it by id
+// the registry dedups by content hash (and optionally by asset id), so registering the same geometry twice
+// hands back the existing mesh, meshes are reference counted and their arena ranges freed on the last release
+// the cpu side vertex / index data is dropped once uploaded unless MESH_KEEP_CPU_COPY asks to keep it
+// vertices are stored in the manager's VertexFormat, shaders decode positions through the MESH_DECODE_BINDING stream
+class MeshManager {
+public:
+	MeshManager();
+	~MeshManager();
+
+	MeshManager(const MeshManager&) = delete;
+	MeshManager& operator=(const MeshManager&) = delete;
+
+	// every mesh shares the arena's format, so it can only be changed before the first mesh is created
+	bool set_vertex_format(const VertexFormat& format);
+	const VertexFormat& get_vertex_format(void) const { return m_vertexFormat; }
+	// GL_UNSIGNED_SHORT (default, meshes up to 65536 vertices since indices are mesh relative) or GL_UNSIGNED_INT,
+	// also only before the first mesh, every draw out of the arena uses this type
+	bool set_index_type(GLenum indexType);
+	GLenum get_index_type(void) const { return m_indexType; }
+	size_t get_index_size(void) const { return m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint); }
+
+	// interleaved position (xyz) + color (rgb) vertices, indices are relative to the mesh's first vertex
+	// every level is welded and reordered for the vertex cache / overdraw / fetch on upload, see MeshOptimizer
+	// returns a referenced mesh (new or an identical existing one) the caller has to release, invalid on failure
+	// the arenas are created on first use and need the gl context
+	MeshId create_mesh(const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices, uint32_t flags = 0);
+	// same but keyed by asset id as well, a known asset skips hashing the geometry entirely
+	MeshId create_mesh(std::string_view assetId, const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices, uint32_t flags = 0);
+	// looks up a registered asset without taking a reference, invalid if unknown
+	MeshId find_mesh(std::string_view assetId) const;
+	// appends a coarser level drawn once the mesh's screen size drops below screenSize, levels have to be added
+	// finest first with decreasing screen sizes, every item (and dedup sharer) of the mesh picks it up
+	// the level has to lie within level 0's bounds, which its positions are quantized and culled against
+	bool add_lod(const MeshId& id, const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices, float screenSize);
+
+	void add_ref(const MeshId& id);
+	// drops a reference, the mesh is freed when the last one goes, returns false for unknown ids
+	bool release_mesh(const MeshId& id);
+	// frees every mesh and the arenas regardless of references, needs the gl context
+	// nothing is reported to the release listener, whatever it keeps per mesh is torn down alongside
+	void clear(void);
+	// one listener, for state kept per mesh elsewhere (impostors), nullptr removes it
+	void set_release_listener(MeshReleaseFunction function, void* data);
+
+	const Mesh* get_mesh(const MeshId& id) const { return m_meshes.get(id); }
+	// nullptr unless the mesh was registered with MESH_KEEP_CPU_COPY
+	const MeshCpuData* get_cpu_data(const MeshId& id) const;
+	size_t get_mesh_count(void) const { return m_meshes.size(); }
+
+	// registrations answered by an existing mesh
+	uint64_t get_dedup_hits(void) const { return m_dedupHits; }
+	// ram still held by kept cpu copies
+	size_t get_cpu_bytes(void) const { return m_cpuBytes; }
+
+	// the one vao every mesh is drawn through, 0 until the first mesh is created
+	GLuint get_vertex_array(void) const { return m_vertexArrayObject; }
+
+private:
+	bool create_arenas(void);
+	// writes the mesh's position decode at its slot index, growing the stream as slots are added
+	void update_decode(const MeshId& id, const Mesh& mesh);
+	// grows the arena (keeping its contents) until count more elements fit, returns the allocated offset
+	uint32_t allocate_range(RangeAllocator& ranges, GpuBuffer& buffer, uint32_t count, size_t elementSize);
+	void attach_buffers(void);
+
+	MeshId upload_mesh(const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices, uint64_t contentHash);
+	// places one level's geometry in the arenas, false (with nothing allocated) if they are full
+	// every level is encoded against the mesh's level 0 bounds, which is what its decode describes
+	bool upload_lod(MeshLod& lod, const Mesh& mesh, const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices);
+	void free_lod(const MeshLod& lod);
+	void keep_cpu_copy(Mesh& mesh, const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices);
+	static uint64_t hash_content(const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices);
+
+	SlotMap<Mesh> m_meshes;
+	std::unordered_map<uint64_t, MeshId> m_meshesByContent;
+	std::unordered_map<uint64_t, MeshId> m_meshesByAsset;
+	uint64_t m_dedupHits;
+	size_t m_cpuBytes;
+	MeshReleaseFunction m_releaseFunction;
+	void* m_releaseData;
+
+	VertexFormat m_vertexFormat;
+	GLenum m_indexType;
+	GLuint m_vertexArrayObject;
+	GpuBuffer m_vertexArena;
+	GpuBuffer m_indexArena;
+	// in vertices / indices, not bytes
+	RangeAllocator m_vertexRanges;
+	RangeAllocator m_indexRanges;
+	GpuBuffer m_decodeBuffer;
+};
@@ -0,0 +1,280 @@
+#include "MeshOptimizer.h"
+#include "VertexFormat.h"
+#include <utilities/Util.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+	constexpr uint32_t FLOATS = VertexFormat::SOURCE_FLOATS;
+	constexpr uint32_t NO_VERTEX = 0xFFFFFFFFu;
+
+	// triangles around each vertex as one flat list, offsets[v] .. offsets[v + 1] index into triangles
+	struct Adjacency {
+		std::vector<uint32_t> m_offsets;
+		std::vector<uint32_t> m_triangles;
+	};
+
+	Adjacency build_adjacency(const std::vector<GLuint>& indices, uint32_t vertexCount) {
+		Adjacency adjacency;
+		adjacency.m_offsets.assign(vertexCount + 1, 0);
+		for (GLuint index : indices) {
+			adjacency.m_offsets[index + 1]++;
+		}
+		std::partial_sum(adjacency.m_offsets.begin(), adjacency.m_offsets.end(), adjacency.m_offsets.begin());
+		adjacency.m_triangles.resize(indices.size());
+		std::vector<uint32_t> cursor(adjacency.m_offsets.begin(), adjacency.m_offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++) {
+			adjacency.m_triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+		return adjacency;
+	}
+
+	glm::vec3 source_position(const std::vector<GLfloat>& vertexData, GLuint vertex) {
+		const GLfloat* source = &vertexData[static_cast<size_t>(vertex) * FLOATS];
+		return glm::vec3(source[0], source[1], source[2]);
+	}
+}
+
+MeshOptimizeStats MeshOptimizer::optimize(std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices) {
+	MeshOptimizeStats stats;
+	stats.m_vertexCountBefore = static_cast<uint32_t>(vertexData.size() / FLOATS);
+	stats.m_triangleCountBefore = static_cast<uint32_t>(indices.size() / 3);
+	stats.m_acmrBefore = compute_acmr(indices, stats.m_vertexCountBefore);
+
+	uint32_t vertexCount = weld_vertices(vertexData, indices);
+	std::vector<uint32_t> clusterStarts;
+	optimize_vertex_cache(indices, vertexCount, clusterStarts);
+	optimize_overdraw(vertexData, indices, clusterStarts);
+	vertexCount = optimize_vertex_fetch(vertexData, indices);
+
+	stats.m_vertexCountAfter = vertexCount;
+	stats.m_triangleCountAfter = static_cast<uint32_t>(indices.size() / 3);
+	stats.m_acmrAfter = compute_acmr(indices, vertexCount);
+	return stats;
+}
+
+uint32_t MeshOptimizer::weld_vertices(std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices) {
+	uint32_t vertexCount = static_cast<uint32_t>(vertexData.size() / FLOATS);
+	std::vector<GLuint> remap(vertexCount);
+	// hash buckets hold candidates, equality is still checked on the bytes so collisions never merge
+	std::unordered_multimap<uint64_t, GLuint> buckets;
+	buckets.reserve(vertexCount);
+	uint32_t uniqueCount = 0;
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+		const GLfloat* source = &vertexData[static_cast<size_t>(vertex) * FLOATS];
+		uint64_t hash = hash_fnv1a(source, FLOATS * sizeof(GLfloat));
+		GLuint match = NO_VERTEX;
+		auto range = buckets.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (std::memcmp(&vertexData[static_cast<size_t>(it->second) * FLOATS], source, FLOATS * sizeof(GLfloat)) == 0) {
+				match = it->second;
+				break;
+			}
+		}
+		if (match == NO_VERTEX) {
+			// compacting in place is safe, the write position never passes the read position
+			match = uniqueCount++;
+			std::memmove(&vertexData[static_cast<size_t>(match) * FLOATS], source, FLOATS * sizeof(GLfloat));
+			buckets.emplace(hash, match);
+		}
+		remap[vertex] = match;
+	}
+	vertexData.resize(static_cast<size_t>(uniqueCount) * FLOATS);
+
+	size_t kept = 0;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		GLuint a = remap[indices[i]];
+		GLuint b = remap[indices[i + 1]];
+		GLuint c = remap[indices[i + 2]];
+		if (a == b || b == c || a == c) {
+			continue;
+		}
+		indices[kept++] = a;
+		indices[kept++] = b;
+		indices[kept++] = c;
+	}
+	indices.resize(kept);
+	return uniqueCount;
+}
+
+void MeshOptimizer::optimize_vertex_cache(std::vector<GLuint>& indices, uint32_t vertexCount, std::vector<uint32_t>& clusterStarts) {
+	clusterStarts.clear();
+	uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	if (triangleCount == 0) {
+		return;
+	}
+	Adjacency adjacency = build_adjacency(indices, vertexCount);
+	std::vector<uint32_t> liveTriangles(vertexCount);
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+		liveTriangles[vertex] = adjacency.m_offsets[vertex + 1] - adjacency.m_offsets[vertex];
+	}
+	// a vertex is in the simulated fifo while timestamp - cacheTime <= CACHE_SIZE
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	std::vector<GLuint> deadEnds;
+	std::vector<GLuint> candidates;
+	std::vector<GLuint> output;
+	output.reserve(indices.size());
+	uint32_t timestamp = CACHE_SIZE + 1;
+	uint32_t cursor = 0;
+
+	// the first vertex with triangles left, scanning forward from where the last scan stopped
+	auto nextUnfinished = [&]() -> GLuint {
+		while (!deadEnds.empty()) {
+			GLuint vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[vertex] > 0) {
+				return vertex;
+			}
+		}
+		while (cursor < vertexCount) {
+			if (liveTriangles[cursor] > 0) {
+				return cursor;
+			}
+			cursor++;
+		}
+		return NO_VERTEX;
+	};
+
+	GLuint fan = nextUnfinished();
+	clusterStarts.push_back(0);
+	while (fan != NO_VERTEX) {
+		candidates.clear();
+		for (uint32_t i = adjacency.m_offsets[fan]; i < adjacency.m_offsets[fan + 1]; i++) {
+			uint32_t triangle = adjacency.m_triangles[i];
+			if (emitted[triangle]) {
+				continue;
+			}
+			emitted[triangle] = 1;
+			for (uint32_t corner = 0; corner < 3; corner++) {
+				GLuint vertex = indices[triangle * 3 + corner];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+				if (timestamp - cacheTime[vertex] > CACHE_SIZE) {
+					cacheTime[vertex] = timestamp++;
+				}
+			}
+		}
+
+		// prefer the candidate that stays in cache longest while still having triangles to fan,
+		// candidates that would fall out before their fan is done score lowest
+		GLuint best = NO_VERTEX;
+		int bestPriority = -1;
+		for (GLuint vertex : candidates) {
+			if (liveTriangles[vertex] == 0) {
+				continue;
+			}
+			int priority = 0;
+			if (timestamp - cacheTime[vertex] + 2 * liveTriangles[vertex] <= CACHE_SIZE) {
+				priority = static_cast<int>(timestamp - cacheTime[vertex]);
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				best = vertex;
+			}
+		}
+		if (best == NO_VERTEX) {
+			best = nextUnfinished();
+			// a jump away from the current neighbourhood, the next triangles start a new cluster
+			if (best != NO_VERTEX) {
+				clusterStarts.push_back(static_cast<uint32_t>(output.size() / 3));
+			}
+		}
+		fan = best;
+	}
+	indices.swap(output);
+}
+
+void MeshOptimizer::optimize_overdraw(const std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices, const std::vector<uint32_t>& clusterStarts) {
+	uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	uint32_t clusterCount = static_cast<uint32_t>(clusterStarts.size());
+	if (clusterCount < 2) {
+		return;
+	}
+
+	// area weighted centroid of the whole mesh and of every cluster, plus each cluster's summed normal
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+	for (uint32_t cluster = 0; cluster < clusterCount; cluster++) {
+		uint32_t end = cluster + 1 < clusterCount ? clusterStarts[cluster + 1] : triangleCount;
+		float clusterArea = 0.0f;
+		for (uint32_t triangle = clusterStarts[cluster]; triangle < end; triangle++) {
+			glm::vec3 v0 = source_position(vertexData, indices[triangle * 3]);
+			glm::vec3 v1 = source_position(vertexData, indices[triangle * 3 + 1]);
+			glm::vec3 v2 = source_position(vertexData, indices[triangle * 3 + 2]);
+			glm::vec3 normal = glm::cross(v1 - v0, v2 - v0);
+			float area = glm::length(normal) * 0.5f;
+			glm::vec3 center = (v0 + v1 + v2) * (1.0f / 3.0f);
+			centroids[cluster] += center * area;
+			normals[cluster] += normal;
+			clusterArea += area;
+		}
+		meshCentroid += centroids[cluster];
+		meshArea += clusterArea;
+		centroids[cluster] = clusterArea > 0.0f ? centroids[cluster] / clusterArea : centroids[cluster];
+	}
+	if (meshArea > 0.0f) {
+		meshCentroid = meshCentroid / meshArea;
+	}
+
+	// clusters on the outside facing outwards occlude the rest from most directions, draw those first
+	std::vector<float> scores(clusterCount);
+	std::vector<uint32_t> order(clusterCount);
+	for (uint32_t cluster = 0; cluster < clusterCount; cluster++) {
+		float length = glm::length(normals[cluster]);
+		scores[cluster] = length > 0.0f ? glm::dot(centroids[cluster] - meshCentroid, normals[cluster] / length) : 0.0f;
+		order[cluster] = cluster;
+	}
+	std::stable_sort(order.begin(), order.end(), [&scores](uint32_t a, uint32_t b) {
+		return scores[a] > scores[b];
+	});
+
+	std::vector<GLuint> sorted;
+	sorted.reserve(indices.size());
+	for (uint32_t cluster : order) {
+		uint32_t end = cluster + 1 < clusterCount ? clusterStarts[cluster + 1] : triangleCount;
+		sorted.insert(sorted.end(), indices.begin() + clusterStarts[cluster] * 3, indices.begin() + end * 3);
+	}
+	indices.swap(sorted);
+}
+
+uint32_t MeshOptimizer::optimize_vertex_fetch(std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices) {
+	uint32_t vertexCount = static_cast<uint32_t>(vertexData.size() / FLOATS);
+	std::vector<GLuint> remap(vertexCount, NO_VERTEX);
+	std::vector<GLfloat> reordered;
+	reordered.reserve(vertexData.size());
+	uint32_t nextVertex = 0;
+	for (GLuint& index : indices) {
+		if (remap[index] == NO_VERTEX) {
+			remap[index] = nextVertex++;
+			const GLfloat* source = &vertexData[static_cast<size_t>(index) * FLOATS];
+			reordered.insert(reordered.end(), source, source + FLOATS);
+		}
+		index = remap[index];
+	}
+	vertexData.swap(reordered);
+	return nextVertex;
+}
+
+float MeshOptimizer::compute_acmr(const std::vector<GLuint>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+	if (indices.size() < 3) {
+		return 0.0f;
+	}
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+	uint32_t misses = 0;
+	for (GLuint index : indices) {
+		if (timestamp - cacheTime[index] > cacheSize) {
+			cacheTime[index] = timestamp++;
+			misses++;
+		}
+	}
+	return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+
+// what one optimize pass changed, acmr is post-transform cache misses per triangle (0.5 is ideal for large
+// regular meshes, 3 means no reuse at all), measured with a fifo cache of MeshOptimizer::CACHE_SIZE entries
+struct MeshOptimizeStats {
+	uint32_t m_vertexCountBefore = 0;
+	uint32_t m_vertexCountAfter = 0;
+	uint32_t m_triangleCountBefore = 0;
+	uint32_t m_triangleCountAfter = 0;
+	float m_acmrBefore = 0.0f;
+	float m_acmrAfter = 0.0f;
+};
+
+// reorders mesh geometry before it goes to the gpu, on interleaved position (xyz) + color (rgb) source vertices:
+// welds duplicate vertices, orders triangles for the post-transform cache (tipsify), sorts the resulting
+// clusters so outward facing ones draw first (less overdraw) and renumbers vertices in first use order
+class MeshOptimizer {
+public:
+	static constexpr uint32_t CACHE_SIZE = 16;
+
+	// runs every stage in order, indices have to be in range
+	static MeshOptimizeStats optimize(std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices);
+
+	// merges bitwise identical vertices and drops the triangles that collapse, returns the new vertex count
+	static uint32_t weld_vertices(std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices);
+	// tipsify (sander et al. 2007), clusterStarts receives the first triangle of every run that started
+	// away from the previous one, which is where the overdraw pass may cut
+	static void optimize_vertex_cache(std::vector<GLuint>& indices, uint32_t vertexCount, std::vector<uint32_t>& clusterStarts);
+	// orders clusters by how far they face away from the mesh center, outermost first
+	static void optimize_overdraw(const std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices, const std::vector<uint32_t>& clusterStarts);
+	// renumbers vertices in the order the indices first reach them, unreferenced vertices are dropped
+	static uint32_t optimize_vertex_fetch(std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices);
+
+	static float compute_acmr(const std::vector<GLuint>& indices, uint32_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+};
@@ -0,0 +1,187 @@
+#include "VertexFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+	// ieee half with round to nearest, overflow goes to infinity and tiny values through the subnormals to 0
+	uint16_t float_to_half(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000u;
+		uint32_t floatExponent = (bits >> 23) & 0xFFu;
+		uint32_t mantissa = bits & 0x7FFFFFu;
+		if (floatExponent == 0xFFu) {
+			return static_cast<uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+		}
+		int32_t exponent = static_cast<int32_t>(floatExponent) - 127 + 15;
+		if (exponent >= 31) {
+			return static_cast<uint16_t>(sign | 0x7C00u);
+		}
+		if (exponent <= 0) {
+			if (exponent < -10) {
+				return static_cast<uint16_t>(sign);
+			}
+			mantissa |= 0x800000u;
+			uint32_t shift = static_cast<uint32_t>(14 - exponent);
+			uint32_t half = mantissa >> shift;
+			half += (mantissa >> (shift - 1)) & 1u;
+			return static_cast<uint16_t>(sign | half);
+		}
+		// a rounding carry out of the mantissa correctly bumps the exponent
+		uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+		half += (mantissa >> 12) & 1u;
+		return static_cast<uint16_t>(half);
+	}
+
+	uint16_t quantize_unorm16(float value, float min, float extent) {
+		if (extent <= 0.0f) {
+			return 0;
+		}
+		float normalized = std::clamp((value - min) / extent, 0.0f, 1.0f);
+		return static_cast<uint16_t>(std::lround(normalized * 65535.0f));
+	}
+
+	uint32_t pack_snorm10(float value) {
+		return static_cast<uint32_t>(static_cast<int32_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 511.0f))) & 0x3FFu;
+	}
+
+	// area weighted vertex normals, the cross product's length already is twice the triangle's area
+	std::vector<glm::vec3> smooth_normals(const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices) {
+		size_t vertexCount = vertexData.size() / VertexFormat::SOURCE_FLOATS;
+		std::vector<glm::vec3> normals(vertexCount, glm::vec3(0.0f));
+		auto position = [&vertexData](GLuint vertex) {
+			const GLfloat* source = &vertexData[static_cast<size_t>(vertex) * VertexFormat::SOURCE_FLOATS];
+			return glm::vec3(source[0], source[1], source[2]);
+		};
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount) {
+				continue;
+			}
+			glm::vec3 v0 = position(indices[i]);
+			glm::vec3 faceNormal = glm::cross(position(indices[i + 1]) - v0, position(indices[i + 2]) - v0);
+			normals[indices[i]] += faceNormal;
+			normals[indices[i + 1]] += faceNormal;
+			normals[indices[i + 2]] += faceNormal;
+		}
+		for (glm::vec3& normal : normals) {
+			float length = glm::length(normal);
+			normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+		}
+		return normals;
+	}
+}
+
+VertexFormat::VertexFormat(PositionEncoding position, NormalEncoding normal, ColorEncoding color)
+	: m_position(position), m_normal(normal), m_color(color), m_attributes{}, m_attributeCount(0), m_stride(0) {
+	// every attribute starts 4 byte aligned, the 3 component 16 bit types get a padding component
+	switch (m_position) {
+	case PositionEncoding::FLOAT32:
+		m_attributes[m_attributeCount++] = { ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, m_stride };
+		m_stride += 12;
+		break;
+	case PositionEncoding::HALF_FLOAT:
+		m_attributes[m_attributeCount++] = { ATTRIBUTE_POSITION, 3, GL_HALF_FLOAT, GL_FALSE, m_stride };
+		m_stride += 8;
+		break;
+	case PositionEncoding::UNORM16:
+		m_attributes[m_attributeCount++] = { ATTRIBUTE_POSITION, 3, GL_UNSIGNED_SHORT, GL_TRUE, m_stride };
+		m_stride += 8;
+		break;
+	}
+	switch (m_color) {
+	case ColorEncoding::FLOAT32:
+		m_attributes[m_attributeCount++] = { ATTRIBUTE_COLOR, 3, GL_FLOAT, GL_FALSE, m_stride };
+		m_stride += 12;
+		break;
+	case ColorEncoding::UNORM8:
+		m_attributes[m_attributeCount++] = { ATTRIBUTE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, m_stride };
+		m_stride += 4;
+		break;
+	}
+	switch (m_normal) {
+	case NormalEncoding::NONE:
+		break;
+	case NormalEncoding::FLOAT32:
+		m_attributes[m_attributeCount++] = { ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, m_stride };
+		m_stride += 12;
+		break;
+	case NormalEncoding::INT_2_10_10_10:
+		m_attributes[m_attributeCount++] = { ATTRIBUTE_NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE, m_stride };
+		m_stride += 4;
+		break;
+	}
+}
+
+void VertexFormat::apply(GLuint vertexArray, GLuint binding) const {
+	for (uint32_t i = 0; i < m_attributeCount; i++) {
+		const VertexAttribute& attribute = m_attributes[i];
+		glEnableVertexArrayAttrib(vertexArray, attribute.m_location);
+		glVertexArrayAttribFormat(vertexArray, attribute.m_location, attribute.m_size, attribute.m_type, attribute.m_normalized, attribute.m_offset);
+		glVertexArrayAttribBinding(vertexArray, attribute.m_location, binding);
+	}
+}
+
+void VertexFormat::encode(const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices, const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<uint8_t>& out) const {
+	size_t vertexCount = vertexData.size() / SOURCE_FLOATS;
+	out.assign(vertexCount * m_stride, 0);
+	std::vector<glm::vec3> normals;
+	if (m_normal != NormalEncoding::NONE) {
+		normals = smooth_normals(vertexData, indices);
+	}
+	glm::vec3 extent = boundsMax - boundsMin;
+
+	for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+		const GLfloat* source = &vertexData[vertex * SOURCE_FLOATS];
+		uint8_t* record = &out[vertex * m_stride];
+		for (uint32_t i = 0; i < m_attributeCount; i++) {
+			const VertexAttribute& attribute = m_attributes[i];
+			uint8_t* destination = record + attribute.m_offset;
+			if (attribute.m_location == ATTRIBUTE_POSITION) {
+				if (m_position == PositionEncoding::FLOAT32) {
+					std::memcpy(destination, source, 3 * sizeof(GLfloat));
+				}
+				else {
+					uint16_t packed[3];
+					for (int axis = 0; axis < 3; axis++) {
+						packed[axis] = m_position == PositionEncoding::HALF_FLOAT
+							? float_to_half(source[axis])
+							: quantize_unorm16(source[axis], boundsMin[axis], extent[axis]);
+					}
+					std::memcpy(destination, packed, sizeof(packed));
+				}
+			}
+			else if (attribute.m_location == ATTRIBUTE_COLOR) {
+				if (m_color == ColorEncoding::FLOAT32) {
+					std::memcpy(destination, source + 3, 3 * sizeof(GLfloat));
+				}
+				else {
+					for (int channel = 0; channel < 3; channel++) {
+						destination[channel] = static_cast<uint8_t>(std::lround(std::clamp(source[3 + channel], 0.0f, 1.0f) * 255.0f));
+					}
+					destination[3] = 255;
+				}
+			}
+			else {
+				const glm::vec3& normal = normals[vertex];
+				if (m_normal == NormalEncoding::FLOAT32) {
+					GLfloat unpacked[3] = { normal.x, normal.y, normal.z };
+					std::memcpy(destination, unpacked, sizeof(unpacked));
+				}
+				else {
+					uint32_t packed = pack_snorm10(normal.x) | (pack_snorm10(normal.y) << 10) | (pack_snorm10(normal.z) << 20);
+					std::memcpy(destination, &packed, sizeof(packed));
+				}
+			}
+		}
+	}
+}
+
+MeshDecodeData VertexFormat::get_decode(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const {
+	// normalized unorm16 arrives in the shader as 0..1 across the bounds, the other encodings are absolute
+	if (m_position == PositionEncoding::UNORM16) {
+		return { glm::vec4(boundsMin, 0.0f), glm::vec4(boundsMax - boundsMin, 0.0f) };
+	}
+	return { glm::vec4(0.0f), glm::vec4(1.0f, 1.0f, 1.0f, 0.0f) };
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// vertex attribute locations shared by the mesh vao and the shaders
+constexpr GLuint ATTRIBUTE_POSITION = 0;
+constexpr GLuint ATTRIBUTE_COLOR = 1;
+constexpr GLuint ATTRIBUTE_NORMAL = 2;
+
+// shader storage binding of the per-mesh position decode, indexed by mesh id index
+constexpr unsigned int MESH_DECODE_BINDING = 7;
+
+// std430 per-mesh entry, the vertex shader rebuilds positions as offset + stored * scale
+struct MeshDecodeData {
+	glm::vec4 m_positionOffset;
+	glm::vec4 m_positionScale;
+};
+
+static_assert(sizeof(MeshDecodeData) == 32, "MeshDecodeData must match the std430 decode layout");
+
+enum class PositionEncoding : uint8_t {
+	FLOAT32, // 12 bytes
+	HALF_FLOAT, // 8 bytes, absolute, about 3 significant digits so only for meshes modelled around their origin
+	UNORM16, // 8 bytes, quantized across the mesh bounds, 1/65535 of its extent per step
+};
+
+enum class NormalEncoding : uint8_t {
+	NONE,
+	FLOAT32, // 12 bytes
+	INT_2_10_10_10, // 4 bytes, GL_INT_2_10_10_10_REV signed normalized
+};
+
+enum class ColorEncoding : uint8_t {
+	FLOAT32, // 12 bytes
+	UNORM8, // 4 bytes, alpha is padding
+};
+
+// one attribute of the interleaved record, in glVertexAttribFormat terms
+struct VertexAttribute {
+	GLuint m_location;
+	GLint m_size;
+	GLenum m_type;
+	GLboolean m_normalized;
+	GLuint m_offset;
+};
+
+// how vertices are laid out in the mesh arena, built from one encoding per attribute
+// meshes are always handed over as interleaved position (xyz) + color (rgb) floats and encoded on upload
+class VertexFormat {
+public:
+	static constexpr uint32_t MAX_ATTRIBUTES = 3;
+	// floats per source vertex handed to MeshManager
+	static constexpr uint32_t SOURCE_FLOATS = 6;
+
+	// the default packs a vertex into 12 bytes, half of the plain float layout
+	VertexFormat(PositionEncoding position = PositionEncoding::UNORM16, NormalEncoding normal = NormalEncoding::NONE, ColorEncoding color = ColorEncoding::UNORM8);
+
+	// sets every attribute's format and binding on the vao, the buffer itself is attached separately
+	void apply(GLuint vertexArray, GLuint binding) const;
+	// packs source vertices into stride sized records, quantized positions are mapped across [boundsMin, boundsMax]
+	// the source carries no normals, formats with normals get them smoothed from the triangles
+	void encode(const std::vector<GLfloat>& vertexData, const std::vector<GLuint>& indices, const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<uint8_t>& out) const;
+	// what the vertex shader needs to turn a stored position of a mesh with these bounds back into mesh space
+	MeshDecodeData get_decode(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+	PositionEncoding get_position_encoding(void) const { return m_position; }
+	NormalEncoding get_normal_encoding(void) const { return m_normal; }
+	ColorEncoding get_color_encoding(void) const { return m_color; }
+	uint32_t get_stride(void) const { return m_stride; }
+	uint32_t get_attribute_count(void) const { return m_attributeCount; }
+	const VertexAttribute& get_attribute(uint32_t index) const { return m_attributes[index]; }
+
+private:
+	PositionEncoding m_position;
+	NormalEncoding m_normal;
+	ColorEncoding m_color;
+	VertexAttribute m_attributes[MAX_ATTRIBUTES];
+	uint32_t m_attributeCount;
+	uint32_t m_stride;
+};
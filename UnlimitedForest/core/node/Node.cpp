@@ -1,11 +1,12 @@
 #include "Node.h"
 
-Node::Node(const uint8_t& id) {
+Node::Node(const NodeId& id, ChunkId chunk) {
 	m_id = id;
+	m_chunk = chunk;
 }
 
 Node::~Node() {}
 
-uint8_t Node::get_id() {
+NodeId Node::get_id() {
 	return m_id;
 }
@@ -1,17 +1,24 @@
 #pragma once
 
+#include <slot_map/SlotMap.h>
+
 #include <cstdint>
 
+// nodes are addressed by generational slot map handles so ids can be recycled safely
+using NodeId = SlotHandle;
+
+// streaming chunk a node belongs to, nodes in a chunk are allocated together and released together
+using ChunkId = uint32_t;
+constexpr ChunkId PERSISTENT_CHUNK = 0;
+
 class Node {
 public:
-	Node(const uint8_t &id);
+	Node(const NodeId &id, ChunkId chunk = PERSISTENT_CHUNK);
 	virtual ~Node();
 
-	// game loop update function to be inherited by node parent classes
-	// this is to avoid dynamically casting every time I want to reference a node
-	virtual void update(void) {};
-
-	uint8_t get_id(void);
+	NodeId get_id(void);
+	ChunkId get_chunk(void) const { return m_chunk; }
 private:
-	uint8_t m_id;
+	NodeId m_id;
+	ChunkId m_chunk;
 };
@@ -1,75 +1,177 @@
 #include "NodeManager.h"
-#include <camera/Camera.h>
-#include <render_item/RenderItem.h>
 #include <log/Log.h>
 
-NodeManager::NodeManager() {}
+NodeManager::NodeManager(MeshManager* meshManager, JobSystem* jobSystem) : m_meshManager(meshManager), m_jobSystem(jobSystem) {}
 
 NodeManager::~NodeManager() {
-	for (int i = 0, s = m_nodes.size(); i < s; i++) {
-		delete m_nodes[i];
-	}
+	clear();
 }
 
-bool NodeManager::update() {
-	for (Node* node : m_nodes) {
-		node->update();
+void NodeManager::clear() {
+	// pools run the destructors and free their blocks in bulk
+	m_cameraPool.release_all();
+	for (auto& [chunk, pool] : m_renderItemPools) {
+		delete pool;
 	}
-	return true;
+	m_renderItemPools.clear();
+	m_nodes.clear();
+	m_selectedCamera = nullptr;
+	m_selectedRenderItem = nullptr;
 }
 
-uint8_t NodeManager::create_id() {
-	return m_nodes.size();
+bool NodeManager::update() {
+	// linear passes over the component pools rather than a virtual update per node
+	m_componentStore.update_transforms(m_jobSystem);
+	return true;
 }
 
-uint8_t NodeManager::create_camera() {
-	uint8_t newId = create_id();
-	Camera* newCam = new Camera(newId);
-	m_nodes.emplace_back(newCam);
-	m_cameras.emplace_back(newId);
+NodeId NodeManager::create_camera() {
+	// reserve the slot first so the node can be constructed knowing its id
+	NodeId newId = m_nodes.insert(nullptr);
+	if (!newId.is_valid()) {
+		UF_LOG_ERROR("node limit reached, could not create camera");
+		return newId;
+	}
+	Camera* newCam = m_cameraPool.create(newId);
+	*m_nodes.get(newId) = newCam;
 	if (!m_selectedCamera) {
 		m_selectedCamera = newCam;
 	}
 	return newId;
 }
 
-uint8_t NodeManager::create_camera(const glm::vec3& eye, const glm::vec3& viewDirection, const glm::vec3& up) {
-	uint8_t newId = create_id();
-	Camera* newCam = new Camera(newId, eye, viewDirection, up);
-	m_nodes.emplace_back(newCam);
-	m_cameras.emplace_back(newId);
+NodeId NodeManager::create_camera(const glm::vec3& eye, const glm::vec3& viewDirection, const glm::vec3& up) {
+	NodeId newId = m_nodes.insert(nullptr);
+	if (!newId.is_valid()) {
+		UF_LOG_ERROR("node limit reached, could not create camera");
+		return newId;
+	}
+	Camera* newCam = m_cameraPool.create(newId, eye, viewDirection, up);
+	*m_nodes.get(newId) = newCam;
 	if (!m_selectedCamera) {
 		m_selectedCamera = newCam;
 	}
 	return newId;
 }
 
-uint8_t NodeManager::create_render_item(
-	std::vector<GLfloat> vertexData, 
-	std::vector<GLuint> vertexIdxs,
+NodeId NodeManager::create_render_item(
+	const std::vector<GLfloat>& vertexData, 
+	const std::vector<GLuint>& vertexIdxs,
 	const glm::vec3& worldPosition, 
 	const glm::vec3& rotation, 
-	const glm::vec3& scale
+	const glm::vec3& scale,
+	ChunkId chunk
 ) {
-	uint8_t newId = create_id();
-	RenderItem* newRI = new RenderItem(newId, vertexData, vertexIdxs, worldPosition, rotation, scale);
-	m_nodes.emplace_back(newRI);
-	m_renderItems.emplace_back(newId);
+	// identical geometry resolves to the already registered mesh, the item takes its own reference
+	MeshId mesh = m_meshManager->create_mesh(vertexData, vertexIdxs);
+	if (!mesh.is_valid()) {
+		UF_LOG_ERROR("could not create render item mesh");
+		return NodeId();
+	}
+	NodeId newId = create_render_item(mesh, worldPosition, rotation, scale, glm::vec4(1.0f), chunk);
+	m_meshManager->release_mesh(mesh);
+	return newId;
+}
+
+NodeId NodeManager::create_render_item(
+	const MeshId& mesh,
+	const glm::vec3& worldPosition,
+	const glm::vec3& rotation,
+	const glm::vec3& scale,
+	const glm::vec4& color,
+	ChunkId chunk
+) {
+	if (!m_meshManager->get_mesh(mesh)) {
+		UF_LOG_ERROR("mesh with id: {} not found", mesh.m_value);
+		return NodeId();
+	}
+	NodeId newId = m_nodes.insert(nullptr);
+	if (!newId.is_valid()) {
+		UF_LOG_ERROR("node limit reached, could not create render item");
+		return newId;
+	}
+	RenderItem* newRI = get_render_item_pool(chunk).create(newId, &m_componentStore, m_meshManager, mesh, worldPosition, rotation, scale, color, chunk);
+	*m_nodes.get(newId) = newRI;
 	if (!m_selectedRenderItem) {
 		m_selectedRenderItem = newRI;
 	}
 	return newId;
 }
 
-bool NodeManager::select_camera(const uint8_t& id) {
-	Camera* selectedCamera = nullptr;
-	try {
-		selectedCamera = dynamic_cast<Camera*>(m_nodes.at(id));
+bool NodeManager::set_parent(const NodeId& child, const NodeId& parent) {
+	return m_componentStore.set_parent(child, parent);
+}
+
+bool NodeManager::destroy_node(const NodeId& id) {
+	Node** node = m_nodes.get(id);
+	if (!node) {
+		UF_LOG_ERROR("node with id: {} not found", id.m_value);
+		return false;
+	}
+	Node* doomed = *node;
+	m_nodes.erase(id);
+
+	// move selection off the node before it is freed
+	if (doomed == m_selectedCamera) {
+		m_selectedCamera = find_next_node_of_type<Camera>(doomed);
+	}
+	if (doomed == m_selectedRenderItem) {
+		m_selectedRenderItem = find_next_node_of_type<RenderItem>(doomed);
 	}
-	catch (const std::out_of_range& e) {
-		UF_LOG_ERROR("camera with id: {} not found", id);
+
+	if (Camera* camera = dynamic_cast<Camera*>(doomed)) {
+		m_cameraPool.destroy(camera);
+	}
+	else if (RenderItem* renderItem = dynamic_cast<RenderItem*>(doomed)) {
+		get_render_item_pool(renderItem->get_chunk()).destroy(renderItem);
+	}
+	return true;
+}
+
+void NodeManager::unload_chunk(ChunkId chunk) {
+	auto it = m_renderItemPools.find(chunk);
+	if (it == m_renderItemPools.end()) {
+		return;
+	}
+	PoolAllocator<RenderItem>* pool = it->second;
+
+	// retire the ids first, the pool then destroys every item and frees its blocks at once
+	pool->for_each([this](RenderItem* renderItem) {
+		m_nodes.erase(renderItem->get_id());
+	});
+	if (m_selectedRenderItem && m_selectedRenderItem->get_chunk() == chunk) {
+		m_selectedRenderItem = nullptr;
+		m_selectedRenderItem = find_next_node_of_type<RenderItem>(nullptr);
+	}
+	UF_LOG_INFO("unloading chunk {} ({} render items)", chunk, pool->get_live_count());
+	delete pool;
+	m_renderItemPools.erase(it);
+}
+
+PoolAllocator<RenderItem>& NodeManager::get_render_item_pool(ChunkId chunk) {
+	PoolAllocator<RenderItem>*& pool = m_renderItemPools[chunk];
+	if (pool == nullptr) {
+		pool = new PoolAllocator<RenderItem>();
+	}
+	return *pool;
+}
+
+Node* NodeManager::get_node(const NodeId& id) {
+	Node** node = m_nodes.get(id);
+	return node ? *node : nullptr;
+}
+
+size_t NodeManager::get_node_count() const {
+	return m_nodes.size();
+}
+
+bool NodeManager::select_camera(const NodeId& id) {
+	Node* node = get_node(id);
+	if (node == nullptr) {
+		UF_LOG_ERROR("camera with id: {} not found", id.m_value);
 		return false;
 	}
+	Camera* selectedCamera = dynamic_cast<Camera*>(node);
 	if (selectedCamera == nullptr) {
 		UF_LOG_ERROR("selected node was not of type Camera");
 		return false;
@@ -79,39 +181,22 @@ bool NodeManager::select_camera(const uint8_t& id) {
 }
 
 bool NodeManager::select_next_camera() {
+	Camera* next = find_next_node_of_type<Camera>(m_selectedCamera);
 	// no cameras currently initialized, break early
-	if (m_cameras.size() == 0) {
+	if (next == nullptr) {
 		UF_LOG_ERROR("no camera to select");
 		return false;
 	}
-
-	uint8_t cameraId = m_selectedCamera->get_id();
-	int nextId = 0;
-
-	for (int i = 0, s = m_cameras.size(); i < s; i++) {
-		if (m_cameras[i] == cameraId) {
-			// if at end of list, set camera to beginning cam
-			if (i + 1 == s) {
-				nextId = 0;
-			}
-			else {
-				nextId = i + 1;
-			}
-		}
-	}
-
-	return select_camera(nextId);
+	return select_camera(next->get_id());
 }
 
-bool NodeManager::select_render_item(const uint8_t& id) {
-	RenderItem* selectedRenderItem = nullptr;
-	try {
-		selectedRenderItem = dynamic_cast<RenderItem*>(m_nodes.at(id));
-	}
-	catch (const std::out_of_range& e) {
-		UF_LOG_ERROR("camera with id: {} not found", id);
+bool NodeManager::select_render_item(const NodeId& id) {
+	Node* node = get_node(id);
+	if (node == nullptr) {
+		UF_LOG_ERROR("render item with id: {} not found", id.m_value);
 		return false;
 	}
+	RenderItem* selectedRenderItem = dynamic_cast<RenderItem*>(node);
 	if (selectedRenderItem == nullptr) {
 		UF_LOG_ERROR("selected node was not of type RenderItem");
 		return false;
@@ -121,28 +206,44 @@ bool NodeManager::select_render_item(const uint8_t& id) {
 }
 
 bool NodeManager::select_next_render_item() {
+	RenderItem* next = find_next_node_of_type<RenderItem>(m_selectedRenderItem);
 	// no renderItems currently initialized, break early
-	if (m_renderItems.size() == 0) {
+	if (next == nullptr) {
 		UF_LOG_ERROR("no renderItem to select");
 		return false;
 	}
+	return select_render_item(next->get_id());
+}
 
-	uint8_t renderItemId = m_selectedRenderItem->get_id();
-	int nextId = 0;
+template<typename T>
+T* NodeManager::find_next_node_of_type(Node* current) {
+	size_t count = m_nodes.size();
+	if (count == 0) {
+		return nullptr;
+	}
 
-	for (int i = 0, s = m_cameras.size(); i < s; i++) {
-		if (m_cameras[i] == renderItemId) {
-			// if at end of list, set render_item to beginning render_item
-			if (i + 1 == s) {
-				nextId = 0;
-			}
-			else {
-				nextId = i + 1;
+	// start just after the current node, or at the front if it is no longer stored
+	size_t start = 0;
+	if (current) {
+		for (size_t i = 0; i < count; i++) {
+			if (m_nodes[i] == current) {
+				start = i + 1;
+				break;
 			}
 		}
 	}
 
-	return select_render_item(nextId);
+	for (size_t n = 0; n < count; n++) {
+		Node* candidate = m_nodes[(start + n) % count];
+		if (candidate == current) {
+			continue;
+		}
+		if (T* typed = dynamic_cast<T*>(candidate)) {
+			return typed;
+		}
+	}
+	// current is the only node of its type, keep it if it is still alive
+	return (current && m_nodes.get(current->get_id())) ? dynamic_cast<T*>(current) : nullptr;
 }
 
 Camera* NodeManager::get_camera() {
@@ -1,46 +1,93 @@
 #pragma once
 #include <node/Node.h>
+#include <component_store/ComponentStore.h>
+#include <slot_map/SlotMap.h>
+#include <memory/PoolAllocator.h>
+#include <camera/Camera.h>
+#include <render_item/RenderItem.h>
 
+#include <unordered_map>
 #include <vector>
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 
-class Camera; // forward ref
-class RenderItem; // forward ref
+class JobSystem;
 
 class NodeManager {
 public:
-	NodeManager();
+	// both must outlive the node manager, transform updates fan out over the job system
+	NodeManager(MeshManager* meshManager, JobSystem* jobSystem);
 	~NodeManager();
 	// update functionality for game loop
 	bool update(void);
+	// frees every node, meshes stay with the mesh manager
+	void clear(void);
 
 	// child node constructors
-	uint8_t create_camera(void);
-	uint8_t create_camera(const glm::vec3& eye, const glm::vec3& viewDirectio, const glm::vec3& up);
+	NodeId create_camera(void);
+	NodeId create_camera(const glm::vec3& eye, const glm::vec3& viewDirectio, const glm::vec3& up);
 
-	uint8_t create_render_item(
-		std::vector<GLfloat> vertexData,
-		std::vector<GLuint> vertexIdxs,
+	// registers the geometry as a new mesh, prefer the mesh id overload when the geometry repeats
+	NodeId create_render_item(
+		const std::vector<GLfloat>& vertexData,
+		const std::vector<GLuint>& vertexIdxs,
 		const glm::vec3& worldPosition,
 		const glm::vec3& rotation,
-		const glm::vec3& scale
+		const glm::vec3& scale,
+		ChunkId chunk = PERSISTENT_CHUNK
 	);
+	// new instance of an already registered mesh
+	NodeId create_render_item(
+		const MeshId& mesh,
+		const glm::vec3& worldPosition,
+		const glm::vec3& rotation,
+		const glm::vec3& scale,
+		const glm::vec4& color = glm::vec4(1.0f),
+		ChunkId chunk = PERSISTENT_CHUNK
+	);
+
+	// parents one node's transform under another (branches on a tree, items carried by the player)
+	// passing an invalid parent id detaches it
+	bool set_parent(const NodeId& child, const NodeId& parent);
+
+	// frees the node and retires its id, stale ids will fail lookup afterwards
+	bool destroy_node(const NodeId& id);
+	// frees every node created in the chunk and hands the chunk's pool blocks back in one go
+	void unload_chunk(ChunkId chunk);
+
+	Node* get_node(const NodeId& id);
+	size_t get_node_count(void) const;
+
+	ComponentStore* get_component_store(void) {
+		return &m_componentStore;
+	}
 
 	Camera* get_camera(void);
 	RenderItem* get_render_item(void);
 
 private:
-	uint8_t create_id(void);
-	bool select_camera(const uint8_t& id);
-	bool select_render_item(const uint8_t& id);
+	bool select_camera(const NodeId& id);
+	bool select_render_item(const NodeId& id);
 
 	bool select_next_camera(void);
 	bool select_next_render_item(void);
 
-	std::vector<Node*> m_nodes;
-	std::vector<uint8_t> m_cameras;
-	std::vector<uint8_t> m_renderItems;
+	PoolAllocator<RenderItem>& get_render_item_pool(ChunkId chunk);
+
+	// walks the dense node list after the given node looking for the next node of type T, wrapping around
+	template<typename T>
+	T* find_next_node_of_type(Node* current);
+
+	MeshManager* m_meshManager;
+	JobSystem* m_jobSystem;
+
+	SlotMap<Node*> m_nodes;
+	// packed per-frame data (transforms, meshes, visibility) for the nodes above
+	ComponentStore m_componentStore;
+
+	// node memory, cameras are few and persistent, render items get a pool per streaming chunk
+	PoolAllocator<Camera, 16> m_cameraPool;
+	std::unordered_map<ChunkId, PoolAllocator<RenderItem>*> m_renderItemPools;
 
 	Camera* m_selectedCamera = nullptr;
 	RenderItem* m_selectedRenderItem = nullptr;
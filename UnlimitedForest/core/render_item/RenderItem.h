@@ -1,53 +1,44 @@
 #pragma once
 
 #include "node/Node.h"
+#include "mesh_manager/MeshManager.h"
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
-#include <vector>
 
-class App;        // forward
-class Camera;
+class ComponentStore; // forward
 
 class RenderItem : public Node {
 public:
-	RenderItem(const uint8_t& id, 
-		std::vector<GLfloat> vertexData, 
-		std::vector<GLuint> vertexIdxs,
+	// the mesh is owned by the mesh manager, the item holds a reference on it for its lifetime
+	// so any number of items can share one and it is freed with the last of them
+	RenderItem(const NodeId& id, 
+		ComponentStore* componentStore,
+		MeshManager* meshManager,
+		const MeshId& mesh,
 		const glm::vec3& worldPosition, 
 		const glm::vec3& rotation, 
-		const glm::vec3& scale
+		const glm::vec3& scale,
+		const glm::vec4& color = glm::vec4(1.0f),
+		ChunkId chunk = PERSISTENT_CHUNK
 	);
-	~RenderItem() {};
-
-	void update(void) override;
-	void predraw(void);
-	void draw();
+	~RenderItem();
 
 	void translate(const glm::vec3& translation);
 	void rotate(const glm::vec3& eulerAngles);
 	void scale(const glm::vec3& scale);
+	void set_visible(bool visible);
+	void set_color(const glm::vec4& color);
+	// simplified mesh drawn into the software occlusion buffer for this item (needs MESH_KEEP_CPU_COPY),
+	// an invalid id stops the item from occluding
+	bool set_occluder(const MeshId& occluderMesh);
 
 	void print(void);
 
 private:
-	void mesh_specification(void);
-	std::vector<GLfloat> m_vertexData;
-	std::vector<GLuint> m_vertexIdxs;
-
-	// TODO: handle all of the opengl functionality for actually drawing on update tick here
-	// private: TODO: these variables should be private but for now they are public since rendering is happening outside of this node
-	//		later rendering will be moved within this node
-	//uint8_t create_render_item(const glm::vec3& worldPosition, const glm::vec3& rotation, const glm::vec3& scale);
-	glm::vec3 m_worldPosition;
-	glm::vec3 m_rotation;
-	glm::vec3 m_scale;
-
-	// OpenGL variables
-	// OpenGL VAO \ VBO
-	GLuint m_vertexArrayObject = 0;
-	GLuint m_vertexBufferObject = 0;
-	// index buffer for reusing shared indecies of triangles
-	// TODO: this might make sense in a more abstracted sense to allow for more efficient rendering
-	GLuint m_vertexElementBuffer = 0;
+	// transform / mesh / visibility live in the component store under this node's id
+	ComponentStore* m_componentStore;
+	MeshManager* m_meshManager;
+	MeshId m_mesh;
+	MeshId m_occluderMesh;
 };
\ No newline at end of file
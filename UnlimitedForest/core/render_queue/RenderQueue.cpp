@@ -0,0 +1,225 @@
+#include "RenderQueue.h"
+#include <log/Log.h>
+#include <gl_state/GLStateCache.h>
+
+#include <algorithm>
+#include <cstring>
+
+RenderQueue::RenderQueue(FrameArena* arena, uint32_t expectedCommands)
+	: m_arena(arena),
+	m_commands(FrameAllocator<RenderCommand>(arena)),
+	m_sortItems(FrameAllocator<RenderSortItem>(arena)),
+	m_segments(FrameAllocator<RenderSegment>(arena)),
+	m_drawCount(0),
+	m_gpuCulled(false)
+{
+	m_commands.reserve(expectedCommands);
+	m_sortItems.reserve(expectedCommands);
+}
+
+uint64_t RenderQueue::make_sort_key(GLuint program, uint32_t material, const MeshId& mesh, uint32_t lod, float depth01) {
+	constexpr uint64_t depthMax = (1ull << DEPTH_BITS) - 1;
+	uint64_t depth = static_cast<uint64_t>(std::clamp(depth01, 0.0f, 1.0f) * static_cast<float>(depthMax));
+
+	uint64_t key = 0;
+	key |= (static_cast<uint64_t>(program) & ((1ull << PROGRAM_BITS) - 1)) << (MATERIAL_BITS + MESH_BITS + LOD_BITS + DEPTH_BITS);
+	key |= (static_cast<uint64_t>(material) & ((1ull << MATERIAL_BITS) - 1)) << (MESH_BITS + LOD_BITS + DEPTH_BITS);
+	key |= (static_cast<uint64_t>(mesh.index()) & ((1ull << MESH_BITS) - 1)) << (LOD_BITS + DEPTH_BITS);
+	key |= (static_cast<uint64_t>(lod) & ((1ull << LOD_BITS) - 1)) << DEPTH_BITS;
+	key |= depth;
+	return key;
+}
+
+void RenderQueue::push(uint64_t sortKey, const RenderCommand& command) {
+	m_sortItems.push_back({ sortKey, static_cast<uint32_t>(m_commands.size()) });
+	m_commands.push_back(command);
+}
+
+void RenderQueue::sort() {
+	size_t count = m_sortItems.size();
+	if (count < 2) {
+		return;
+	}
+
+	FrameVector<RenderSortItem> scratch(count, FrameAllocator<RenderSortItem>(m_arena));
+	RenderSortItem* src = m_sortItems.data();
+	RenderSortItem* dst = scratch.data();
+
+	for (uint32_t shift = 0; shift < 64; shift += 8) {
+		uint32_t offsets[256] = {};
+		for (size_t i = 0; i < count; i++) {
+			offsets[(src[i].m_key >> shift) & 0xFF]++;
+		}
+		// every key has the same byte here, this pass would not move anything
+		if (offsets[(src[0].m_key >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		uint32_t total = 0;
+		for (uint32_t& offset : offsets) {
+			uint32_t bucket = offset;
+			offset = total;
+			total += bucket;
+		}
+		for (size_t i = 0; i < count; i++) {
+			dst[offsets[(src[i].m_key >> shift) & 0xFF]++] = src[i];
+		}
+		std::swap(src, dst);
+	}
+
+	if (src != m_sortItems.data()) {
+		std::memcpy(m_sortItems.data(), src, count * sizeof(RenderSortItem));
+	}
+}
+
+namespace {
+	// uploads a frame stream, growing the buffer first if this frame needs more room
+	template<typename T>
+	void upload_stream(GpuBuffer& buffer, const FrameVector<T>& data) {
+		size_t bytes = data.size() * sizeof(T);
+		buffer.reserve(bytes);
+		buffer.update(data.data(), bytes);
+	}
+}
+
+void RenderQueue::upload(const glm::mat4* worldMatrices, const glm::vec4* colors, const SpheresSoA* cullSpheres, DrawBuffers& buffers) {
+	m_stats = RenderStats();
+	m_stats.m_commands = size();
+	m_segments.clear();
+	m_drawCount = 0;
+	m_gpuCulled = cullSpheres != nullptr;
+	if (m_sortItems.empty()) {
+		return;
+	}
+
+	// gather instances in sorted order so every batch is a contiguous range, then cut the sorted list into
+	// batches (same program and mesh) and batches into program segments
+	uint32_t count = size();
+	FrameVector<InstanceData> instances(count, FrameAllocator<InstanceData>(m_arena));
+	FrameVector<InstanceCullData> cullData{ FrameAllocator<InstanceCullData>(m_arena) };
+	FrameVector<RenderBatch> batches{ FrameAllocator<RenderBatch>(m_arena) };
+	if (m_gpuCulled) {
+		cullData.resize(count);
+	}
+
+	uint32_t batchBegin = 0;
+	while (batchBegin < count) {
+		const RenderCommand& command = m_commands[m_sortItems[batchBegin].m_commandIdx];
+		uint32_t batchEnd = batchBegin;
+		while (batchEnd < count) {
+			const RenderCommand& next = m_commands[m_sortItems[batchEnd].m_commandIdx];
+			if (next.m_program != command.m_program || next.m_features != command.m_features || next.m_mesh != command.m_mesh || next.m_lod != command.m_lod) {
+				break;
+			}
+			instances[batchEnd].m_model = worldMatrices[next.m_row];
+			instances[batchEnd].m_color = colors[next.m_row];
+			instances[batchEnd].m_params = glm::vec4(next.m_lodFade, 0.0f, 0.0f, 0.0f);
+			m_stats.m_lodFadeInstances += next.m_lodFade != 0.0f ? 1 : 0;
+			if (m_gpuCulled) {
+				cullData[batchEnd].m_sphere = glm::vec4(
+					cullSpheres->m_centerX[next.m_row],
+					cullSpheres->m_centerY[next.m_row],
+					cullSpheres->m_centerZ[next.m_row],
+					cullSpheres->m_radius[next.m_row]
+				);
+			}
+			batchEnd++;
+		}
+
+		if (m_segments.empty() || m_segments.back().m_program != command.m_program || m_segments.back().m_features != command.m_features) {
+			m_segments.push_back({ command.m_program, command.m_features, static_cast<uint32_t>(batches.size()), 0 });
+		}
+		m_segments.back().m_drawCount++;
+		// instances inside a batch are already front to back, its first one is its nearest
+		batches.push_back({ batchBegin, batchEnd, static_cast<uint32_t>(m_sortItems[batchBegin].m_key & ((1ull << DEPTH_BITS) - 1)) });
+		batchBegin = batchEnd;
+	}
+
+	// mesh and lod bits sit above depth in the key, so batches come out in mesh order, reorder every
+	// segment's draws by their nearest instance so the multi draw still fills depth front to back
+	for (const RenderSegment& segment : m_segments) {
+		std::sort(batches.begin() + segment.m_firstDraw, batches.begin() + segment.m_firstDraw + segment.m_drawCount, [](const RenderBatch& a, const RenderBatch& b) {
+			return a.m_nearestDepth < b.m_nearestDepth;
+		});
+	}
+
+	FrameVector<DrawData> draws{ FrameAllocator<DrawData>(m_arena) };
+	FrameVector<DrawElementsIndirectCommand> indirect{ FrameAllocator<DrawElementsIndirectCommand>(m_arena) };
+	draws.reserve(batches.size());
+	indirect.reserve(batches.size());
+	for (const RenderBatch& batch : batches) {
+		const RenderCommand& command = m_commands[m_sortItems[batch.m_begin].m_commandIdx];
+		uint32_t drawIdx = static_cast<uint32_t>(draws.size());
+		uint32_t instanceCount = batch.m_end - batch.m_begin;
+		if (m_gpuCulled) {
+			for (uint32_t i = batch.m_begin; i < batch.m_end; i++) {
+				cullData[i].m_draw = drawIdx;
+			}
+		}
+
+		uint32_t lod = command.m_lod < MAX_MESH_LODS ? command.m_lod : MAX_MESH_LODS - 1;
+		m_stats.m_lodInstances[lod] += instanceCount;
+		m_stats.m_lodTriangles[lod] += static_cast<uint64_t>(instanceCount) * (command.m_indexCount / 3);
+
+		draws.push_back({ batch.m_begin, instanceCount, command.m_mesh.index(), command.m_lod });
+		indirect.push_back({
+			static_cast<uint32_t>(command.m_indexCount),
+			// the culling pass counts visible instances back up from zero
+			m_gpuCulled ? 0 : instanceCount,
+			command.m_firstIndex,
+			static_cast<int32_t>(command.m_baseVertex),
+			batch.m_begin
+		});
+	}
+	m_drawCount = static_cast<uint32_t>(draws.size());
+
+	upload_stream(buffers.m_instances, instances);
+	upload_stream(buffers.m_drawData, draws);
+	upload_stream(buffers.m_indirect, indirect);
+	if (m_gpuCulled) {
+		upload_stream(buffers.m_cullData, cullData);
+		buffers.m_culledInstances.reserve(instances.size() * sizeof(InstanceData));
+	}
+}
+
+void RenderQueue::draw(GLuint vertexArrayObject, GLenum indexType, DrawBuffers& buffers, ShaderPermutations* programOverride) {
+	if (m_segments.empty() || vertexArrayObject == 0) {
+		return;
+	}
+
+	// other passes share these binding points, the state cache drops the binds when nothing moved them
+	(m_gpuCulled ? buffers.m_culledInstances : buffers.m_instances).bind_base(INSTANCE_BUFFER_BINDING);
+	buffers.m_drawData.bind_base(DRAW_DATA_BINDING);
+
+	GLStateCache::get().bind_vertex_array(vertexArrayObject);
+	buffers.m_indirect.bind();
+	m_stats.m_vertexArrayBinds++;
+
+	ShaderProgram* boundProgram = nullptr;
+	for (const RenderSegment& segment : m_segments) {
+		ShaderProgram* program = programOverride ? programOverride->get(segment.m_features) : segment.m_program;
+		if (program == nullptr) {
+			continue;
+		}
+		if (program != boundProgram) {
+			boundProgram = program;
+			boundProgram->bind();
+			m_stats.m_programBinds++;
+		}
+		else {
+			m_stats.m_redundantBindsSkipped++;
+		}
+		// gl_DrawID restarts at zero for every multi draw, the offset points it at this segment's draw data
+		boundProgram->set_int(boundProgram->get_uniform_location("u_DrawOffset"), static_cast<GLint>(segment.m_firstDraw));
+
+		glMultiDrawElementsIndirect(GL_TRIANGLES,
+			indexType,
+			(const GLvoid*)(segment.m_firstDraw * sizeof(DrawElementsIndirectCommand)),
+			static_cast<GLsizei>(segment.m_drawCount),
+			0
+		);
+		m_stats.m_drawCalls++;
+		m_stats.m_indirectDraws += segment.m_drawCount;
+	}
+	CATCH_GL_ERROR("error submitting render queue");
+}
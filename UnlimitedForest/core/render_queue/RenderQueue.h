@@ -0,0 +1,138 @@
+#pragma once
+
+#include <culling/Frustum.h>
+#include <gpu_buffer/GpuBuffer.h>
+#include <memory/FrameArena.h>
+#include <mesh_manager/MeshManager.h>
+#include <renderer/DrawData.h>
+#include <shader/ShaderPermutations.h>
+#include <shader/ShaderProgram.h>
+
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// camera state the queue's depth keys are computed from
+struct RenderView {
+	glm::mat4 m_view = glm::mat4(1.0f);
+	glm::mat4 m_projection = glm::mat4(1.0f);
+	float m_nearPlane = 0.1f;
+	float m_farPlane = 100.0f;
+};
+
+// everything the submission pass needs to emit one instance of a mesh
+struct RenderCommand {
+	// the variant picked for m_features, overrides pick theirs from the same bits (see RenderQueue::draw)
+	ShaderProgram* m_program = nullptr;
+	uint32_t m_features = 0;
+	MeshId m_mesh;
+	GLsizei m_indexCount = 0;
+	uint32_t m_firstIndex = 0;
+	uint32_t m_baseVertex = 0;
+	// component store row, the world matrix and color are read from there at submit time
+	uint32_t m_row = 0;
+	// detail level the index range above belongs to, and its cross-fade (see InstanceData::m_params)
+	uint32_t m_lod = 0;
+	float m_lodFade = 0.0f;
+};
+
+// compact entry that actually gets sorted, the command stays put and is looked up by index
+struct RenderSortItem {
+	uint64_t m_key;
+	uint32_t m_commandIdx;
+};
+
+struct RenderStats {
+	// one per drawn instance
+	uint32_t m_commands = 0;
+	// gl draw calls actually issued, one multi draw per program
+	uint32_t m_drawCalls = 0;
+	// indirect draws inside those calls, one per run of commands sharing program and mesh
+	uint32_t m_indirectDraws = 0;
+	uint32_t m_programBinds = 0;
+	uint32_t m_vertexArrayBinds = 0;
+	// binds the submission pass did not issue because the state was already current
+	uint32_t m_redundantBindsSkipped = 0;
+	// per detail level, for tuning the lod screen sizes (before gpu culling when that is on)
+	uint32_t m_lodInstances[MAX_MESH_LODS] = {};
+	uint64_t m_lodTriangles[MAX_MESH_LODS] = {};
+	// instances drawn twice because they are cross-fading between two levels, counted on both
+	uint32_t m_lodFadeInstances = 0;
+};
+
+// gpu side streams the submission pass writes each frame, grown as needed and owned by the renderer
+struct DrawBuffers {
+	GpuBuffer m_instances; // InstanceData, shader storage at INSTANCE_BUFFER_BINDING
+	GpuBuffer m_drawData; // DrawData, shader storage at DRAW_DATA_BINDING
+	GpuBuffer m_indirect; // DrawElementsIndirectCommand
+	// gpu culling only, candidates are culled from m_instances into m_culledInstances
+	GpuBuffer m_cullData; // InstanceCullData
+	GpuBuffer m_culledInstances; // InstanceData, drawn in place of m_instances
+};
+
+// a run of sorted instances sharing program, mesh and lod, drawn by one indirect command
+struct RenderBatch {
+	uint32_t m_begin;
+	uint32_t m_end;
+	// depth field of its nearest instance's key
+	uint32_t m_nearestDepth;
+};
+
+// one multi draw: a program and the range of indirect commands drawn with it
+struct RenderSegment {
+	ShaderProgram* m_program;
+	uint32_t m_features;
+	uint32_t m_firstDraw;
+	uint32_t m_drawCount;
+};
+
+// per-frame render queue, items emit a 64 bit sort key + command, the keys are radix sorted and
+// a single submission pass walks them in order only touching gl state when it actually changes
+// runs of commands sharing a program, mesh and lod become one indirect draw, and every draw of a program
+// goes out in a single glMultiDrawElementsIndirect over the shared mesh arenas
+// storage comes from the frame arena so the queue is built fresh every frame without heap traffic
+class RenderQueue {
+public:
+	// key layout, most expensive state change in the highest bits so sorting groups by it:
+	// | 63..56 program | 55..44 material | 43..24 mesh | 23..22 lod | 21..0 depth |
+	// gl names are truncated to their field, a collision only costs a bind, submission compares real names
+	// the mesh field holds a mesh id's slot index, which is exactly 20 bits
+	static constexpr uint32_t PROGRAM_BITS = 8;
+	static constexpr uint32_t MATERIAL_BITS = 12;
+	static constexpr uint32_t MESH_BITS = 20;
+	static constexpr uint32_t LOD_BITS = 2;
+	static constexpr uint32_t DEPTH_BITS = 22;
+	static_assert((1u << LOD_BITS) >= MAX_MESH_LODS, "lod field too narrow for MAX_MESH_LODS");
+
+	RenderQueue(FrameArena* arena, uint32_t expectedCommands);
+
+	// depth01 is view depth remapped to [0, 1], near first so opaque draws go front to back
+	static uint64_t make_sort_key(GLuint program, uint32_t material, const MeshId& mesh, uint32_t lod, float depth01);
+
+	void push(uint64_t sortKey, const RenderCommand& command);
+	// 8 bit lsd radix sort, passes where every key shares the same byte are skipped
+	void sort(void);
+	// gathers instances in sorted order, cuts them into batches and uploads the draw streams, world matrices and
+	// colors are indexed by each command's row
+	// each program's draws are ordered by their nearest instance, so opaque geometry goes out roughly front to back
+	// with cull spheres the gpu decides visibility: indirect instance counts start at zero and per-instance cull
+	// data is uploaded for the culling pass to fill them in
+	void upload(const glm::mat4* worldMatrices, const glm::vec4* colors, const SpheresSoA* cullSpheres, DrawBuffers& buffers);
+	// issues one multi draw per program through the mesh arenas' vao, camera state comes from the per-frame uniform buffer
+	// an override draws every segment with its variant for the segment's features instead (depth prepass, debug views),
+	// it has to read the same streams
+	void draw(GLuint vertexArrayObject, GLenum indexType, DrawBuffers& buffers, ShaderPermutations* programOverride = nullptr);
+
+	const RenderStats& get_stats(void) const { return m_stats; }
+	uint32_t size(void) const { return static_cast<uint32_t>(m_sortItems.size()); }
+	uint32_t get_draw_count(void) const { return m_drawCount; }
+
+private:
+	FrameArena* m_arena;
+	FrameVector<RenderCommand> m_commands;
+	FrameVector<RenderSortItem> m_sortItems;
+	FrameVector<RenderSegment> m_segments;
+	uint32_t m_drawCount;
+	bool m_gpuCulled;
+	RenderStats m_stats;
+};
@@ -0,0 +1,142 @@
+#include "RenderTarget.h"
+#include <log/Log.h>
+#include <log/GLDebug.h>
+#include <gl_state/GLStateCache.h>
+
+#include <algorithm>
+
+RenderTarget::RenderTarget() : m_framebuffer(0), m_colorTextures{}, m_depthTexture(0), m_colorFormats{}, m_colorCount(0), m_width(0), m_height(0), m_label(nullptr) {}
+
+RenderTarget::~RenderTarget() {
+	destroy();
+}
+
+bool RenderTarget::create(int width, int height, GLenum colorFormat, uint32_t colorCount) {
+	GLenum colorFormats[MAX_COLOR_ATTACHMENTS];
+	for (GLenum& format : colorFormats) {
+		format = colorFormat;
+	}
+	return create(width, height, colorFormats, colorCount);
+}
+
+bool RenderTarget::create(int width, int height, const GLenum* colorFormats, uint32_t colorCount) {
+	destroy();
+	if (width <= 0 || height <= 0) {
+		UF_LOG_ERROR("can not create a {}x{} render target", width, height);
+		return false;
+	}
+	if (colorCount == 0 || colorCount > MAX_COLOR_ATTACHMENTS) {
+		UF_LOG_ERROR("render target color attachment count {} is outside 1..{}", colorCount, MAX_COLOR_ATTACHMENTS);
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	std::copy(colorFormats, colorFormats + colorCount, m_colorFormats);
+	m_colorCount = colorCount;
+
+	glCreateTextures(GL_TEXTURE_2D, m_colorCount, m_colorTextures);
+	for (uint32_t i = 0; i < m_colorCount; i++) {
+		glTextureStorage2D(m_colorTextures[i], 1, m_colorFormats[i], m_width, m_height);
+		glTextureParameteri(m_colorTextures[i], GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTextureParameteri(m_colorTextures[i], GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(m_colorTextures[i], GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(m_colorTextures[i], GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	// float depth so it can be read as is by compute passes, no comparison mode
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_depthTexture);
+	glTextureStorage2D(m_depthTexture, 1, GL_DEPTH_COMPONENT32F, m_width, m_height);
+	glTextureParameteri(m_depthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(m_depthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(m_depthTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(m_depthTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glCreateFramebuffers(1, &m_framebuffer);
+	GLenum drawBuffers[MAX_COLOR_ATTACHMENTS];
+	for (uint32_t i = 0; i < m_colorCount; i++) {
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		glNamedFramebufferTexture(m_framebuffer, drawBuffers[i], m_colorTextures[i], 0);
+	}
+	glNamedFramebufferDrawBuffers(m_framebuffer, static_cast<GLsizei>(m_colorCount), drawBuffers);
+	glNamedFramebufferTexture(m_framebuffer, GL_DEPTH_ATTACHMENT, m_depthTexture, 0);
+
+	GLenum status = glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		UF_LOG_ERROR("render target {}x{} is incomplete: 0x{:x}", m_width, m_height, status);
+		destroy();
+		return false;
+	}
+	apply_label();
+	CATCH_GL_ERROR("error creating render target");
+	return true;
+}
+
+void RenderTarget::destroy() {
+	GLStateCache& state = GLStateCache::get();
+	if (m_framebuffer) {
+		state.forget_framebuffer(m_framebuffer);
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_colorCount) {
+		for (uint32_t i = 0; i < m_colorCount; i++) {
+			state.forget_texture(m_colorTextures[i]);
+		}
+		glDeleteTextures(static_cast<GLsizei>(m_colorCount), m_colorTextures);
+		for (GLuint& texture : m_colorTextures) {
+			texture = 0;
+		}
+		m_colorCount = 0;
+	}
+	if (m_depthTexture) {
+		state.forget_texture(m_depthTexture);
+		glDeleteTextures(1, &m_depthTexture);
+		m_depthTexture = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+}
+
+bool RenderTarget::resize(int width, int height) {
+	if (is_valid() && width == m_width && height == m_height) {
+		return true;
+	}
+	if (m_colorCount == 0) {
+		return create(width, height, m_colorFormats[0] ? m_colorFormats[0] : GL_RGBA8, 1);
+	}
+	// create() overwrites the formats, so they are handed over as a copy
+	GLenum colorFormats[MAX_COLOR_ATTACHMENTS];
+	std::copy(m_colorFormats, m_colorFormats + m_colorCount, colorFormats);
+	return create(width, height, colorFormats, m_colorCount);
+}
+
+void RenderTarget::bind() const {
+	GLStateCache::get().bind_framebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	GLStateCache::get().set_viewport(0, 0, m_width, m_height);
+}
+
+void RenderTarget::set_label(const char* label) {
+	m_label = label;
+	apply_label();
+}
+
+void RenderTarget::apply_label() const {
+	if (m_label == nullptr || !is_valid()) {
+		return;
+	}
+	UF_GL_LABEL(GL_FRAMEBUFFER, m_framebuffer, m_label);
+	for (uint32_t i = 0; i < m_colorCount; i++) {
+		UF_GL_LABEL(GL_TEXTURE, m_colorTextures[i], m_label);
+	}
+	UF_GL_LABEL(GL_TEXTURE, m_depthTexture, m_label);
+}
+
+void RenderTarget::blit_to_screen(int screenWidth, int screenHeight) const {
+	glBlitNamedFramebuffer(m_framebuffer, 0,
+		0, 0, m_width, m_height,
+		0, 0, screenWidth, screenHeight,
+		GL_COLOR_BUFFER_BIT,
+		GL_LINEAR
+	);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+
+// offscreen framebuffer with one or more color textures and a sampleable depth texture, for passes that
+// need to read back what was drawn (depth pyramids, baked textures) before it is shown
+class RenderTarget {
+public:
+	static constexpr uint32_t MAX_COLOR_ATTACHMENTS = 4;
+
+	RenderTarget();
+	~RenderTarget();
+
+	RenderTarget(const RenderTarget&) = delete;
+	RenderTarget& operator=(const RenderTarget&) = delete;
+
+	// allocates the attachments, every color attachment shares the format,
+	// returns false (and logs why) if the framebuffer is incomplete
+	bool create(int width, int height, GLenum colorFormat = GL_RGBA8, uint32_t colorCount = 1);
+	// same with a format per color attachment, for targets whose attachments hold different kinds of data
+	bool create(int width, int height, const GLenum* colorFormats, uint32_t colorCount);
+	void destroy(void);
+	// recreates the attachments if the size changed, contents are lost when it does
+	bool resize(int width, int height);
+
+	// binds the framebuffer and sets the viewport to cover it
+	void bind(void) const;
+	// copies the first color attachment onto the default framebuffer, stretched to its size
+	void blit_to_screen(int screenWidth, int screenHeight) const;
+	// debug name of the framebuffer and its attachments, survives resizes, has to outlive the target (a literal)
+	void set_label(const char* label);
+
+	GLuint get_framebuffer(void) const { return m_framebuffer; }
+	GLuint get_color_texture(uint32_t index = 0) const { return index < m_colorCount ? m_colorTextures[index] : 0; }
+	uint32_t get_color_count(void) const { return m_colorCount; }
+	GLuint get_depth_texture(void) const { return m_depthTexture; }
+	int get_width(void) const { return m_width; }
+	int get_height(void) const { return m_height; }
+	bool is_valid(void) const { return m_framebuffer != 0; }
+
+private:
+	void apply_label(void) const;
+
+	GLuint m_framebuffer;
+	GLuint m_colorTextures[MAX_COLOR_ATTACHMENTS];
+	GLuint m_depthTexture;
+	GLenum m_colorFormats[MAX_COLOR_ATTACHMENTS];
+	uint32_t m_colorCount;
+	int m_width;
+	int m_height;
+	const char* m_label;
+};
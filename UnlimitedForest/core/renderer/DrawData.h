@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// shader storage bindings of the per-frame draw streams, must match the shaders' layout(binding = ...)
+constexpr unsigned int INSTANCE_BUFFER_BINDING = 1;
+constexpr unsigned int DRAW_DATA_BINDING = 2;
+// gpu culling only: every candidate instance in, its cull data, the indirect commands it fills and the visible counter
+constexpr unsigned int CULL_SOURCE_INSTANCE_BINDING = 3;
+constexpr unsigned int CULL_DATA_BINDING = 4;
+constexpr unsigned int CULL_COMMAND_BINDING = 5;
+constexpr unsigned int CULL_COUNTER_BINDING = 6;
+
+// std430 per-instance entry, instances of one draw are contiguous starting at that draw's m_firstInstance
+struct InstanceData {
+	glm::mat4 m_model;
+	glm::vec4 m_color;
+	// x: lod cross-fade, 0 opaque, > 0 keeps that share of the dither pattern, < 0 keeps the complement
+	glm::vec4 m_params;
+};
+
+// std430 per-draw entry, the vertex shader finds it through gl_DrawID
+struct DrawData {
+	uint32_t m_firstInstance;
+	uint32_t m_instanceCount;
+	uint32_t m_mesh; // mesh id index, for debugging / later passes
+	uint32_t m_lod;
+};
+
+// std430 per-instance input of the gpu culling pass, one entry per candidate instance
+struct InstanceCullData {
+	glm::vec4 m_sphere; // world space center + radius
+	uint32_t m_draw; // indirect command / draw data index the instance belongs to
+	uint32_t m_padding[3];
+};
+
+// layout glMultiDrawElementsIndirect reads from the indirect buffer
+struct DrawElementsIndirectCommand {
+	uint32_t m_count;
+	uint32_t m_instanceCount;
+	uint32_t m_firstIndex;
+	int32_t m_baseVertex;
+	uint32_t m_baseInstance;
+};
+
+static_assert(sizeof(InstanceData) == 96, "InstanceData must match the std430 instance layout");
+static_assert(sizeof(DrawData) == 16, "DrawData must match the std430 draw layout");
+static_assert(sizeof(InstanceCullData) == 32, "InstanceCullData must match the std430 cull layout");
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "indirect command layout is fixed by gl");
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// uniform buffer binding every program reads its per-frame data from, must match the shaders' layout(binding = ...)
+constexpr unsigned int FRAME_UNIFORMS_BINDING = 0;
+
+// cpu mirror of the std140 FrameUniforms block in the shaders, written once per frame
+// members are ordered so std140 adds no padding: mat4s are 16 byte aligned and the vec3 + float share a slot
+struct FrameUniforms {
+	glm::mat4 m_view;
+	glm::mat4 m_projection;
+	glm::mat4 m_viewProjection;
+	glm::vec3 m_cameraPosition;
+	float m_time; // seconds since the renderer started
+};
+
+static_assert(sizeof(FrameUniforms) == 3 * 64 + 16, "FrameUniforms must match the std140 block layout");
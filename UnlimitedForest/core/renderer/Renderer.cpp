@@ -0,0 +1,594 @@
+#include "Renderer.h"
+#include <application/App.h>
+#include <camera/Camera.h>
+#include <component_store/ComponentStore.h>
+#include <gl_state/GLStateCache.h>
+#include <node_manager/NodeManager.h>
+#include <log/Log.h>
+#include <log/GLDebug.h>
+
+#include <algorithm>
+#include <atomic>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+	constexpr size_t INITIAL_INSTANCE_CAPACITY = 1024;
+	constexpr size_t INITIAL_DRAW_CAPACITY = 64;
+	// rows per culling job, a multiple of 8 so only the last range takes the scalar tail
+	constexpr uint32_t CULL_JOB_GRAIN = 4096;
+	// occluders projected per job, and rows tested against the occlusion buffer per job
+	constexpr uint32_t OCCLUDER_JOB_GRAIN = 64;
+	constexpr uint32_t OCCLUSION_TEST_GRAIN = 2048;
+
+	struct LodSelection {
+		uint32_t m_level;
+		// share of the dither pattern the level keeps while cross-fading into the next coarser one, 0 when not fading
+		float m_fade;
+	};
+
+	// coarsest level whose screen size the item has dropped below, within fadeBand (relative) above the
+	// next level's threshold it fades out towards that level so the switch never pops
+	LodSelection select_lod(const Mesh& mesh, float screenSize, float fadeBand) {
+		uint32_t level = 0;
+		while (level + 1 < mesh.m_lodCount && screenSize < mesh.m_lods[level + 1].m_screenSize) {
+			level++;
+		}
+		if (level + 1 < mesh.m_lodCount && fadeBand > 0.0f) {
+			float threshold = mesh.m_lods[level + 1].m_screenSize;
+			float fade = (screenSize - threshold) / (threshold * fadeBand);
+			if (fade < 1.0f) {
+				// never exactly 0, that means opaque
+				return { level, std::max(fade, 1.0f / 64.0f) };
+			}
+		}
+		return { level, 0.0f };
+	}
+}
+
+Renderer::Renderer() : m_overdrawQueries{}, m_overdrawQueryPending{}, m_overdrawQueryIdx(0), m_frameIdx(0), m_hardLodSwitchLogged(false) {}
+
+Renderer::~Renderer() {}
+
+bool Renderer::init(const ShaderProgram& program) {
+	if (!m_frameUniformBuffer.create(GL_UNIFORM_BUFFER, sizeof(FrameUniforms))) {
+		return false;
+	}
+	m_frameUniformBuffer.set_label("frame uniforms");
+	// the binding point never changes so it is attached once here rather than per frame
+	m_frameUniformBuffer.bind_base(FRAME_UNIFORMS_BINDING);
+	// grown by the queue to fit the frame's instance / draw count
+	if (!m_drawBuffers.m_instances.create(GL_SHADER_STORAGE_BUFFER, INITIAL_INSTANCE_CAPACITY * sizeof(InstanceData), GL_STREAM_DRAW)
+		|| !m_drawBuffers.m_drawData.create(GL_SHADER_STORAGE_BUFFER, INITIAL_DRAW_CAPACITY * sizeof(DrawData), GL_STREAM_DRAW)
+		|| !m_drawBuffers.m_indirect.create(GL_DRAW_INDIRECT_BUFFER, INITIAL_DRAW_CAPACITY * sizeof(DrawElementsIndirectCommand), GL_STREAM_DRAW)) {
+		return false;
+	}
+	m_drawBuffers.m_instances.set_label("queue instances");
+	m_drawBuffers.m_drawData.set_label("queue draw data");
+	m_drawBuffers.m_indirect.set_label("queue indirect commands");
+
+	const ShaderResource* block = program.find_uniform_block("FrameUniforms");
+	if (block == nullptr) {
+		UF_LOG_WARN("program {} does not read the FrameUniforms block", program.get_id());
+	}
+	else if (block->m_binding != static_cast<GLint>(FRAME_UNIFORMS_BINDING) || block->m_dataSize != static_cast<GLint>(sizeof(FrameUniforms))) {
+		UF_LOG_ERROR("program {} FrameUniforms block (binding {}, {} bytes) does not match the renderer (binding {}, {} bytes)",
+			program.get_id(),
+			block->m_binding,
+			block->m_dataSize,
+			FRAME_UNIFORMS_BINDING,
+			sizeof(FrameUniforms)
+		);
+		return false;
+	}
+
+	glCreateQueries(GL_SAMPLES_PASSED, OVERDRAW_QUERY_FRAMES, m_overdrawQueries);
+	CATCH_GL_ERROR("error creating the overdraw queries");
+
+	m_startTime = std::chrono::steady_clock::now();
+	return true;
+}
+
+bool Renderer::init_gpu_culling(const std::string& cullShaderPath, const std::string& pyramidShaderPath) {
+	if (!m_gpuCuller.create(cullShaderPath, pyramidShaderPath)) {
+		return false;
+	}
+	if (!m_drawBuffers.m_cullData.create(GL_SHADER_STORAGE_BUFFER, INITIAL_INSTANCE_CAPACITY * sizeof(InstanceCullData), GL_STREAM_DRAW)
+		|| !m_drawBuffers.m_culledInstances.create(GL_SHADER_STORAGE_BUFFER, INITIAL_INSTANCE_CAPACITY * sizeof(InstanceData), GL_DYNAMIC_COPY)) {
+		m_gpuCuller.destroy();
+		return false;
+	}
+	m_drawBuffers.m_cullData.set_label("queue cull data");
+	m_drawBuffers.m_culledInstances.set_label("queue culled instances");
+	m_sceneTarget.set_label("scene target");
+	return true;
+}
+
+bool Renderer::init_impostors(const std::string& vertexPath, const std::string& fragmentPath) {
+	return m_impostorRenderer.create(vertexPath, fragmentPath);
+}
+
+bool Renderer::init_far_field(const std::string& vertexPath, const std::string& captureFragmentPath, const std::string& compositeFragmentPath, int resolution) {
+	return m_farField.create(vertexPath, captureFragmentPath, compositeFragmentPath, resolution);
+}
+
+bool Renderer::init_depth_prepass(const std::string& vertexPath, const std::string& fragmentPath) {
+	if (!m_depthPrepassPrograms.create_from_files(vertexPath, fragmentPath) || m_depthPrepassPrograms.get(0) == nullptr) {
+		m_depthPrepassPrograms.destroy();
+		return false;
+	}
+	return true;
+}
+
+bool Renderer::init_overdraw_view(const std::string& vertexPath, const std::string& fragmentPath) {
+	if (!m_overdrawPrograms.create_from_files(vertexPath, fragmentPath) || m_overdrawPrograms.get(0) == nullptr) {
+		m_overdrawPrograms.destroy();
+		return false;
+	}
+	return true;
+}
+
+void Renderer::destroy() {
+	m_frameUniformBuffer.destroy();
+	m_drawBuffers.m_instances.destroy();
+	m_drawBuffers.m_drawData.destroy();
+	m_drawBuffers.m_indirect.destroy();
+	m_drawBuffers.m_cullData.destroy();
+	m_drawBuffers.m_culledInstances.destroy();
+	m_gpuCuller.destroy();
+	m_sceneTarget.destroy();
+	m_impostorRenderer.destroy();
+	m_farField.destroy();
+	m_depthPrepassPrograms.destroy();
+	m_overdrawPrograms.destroy();
+	if (m_overdrawQueries[0]) {
+		glDeleteQueries(OVERDRAW_QUERY_FRAMES, m_overdrawQueries);
+		for (uint32_t i = 0; i < OVERDRAW_QUERY_FRAMES; i++) {
+			m_overdrawQueries[i] = 0;
+			m_overdrawQueryPending[i] = false;
+		}
+	}
+}
+
+void Renderer::update_frame_uniforms(const RenderView& view, const glm::vec3& cameraPosition) {
+	FrameUniforms uniforms;
+	uniforms.m_view = view.m_view;
+	uniforms.m_projection = view.m_projection;
+	uniforms.m_viewProjection = view.m_projection * view.m_view;
+	uniforms.m_cameraPosition = cameraPosition;
+	uniforms.m_time = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_startTime).count();
+	m_frameUniformBuffer.update(&uniforms, sizeof(uniforms));
+}
+
+void Renderer::cull_frustum(const ComponentStore& store, const Frustum& frustum, uint8_t* inFrustum) {
+	BoundsSoA bounds = store.get_bounds().get_aabbs();
+	std::atomic<uint32_t> culled{ 0 };
+	App::get()->get_job_system()->parallel_for(static_cast<uint32_t>(store.size()), CULL_JOB_GRAIN, [&](uint32_t begin, uint32_t end) {
+		culled.fetch_add(frustum.cull_aabbs(bounds, begin, end, inFrustum), std::memory_order_relaxed);
+	});
+	m_visibilityStats.m_frustumCulled = culled.load();
+}
+
+void Renderer::cull_occlusion(const ComponentStore& store, const MeshManager& meshManager, FrameArena& frameArena, const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const EngineConfig& cfg, uint8_t* potentiallyVisible) {
+	JobSystem* jobSystem = App::get()->get_job_system();
+	m_occlusionBuffer.resize(cfg.m_occlusionBufferWidth, cfg.m_occlusionBufferHeight);
+	m_occlusionBuffer.clear(viewProjection);
+
+	// occluders near enough to matter, each gets a triangle range laid out back to back
+	const glm::mat4* worldMatrices = store.get_transforms().m_worldMatrices.data();
+	const MeshId* occluderMeshes = store.get_occluders().m_meshes.data();
+	const uint8_t* visible = store.get_visibility().m_visible.data();
+	FrameVector<uint32_t> occluderRows{ FrameAllocator<uint32_t>(&frameArena) };
+	FrameVector<uint32_t> triangleOffsets{ FrameAllocator<uint32_t>(&frameArena) };
+	uint32_t triangleCapacity = 0;
+	float maxDistanceSq = cfg.m_occluderMaxDistance * cfg.m_occluderMaxDistance;
+	store.query(COMPONENT_TRANSFORM | COMPONENT_OCCLUDER | COMPONENT_VISIBILITY, [&](uint32_t row) {
+		glm::vec3 offset = glm::vec3(worldMatrices[row][3]) - cameraPosition;
+		if (!visible[row] || !potentiallyVisible[row] || glm::dot(offset, offset) > maxDistanceSq) {
+			return;
+		}
+		const MeshCpuData* cpuData = meshManager.get_cpu_data(occluderMeshes[row]);
+		if (cpuData == nullptr) {
+			return;
+		}
+		occluderRows.push_back(row);
+		triangleOffsets.push_back(triangleCapacity);
+		triangleCapacity += static_cast<uint32_t>(cpuData->m_indices.size() / 3);
+	});
+
+	uint32_t occluderCount = static_cast<uint32_t>(occluderRows.size());
+	FrameVector<OccluderTriangle> triangles(triangleCapacity, OccluderTriangle(), FrameAllocator<OccluderTriangle>(&frameArena));
+	FrameVector<uint32_t> triangleCounts(occluderCount, 0, FrameAllocator<uint32_t>(&frameArena));
+	jobSystem->parallel_for(occluderCount, OCCLUDER_JOB_GRAIN, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			const MeshCpuData* cpuData = meshManager.get_cpu_data(occluderMeshes[occluderRows[i]]);
+			triangleCounts[i] = m_occlusionBuffer.project_triangles(worldMatrices[occluderRows[i]],
+				cpuData->m_positions.data(),
+				cpuData->m_indices.data(),
+				static_cast<uint32_t>(cpuData->m_indices.size()),
+				triangles.data() + triangleOffsets[i]
+			);
+		}
+	});
+	// close the gaps dropped triangles left, ranges only ever move towards the front
+	uint32_t triangleCount = 0;
+	for (uint32_t i = 0; i < occluderCount; i++) {
+		std::copy(triangles.begin() + triangleOffsets[i], triangles.begin() + triangleOffsets[i] + triangleCounts[i], triangles.begin() + triangleCount);
+		triangleCount += triangleCounts[i];
+	}
+
+	// bin once by band (a triangle spanning several is copied into each) so no band job walks the whole list
+	uint32_t bandCount = m_occlusionBuffer.get_band_count();
+	FrameVector<uint32_t> bandOffsets(bandCount + 1, 0, FrameAllocator<uint32_t>(&frameArena));
+	uint32_t firstBand;
+	uint32_t lastBand;
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		m_occlusionBuffer.get_band_range(triangles[t], firstBand, lastBand);
+		for (uint32_t band = firstBand; band <= lastBand; band++) {
+			bandOffsets[band + 1]++;
+		}
+	}
+	for (uint32_t band = 0; band < bandCount; band++) {
+		bandOffsets[band + 1] += bandOffsets[band];
+	}
+	FrameVector<OccluderTriangle> bandTriangles(bandOffsets[bandCount], OccluderTriangle(), FrameAllocator<OccluderTriangle>(&frameArena));
+	FrameVector<uint32_t> bandCursors(bandOffsets.begin(), bandOffsets.end() - 1, FrameAllocator<uint32_t>(&frameArena));
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		m_occlusionBuffer.get_band_range(triangles[t], firstBand, lastBand);
+		for (uint32_t band = firstBand; band <= lastBand; band++) {
+			bandTriangles[bandCursors[band]++] = triangles[t];
+		}
+	}
+
+	// bands own disjoint rows, one job each
+	jobSystem->parallel_for(bandCount, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t band = begin; band < end; band++) {
+			m_occlusionBuffer.rasterize(bandTriangles.data() + bandOffsets[band],
+				bandOffsets[band + 1] - bandOffsets[band],
+				band * OcclusionBuffer::BAND_HEIGHT,
+				(band + 1) * OcclusionBuffer::BAND_HEIGHT
+			);
+		}
+	});
+
+	const BoundsPool& bounds = store.get_bounds();
+	std::atomic<uint32_t> tested{ 0 };
+	std::atomic<uint32_t> occluded{ 0 };
+	jobSystem->parallel_for(static_cast<uint32_t>(store.size()), OCCLUSION_TEST_GRAIN, [&](uint32_t begin, uint32_t end) {
+		uint32_t rangeTested = 0;
+		uint32_t rangeOccluded = 0;
+		store.query_range(COMPONENT_MESH | COMPONENT_BOUNDS, begin, end, [&](uint32_t row) {
+			if (!potentiallyVisible[row]) {
+				return;
+			}
+			rangeTested++;
+			glm::vec3 boundsMin(bounds.m_minX[row], bounds.m_minY[row], bounds.m_minZ[row]);
+			glm::vec3 boundsMax(bounds.m_maxX[row], bounds.m_maxY[row], bounds.m_maxZ[row]);
+			if (!m_occlusionBuffer.test_aabb(boundsMin, boundsMax)) {
+				potentiallyVisible[row] = 0;
+				rangeOccluded++;
+			}
+		});
+		tested.fetch_add(rangeTested, std::memory_order_relaxed);
+		occluded.fetch_add(rangeOccluded, std::memory_order_relaxed);
+	});
+
+	m_visibilityStats.m_occluders = occluderCount;
+	m_visibilityStats.m_occluderTriangles = triangleCount;
+	m_visibilityStats.m_occlusionTested = tested.load();
+	m_visibilityStats.m_occlusionCulled = occluded.load();
+}
+
+void Renderer::render(NodeManager& nodeManager, const MeshManager& meshManager, FrameArena& frameArena, const EngineConfig& cfg, ShaderPermutations& programs) {
+	Camera* camera = nodeManager.get_camera();
+	if (camera == nullptr) {
+		return;
+	}
+
+	RenderView view;
+	view.m_view = camera->get_view_matrix();
+	view.m_projection = glm::perspective(glm::radians(45.0f),
+		(float)cfg.m_screenWidth / (float)cfg.m_screenHeight,
+		view.m_nearPlane,
+		view.m_farPlane
+	);
+	update_frame_uniforms(view, camera->get_position());
+	// amortized: most frames render nothing here, a moving camera renders a face or so per frame
+	bool farField = cfg.m_farField && m_farField.is_valid();
+	if (farField) {
+		UF_GL_DEBUG_GROUP("far field capture");
+		m_farField.update(camera->get_position(), cfg);
+	}
+
+	const ComponentStore& store = *nodeManager.get_component_store();
+	const glm::mat4* worldMatrices = store.get_transforms().m_worldMatrices.data();
+	const MeshRef* meshes = store.get_meshes().m_meshes.data();
+	const glm::vec4* colors = store.get_meshes().m_colors.data();
+	const uint8_t* visible = store.get_visibility().m_visible.data();
+
+	// whole store in one batched pass, rows without bounds always pass
+	// on the gpu path every item is queued and the compute pass decides instead
+	glm::mat4 viewProjection = view.m_projection * view.m_view;
+	bool gpuCulling = cfg.m_gpuCulling && m_gpuCuller.is_valid();
+	uint32_t rowCount = static_cast<uint32_t>(store.size());
+	FrameVector<uint8_t> potentiallyVisible(rowCount, 1, FrameAllocator<uint8_t>(&frameArena));
+	m_visibilityStats = VisibilityStats();
+	if (cfg.m_frustumCulling && !gpuCulling) {
+		auto cullStart = std::chrono::steady_clock::now();
+		cull_frustum(store, Frustum(viewProjection), potentiallyVisible.data());
+		m_visibilityStats.m_tested = rowCount;
+		m_visibilityStats.m_cullMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+	}
+	// only what survived the frustum is rasterized / tested
+	if (cfg.m_occlusionCulling && !gpuCulling) {
+		auto occlusionStart = std::chrono::steady_clock::now();
+		cull_occlusion(store, meshManager, frameArena, viewProjection, camera->get_position(), cfg, potentiallyVisible.data());
+		m_visibilityStats.m_occlusionMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - occlusionStart).count();
+	}
+
+	// emit a key + command per visible item (two while it cross-fades between levels), depth is taken at the
+	// item's origin, the level from its bounding sphere's projected size
+	// only the cross-fading commands draw with the dither variant, everything else with the one that never discards
+	// items of a baked species past the impostor distance skip the queue and go out as billboards
+	RenderQueue queue(&frameArena, static_cast<uint32_t>(store.size()));
+	FrameVector<ImpostorInstance> impostors{ FrameAllocator<ImpostorInstance>(&frameArena) };
+	bool useImpostors = cfg.m_impostorDistance > 0.0f && m_impostorRenderer.is_valid() && m_impostorRenderer.has_impostors();
+	float impostorDistanceSq = cfg.m_impostorDistance * cfg.m_impostorDistance;
+	float depthRange = view.m_farPlane - view.m_nearPlane;
+	const BoundsPool& bounds = store.get_bounds();
+	glm::vec3 cameraPosition = camera->get_position();
+	// sphere radius over distance times this is its diameter as a fraction of the viewport height
+	float screenScale = view.m_projection[1][1] * cfg.m_lodBias;
+	ShaderProgram* opaqueProgram = programs.get(0);
+	ShaderProgram* ditherProgram = programs.get(SHADER_FEATURE_LOD_DITHER);
+	// without the dither variant a fade can not be drawn, so items switch level halfway through the band instead
+	bool hardLodSwitch = ditherProgram == nullptr;
+	if (hardLodSwitch && opaqueProgram != nullptr && !m_hardLodSwitchLogged) {
+		UF_LOG_WARN("lod dither variant unavailable, lod cross-fades fall back to a hard switch");
+		m_hardLodSwitchLogged = true;
+	}
+	store.query(COMPONENT_TRANSFORM | COMPONENT_MESH | COMPONENT_VISIBILITY, [&](uint32_t row) {
+		if (!visible[row] || !potentiallyVisible[row]) {
+			return;
+		}
+		const Mesh* mesh = meshManager.get_mesh(meshes[row].m_mesh);
+		if (mesh == nullptr) {
+			return;
+		}
+		if (useImpostors) {
+			glm::vec3 offset = glm::vec3(worldMatrices[row][3]) - cameraPosition;
+			if (glm::dot(offset, offset) > impostorDistanceSq && m_impostorRenderer.find_impostor(meshes[row].m_mesh)) {
+				impostors.push_back({ meshes[row].m_mesh.m_value, row });
+				return;
+			}
+		}
+
+		float viewDepth = -(view.m_view * worldMatrices[row][3]).z;
+		float depth01 = (viewDepth - view.m_nearPlane) / depthRange;
+		LodSelection lod = { 0, 0.0f };
+		if (mesh->m_lodCount > 1) {
+			glm::vec3 center(bounds.m_centerX[row], bounds.m_centerY[row], bounds.m_centerZ[row]);
+			float distance = std::max(glm::length(center - cameraPosition), view.m_nearPlane);
+			lod = select_lod(*mesh, bounds.m_radius[row] * screenScale / distance, cfg.m_lodFadeBand);
+		}
+		if (hardLodSwitch && lod.m_fade != 0.0f) {
+			if (lod.m_fade < 0.5f) {
+				lod.m_level++;
+			}
+			lod.m_fade = 0.0f;
+		}
+
+		RenderCommand command;
+		command.m_mesh = meshes[row].m_mesh;
+		command.m_row = row;
+		auto pushLevel = [&](uint32_t level, float fade) {
+			const MeshLod& meshLod = mesh->m_lods[level];
+			command.m_indexCount = meshLod.m_indexCount;
+			command.m_firstIndex = meshLod.m_firstIndex;
+			command.m_baseVertex = meshLod.m_baseVertex;
+			command.m_lod = level;
+			command.m_lodFade = fade;
+			command.m_features = fade != 0.0f ? static_cast<uint32_t>(SHADER_FEATURE_LOD_DITHER) : 0u;
+			command.m_program = fade != 0.0f ? ditherProgram : opaqueProgram;
+			if (command.m_program == nullptr) {
+				return;
+			}
+			queue.push(RenderQueue::make_sort_key(command.m_program->get_id(), 0, command.m_mesh, level, depth01), command);
+		};
+		pushLevel(lod.m_level, lod.m_fade);
+		if (lod.m_fade != 0.0f) {
+			// the coarser level fills in exactly the pixels the finer one dithers away
+			pushLevel(lod.m_level + 1, -lod.m_fade);
+		}
+	});
+
+	queue.sort();
+	if (gpuCulling) {
+		SpheresSoA spheres = store.get_bounds().get_spheres();
+		queue.upload(worldMatrices, colors, &spheres, m_drawBuffers);
+		render_gpu_culled(queue, meshManager.get_vertex_array(), meshManager.get_index_type(), view, cfg, impostors, worldMatrices, colors, frameArena);
+	}
+	else {
+		queue.upload(worldMatrices, colors, nullptr, m_drawBuffers);
+		draw_scene(queue, meshManager.get_vertex_array(), meshManager.get_index_type(), view, cfg, impostors, worldMatrices, colors, frameArena);
+	}
+	m_visibilityStats.m_impostors = static_cast<uint32_t>(impostors.size());
+
+	m_frameStats = queue.get_stats();
+	UF_LOG_TRACE("frame {} | instances: {} | draw calls: {} | indirect draws: {} | program binds: {} | vao binds: {} | skipped binds: {}",
+		m_frameIdx,
+		m_frameStats.m_commands,
+		m_frameStats.m_drawCalls,
+		m_frameStats.m_indirectDraws,
+		m_frameStats.m_programBinds,
+		m_frameStats.m_vertexArrayBinds,
+		m_frameStats.m_redundantBindsSkipped
+	);
+	UF_LOG_TRACE("frame {} | tested: {} | frustum culled: {} | gpu culled: {} | cull ms: {:.3f}",
+		m_frameIdx,
+		m_visibilityStats.m_tested,
+		m_visibilityStats.m_frustumCulled,
+		m_visibilityStats.m_gpuCulled,
+		m_visibilityStats.m_cullMs
+	);
+	static_assert(MAX_MESH_LODS == 4, "lod trace below lists exactly four levels");
+	UF_LOG_TRACE("frame {} | lod instances: {} / {} / {} / {} | lod triangles: {} / {} / {} / {} | cross-fading: {}",
+		m_frameIdx,
+		m_frameStats.m_lodInstances[0],
+		m_frameStats.m_lodInstances[1],
+		m_frameStats.m_lodInstances[2],
+		m_frameStats.m_lodInstances[3],
+		m_frameStats.m_lodTriangles[0],
+		m_frameStats.m_lodTriangles[1],
+		m_frameStats.m_lodTriangles[2],
+		m_frameStats.m_lodTriangles[3],
+		m_frameStats.m_lodFadeInstances
+	);
+	UF_LOG_TRACE("frame {} | depth prepass: {} | shaded samples: {} | overdraw: {:.2f}x",
+		m_frameIdx,
+		cfg.m_depthPrepass && m_depthPrepassPrograms.is_valid(),
+		m_overdrawStats.m_samplesShaded,
+		m_overdrawStats.m_overdraw
+	);
+	if (farField && m_farField.get_faces_rendered() > 0) {
+		UF_LOG_TRACE("frame {} | far field faces captured: {}", m_frameIdx, m_farField.get_faces_rendered());
+	}
+	if (useImpostors) {
+		UF_LOG_TRACE("frame {} | impostors: {} | impostor draw calls: {}",
+			m_frameIdx,
+			m_visibilityStats.m_impostors,
+			m_impostorRenderer.get_draw_calls()
+		);
+	}
+	if (cfg.m_occlusionCulling && !gpuCulling) {
+		UF_LOG_TRACE("frame {} | occluders: {} ({} triangles) | occlusion tested: {} | occluded: {} ({:.1f}%) | occlusion ms: {:.3f}",
+			m_frameIdx,
+			m_visibilityStats.m_occluders,
+			m_visibilityStats.m_occluderTriangles,
+			m_visibilityStats.m_occlusionTested,
+			m_visibilityStats.m_occlusionCulled,
+			m_visibilityStats.m_occlusionTested ? 100.0f * m_visibilityStats.m_occlusionCulled / m_visibilityStats.m_occlusionTested : 0.0f,
+			m_visibilityStats.m_occlusionMs
+		);
+	}
+	m_frameIdx++;
+}
+
+void Renderer::draw_scene(RenderQueue& queue, GLuint vertexArrayObject, GLenum indexType, const RenderView& view, const EngineConfig& cfg,
+	FrameVector<ImpostorInstance>& impostors, const glm::mat4* worldMatrices, const glm::vec4* colors, FrameArena& frameArena) {
+	bool overdrawView = cfg.m_overdrawView && m_overdrawPrograms.is_valid();
+	bool depthPrepass = cfg.m_depthPrepass && m_depthPrepassPrograms.is_valid();
+
+	// behind everything, so it neither tests nor writes depth, and it would only tint the heat map
+	if (cfg.m_farField && m_farField.is_valid() && !overdrawView) {
+		UF_GL_DEBUG_GROUP("far field composite");
+		m_farField.composite(view.m_view, view.m_projection);
+	}
+
+	// opaque policy: depth tested and written, back faces culled, front faces are wound counter clockwise and
+	// open meshes carry the reverse winding too wherever their back can be seen
+	GLStateCache& state = GLStateCache::get();
+	state.set_enabled(GL_DEPTH_TEST, true);
+	state.set_depth_func(GL_LESS);
+	state.set_depth_mask(true);
+	state.set_color_mask(true);
+	state.set_enabled(GL_CULL_FACE, cfg.m_backfaceCulling);
+	state.set_cull_face(GL_BACK);
+	state.set_front_face(GL_CCW);
+	state.set_enabled(GL_BLEND, overdrawView);
+	if (overdrawView) {
+		state.set_blend_func(GL_ONE, GL_ONE);
+	}
+
+	if (depthPrepass) {
+		// same vertex shader (invariant position) and the same dither discard, so the depth it leaves is exactly
+		// what the shaded pass produces, which then only runs for the front most surface of every pixel
+		UF_GL_DEBUG_GROUP("depth prepass");
+		state.set_color_mask(false);
+		queue.draw(vertexArrayObject, indexType, m_drawBuffers, &m_depthPrepassPrograms);
+		state.set_color_mask(true);
+		state.set_depth_func(GL_LEQUAL);
+		state.set_depth_mask(false);
+	}
+
+	// a slot whose previous query has not landed yet is skipped this frame rather than waited on
+	bool measure = read_back_overdraw(cfg);
+	{
+		UF_GL_DEBUG_GROUP(overdrawView ? "overdraw view" : "opaque");
+		if (measure) {
+			glBeginQuery(GL_SAMPLES_PASSED, m_overdrawQueries[m_overdrawQueryIdx]);
+		}
+		queue.draw(vertexArrayObject, indexType, m_drawBuffers, overdrawView ? &m_overdrawPrograms : nullptr);
+		if (measure) {
+			glEndQuery(GL_SAMPLES_PASSED);
+			m_overdrawQueryPending[m_overdrawQueryIdx] = true;
+			m_overdrawQueryIdx = (m_overdrawQueryIdx + 1) % OVERDRAW_QUERY_FRAMES;
+		}
+	}
+
+	if (!overdrawView) {
+		// impostors write their own depth, they test and write like any opaque draw
+		state.set_depth_func(GL_LESS);
+		state.set_depth_mask(true);
+		UF_GL_DEBUG_GROUP("impostors");
+		m_impostorRenderer.draw(impostors.data(), static_cast<uint32_t>(impostors.size()), worldMatrices, colors, vertexArrayObject, frameArena);
+	}
+	CATCH_GL_ERROR("error drawing the scene");
+}
+
+bool Renderer::read_back_overdraw(const EngineConfig& cfg) {
+	GLuint query = m_overdrawQueries[m_overdrawQueryIdx];
+	if (query == 0) {
+		return false;
+	}
+	if (!m_overdrawQueryPending[m_overdrawQueryIdx]) {
+		return true;
+	}
+	GLint available = 0;
+	glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) {
+		return false;
+	}
+	GLuint64 samples = 0;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &samples);
+	m_overdrawQueryPending[m_overdrawQueryIdx] = false;
+	m_overdrawStats.m_samplesShaded = samples;
+	uint64_t pixels = static_cast<uint64_t>(cfg.m_screenWidth) * static_cast<uint64_t>(cfg.m_screenHeight);
+	m_overdrawStats.m_overdraw = pixels ? static_cast<float>(static_cast<double>(samples) / static_cast<double>(pixels)) : 0.0f;
+	return true;
+}
+
+void Renderer::render_gpu_culled(RenderQueue& queue, GLuint vertexArrayObject, GLenum indexType, const RenderView& view, const EngineConfig& cfg,
+	FrameVector<ImpostorInstance>& impostors, const glm::mat4* worldMatrices, const glm::vec4* colors, FrameArena& frameArena) {
+	if (!m_sceneTarget.resize(cfg.m_screenWidth, cfg.m_screenHeight)) {
+		return;
+	}
+	glm::mat4 viewProjection = view.m_projection * view.m_view;
+
+	// cpu side this is only the dispatch, the tests themselves run on the gpu
+	auto cullStart = std::chrono::steady_clock::now();
+	{
+		UF_GL_DEBUG_GROUP("gpu cull");
+		m_gpuCuller.cull(m_drawBuffers, queue.size(), Frustum(viewProjection));
+	}
+	m_visibilityStats.m_tested = queue.size();
+	uint32_t visibleCount = std::min(m_gpuCuller.get_visible_count(), queue.size());
+	m_visibilityStats.m_gpuCulled = queue.size() - visibleCount;
+	m_visibilityStats.m_cullMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+
+	m_sceneTarget.bind();
+	GLStateCache& state = GLStateCache::get();
+	state.set_clear_color(0.0f, 0.0f, 0.0f, 1.0f);
+	state.set_depth_mask(true);
+	state.set_color_mask(true);
+	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+	// billboards are not part of the compute cull, they are cheap enough to leave to the rasterizer
+	draw_scene(queue, vertexArrayObject, indexType, view, cfg, impostors, worldMatrices, colors, frameArena);
+
+	state.bind_framebuffer(GL_FRAMEBUFFER, 0);
+	state.set_viewport(0, 0, cfg.m_screenWidth, cfg.m_screenHeight);
+	m_sceneTarget.blit_to_screen(cfg.m_screenWidth, cfg.m_screenHeight);
+
+	// next frame's occlusion tests run against this frame's depth
+	UF_GL_DEBUG_GROUP("depth pyramid");
+	m_gpuCuller.build_depth_pyramid(m_sceneTarget.get_depth_texture(), m_sceneTarget.get_width(), m_sceneTarget.get_height(), viewProjection);
+}
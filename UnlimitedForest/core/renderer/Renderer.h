@@ -0,0 +1,119 @@
+#pragma once
+
+#include <application/EngineConfig.h>
+#include <culling/Frustum.h>
+#include <culling/OcclusionBuffer.h>
+#include <far_field/FarField.h>
+#include <gpu_buffer/GpuBuffer.h>
+#include <gpu_culling/GpuCuller.h>
+#include <impostor/ImpostorRenderer.h>
+#include <memory/FrameArena.h>
+#include <mesh_manager/MeshManager.h>
+#include <render_queue/RenderQueue.h>
+#include <render_target/RenderTarget.h>
+#include <shader/ShaderPermutations.h>
+#include <shader/ShaderProgram.h>
+#include "FrameUniforms.h"
+
+#include <chrono>
+#include <string>
+#include <glad/glad.h>
+
+class ComponentStore;
+class NodeManager;
+
+// what the visibility pass removed before anything reached the render queue
+struct VisibilityStats {
+	uint32_t m_tested = 0;
+	uint32_t m_frustumCulled = 0;
+	// gpu path: frustum + occlusion rejects of the newest cull read back, a couple of frames behind
+	uint32_t m_gpuCulled = 0;
+	float m_cullMs = 0.0f;
+	// software occlusion, tested counts the items that survived the frustum
+	uint32_t m_occluders = 0;
+	uint32_t m_occluderTriangles = 0;
+	uint32_t m_occlusionTested = 0;
+	uint32_t m_occlusionCulled = 0;
+	float m_occlusionMs = 0.0f;
+	// items past the impostor distance drawn as billboards instead of meshes
+	uint32_t m_impostors = 0;
+};
+
+// shaded samples of the mesh queue's color pass, from an occlusion query read back a few frames late
+struct OverdrawStats {
+	uint64_t m_samplesShaded = 0;
+	// shaded samples per screen pixel, 1 is the floor for a fully covered screen
+	float m_overdraw = 0.0f;
+};
+
+// owns the per-frame render flow: gather visible items into a render queue, sort it, submit it
+class Renderer {
+public:
+	Renderer();
+	~Renderer();
+
+	// creates gpu side resources, needs a current gl context
+	bool init(const ShaderProgram& program);
+	// optional compute culling path, render() falls back to the cpu if this was never set up
+	bool init_gpu_culling(const std::string& cullShaderPath, const std::string& pyramidShaderPath);
+	// billboard path for distant items, species are registered through get_impostors() and baked by the caller
+	bool init_impostors(const std::string& vertexPath, const std::string& fragmentPath);
+	// horizon panorama drawn behind the scene when EngineConfig::m_farField is set
+	bool init_far_field(const std::string& vertexPath, const std::string& captureFragmentPath, const std::string& compositeFragmentPath, int resolution);
+	// depth only pass over the queue ahead of shading, used when EngineConfig::m_depthPrepass is set
+	bool init_depth_prepass(const std::string& vertexPath, const std::string& fragmentPath);
+	// heat map program drawn in place of the scene's when EngineConfig::m_overdrawView is set
+	bool init_overdraw_view(const std::string& vertexPath, const std::string& fragmentPath);
+	void destroy(void);
+
+	// every queued instance draws with the variant of programs its features need, see ShaderPermutations
+	void render(NodeManager& nodeManager, const MeshManager& meshManager, FrameArena& frameArena, const EngineConfig& cfg, ShaderPermutations& programs);
+
+	const RenderStats& get_frame_stats(void) const { return m_frameStats; }
+	const VisibilityStats& get_visibility_stats(void) const { return m_visibilityStats; }
+	const OverdrawStats& get_overdraw_stats(void) const { return m_overdrawStats; }
+	ImpostorRenderer& get_impostors(void) { return m_impostorRenderer; }
+
+private:
+	// writes the per-frame block every program reads camera state from
+	void update_frame_uniforms(const RenderView& view, const glm::vec3& cameraPosition);
+	// writes 1 per row whose bounds touch the frustum, split across the job system's workers
+	void cull_frustum(const ComponentStore& store, const Frustum& frustum, uint8_t* inFrustum);
+	// rasterizes nearby occluders into the occlusion buffer and clears the flag of every row hidden behind them
+	void cull_occlusion(const ComponentStore& store, const MeshManager& meshManager, FrameArena& frameArena, const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const EngineConfig& cfg, uint8_t* potentiallyVisible);
+	// the scene's passes into whatever framebuffer is bound: far field, optional depth prepass, queue, impostors
+	// every pass declares the full depth / cull / blend state it needs, the state cache drops what did not change
+	void draw_scene(RenderQueue& queue, GLuint vertexArrayObject, GLenum indexType, const RenderView& view, const EngineConfig& cfg,
+		FrameVector<ImpostorInstance>& impostors, const glm::mat4* worldMatrices, const glm::vec4* colors, FrameArena& frameArena);
+	// picks up the oldest finished samples query, returns false while that slot's query is still in flight
+	bool read_back_overdraw(const EngineConfig& cfg);
+	// culls the uploaded queue in a compute pass, draws it offscreen with depth and reduces that depth
+	// into the pyramid the next frame's occlusion tests read
+	// impostors are drawn into the same target, after the culled queue
+	void render_gpu_culled(RenderQueue& queue, GLuint vertexArrayObject, GLenum indexType, const RenderView& view, const EngineConfig& cfg,
+		FrameVector<ImpostorInstance>& impostors, const glm::mat4* worldMatrices, const glm::vec4* colors, FrameArena& frameArena);
+
+	GpuBuffer m_frameUniformBuffer;
+	// per-instance / per-draw / indirect streams, rewritten every frame in sorted order
+	DrawBuffers m_drawBuffers;
+	// gpu culling draws offscreen so the frame's depth can be reduced into next frame's pyramid
+	GpuCuller m_gpuCuller;
+	RenderTarget m_sceneTarget;
+	OcclusionBuffer m_occlusionBuffer;
+	ImpostorRenderer m_impostorRenderer;
+	FarField m_farField;
+	ShaderPermutations m_depthPrepassPrograms;
+	ShaderPermutations m_overdrawPrograms;
+	// samples passed queries around the queue's color pass, cycled so reading one never waits on the gpu
+	static constexpr uint32_t OVERDRAW_QUERY_FRAMES = 3;
+	GLuint m_overdrawQueries[OVERDRAW_QUERY_FRAMES];
+	bool m_overdrawQueryPending[OVERDRAW_QUERY_FRAMES];
+	uint32_t m_overdrawQueryIdx;
+	OverdrawStats m_overdrawStats;
+	std::chrono::steady_clock::time_point m_startTime;
+	RenderStats m_frameStats;
+	VisibilityStats m_visibilityStats;
+	uint64_t m_frameIdx;
+	// set once the missing dither variant has been reported, lod fades then switch hard
+	bool m_hardLodSwitchLogged;
+};
@@ -0,0 +1,313 @@
+#include "ProgramCache.h"
+#include <log/Log.h>
+#include <utilities/Util.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+	// "UFPB", bump the version whenever the header layout changes
+	constexpr uint32_t BINARY_MAGIC = 0x42504655;
+	constexpr uint32_t BINARY_VERSION = 1;
+
+	struct ProgramBinaryHeader {
+		uint32_t m_magic;
+		uint32_t m_version;
+		uint64_t m_key;
+		uint32_t m_format;
+		uint32_t m_length;
+	};
+
+	// glMaxShaderCompilerThreadsKHR / ARB
+	using MaxShaderCompilerThreadsProc = void (APIENTRYP)(GLuint count);
+
+	const char* shader_type_name(GLenum type) {
+		switch (type) {
+		case GL_VERTEX_SHADER: return "vertex";
+		case GL_FRAGMENT_SHADER: return "fragment";
+		case GL_COMPUTE_SHADER: return "compute";
+		default: return "unknown";
+		}
+	}
+
+	bool has_extension(const char* name) {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++) {
+			const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+			if (extension && std::strcmp(extension, name) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	uint64_t hash_gl_string(GLenum name, uint64_t seed) {
+		const char* value = reinterpret_cast<const char*>(glGetString(name));
+		return value ? hash_fnv1a(value, std::strlen(value), seed) : seed;
+	}
+}
+
+ProgramCache& ProgramCache::get() {
+	static ProgramCache cache;
+	return cache;
+}
+
+ProgramCache::ProgramCache() : m_driverHash(FNV_OFFSET_BASIS), m_binaries(false), m_parallelCompile(false) {}
+
+void ProgramCache::init(const std::string& directory, GLADloadproc loadProc) {
+	clear();
+	m_stats = ProgramCacheStats();
+
+	// a binary is only valid for the driver build that produced it, any of these changing invalidates the lot
+	m_driverHash = hash_gl_string(GL_VENDOR, FNV_OFFSET_BASIS);
+	m_driverHash = hash_gl_string(GL_RENDERER, m_driverHash);
+	m_driverHash = hash_gl_string(GL_VERSION, m_driverHash);
+	m_driverHash = hash_gl_string(GL_SHADING_LANGUAGE_VERSION, m_driverHash);
+
+	GLint binaryFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+	m_directory = directory;
+	m_binaries = !m_directory.empty() && binaryFormats > 0;
+	if (m_binaries) {
+		std::error_code error;
+		std::filesystem::create_directories(m_directory, error);
+		if (error) {
+			UF_LOG_WARN("can not create the program cache directory {}: {}", m_directory, error.message());
+			m_binaries = false;
+		}
+	}
+
+	// the KHR and ARB versions only differ in name, either lets compiles run on driver threads
+	MaxShaderCompilerThreadsProc maxCompilerThreads = nullptr;
+	if (has_extension("GL_KHR_parallel_shader_compile")) {
+		maxCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(loadProc("glMaxShaderCompilerThreadsKHR"));
+	}
+	else if (has_extension("GL_ARB_parallel_shader_compile")) {
+		maxCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(loadProc("glMaxShaderCompilerThreadsARB"));
+	}
+	m_parallelCompile = maxCompilerThreads != nullptr;
+	if (m_parallelCompile) {
+		// all ones leaves the thread count to the driver
+		maxCompilerThreads(0xFFFFFFFFu);
+	}
+
+	UF_LOG_INFO("program cache: binaries {} ({} formats), parallel compile {}",
+		m_binaries ? m_directory : "off",
+		binaryFormats,
+		m_parallelCompile ? "on" : "off"
+	);
+}
+
+void ProgramCache::clear() {
+	for (auto& [key, pending] : m_prefetched) {
+		for (uint32_t i = 0; i < pending.m_shaderCount; i++) {
+			glDeleteShader(pending.m_shaders[i]);
+		}
+		glDeleteProgram(pending.m_program);
+	}
+	if (!m_prefetched.empty()) {
+		UF_LOG_INFO("{} prefetched programs were never used", m_prefetched.size());
+	}
+	m_prefetched.clear();
+}
+
+uint64_t ProgramCache::make_key(const ShaderStageSource* stages, uint32_t stageCount) const {
+	uint64_t key = m_driverHash;
+	for (uint32_t i = 0; i < stageCount; i++) {
+		key = hash_fnv1a(&stages[i].m_type, sizeof(stages[i].m_type), key);
+		key = hash_fnv1a(stages[i].m_source.data(), stages[i].m_source.size(), key);
+	}
+	return key;
+}
+
+std::string ProgramCache::get_binary_path(uint64_t key) const {
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return (std::filesystem::path(m_directory) / name).string();
+}
+
+void ProgramCache::prefetch(const ShaderStageSource* stages, uint32_t stageCount) {
+	uint64_t key = make_key(stages, stageCount);
+	if (m_prefetched.find(key) != m_prefetched.end()) {
+		return;
+	}
+	PendingProgram pending = begin(stages, stageCount);
+	if (pending.m_program) {
+		m_prefetched.emplace(key, pending);
+		m_stats.m_prefetched++;
+	}
+}
+
+PendingProgram ProgramCache::begin(const ShaderStageSource* stages, uint32_t stageCount) {
+	PendingProgram pending;
+	if (stageCount == 0 || stageCount > PendingProgram::MAX_STAGES) {
+		UF_LOG_ERROR("can not build a program from {} stages", stageCount);
+		return pending;
+	}
+	pending.m_key = make_key(stages, stageCount);
+
+	auto prefetched = m_prefetched.find(pending.m_key);
+	if (prefetched != m_prefetched.end()) {
+		pending = prefetched->second;
+		m_prefetched.erase(prefetched);
+		return pending;
+	}
+
+	pending.m_program = glCreateProgram();
+	if (m_binaries && load_binary(pending.m_key, pending.m_program)) {
+		pending.m_fromBinary = true;
+		m_stats.m_binaryHits++;
+		return pending;
+	}
+
+	// nothing below asks gl for a status, so with parallel compile none of it waits for the compiler
+	for (uint32_t i = 0; i < stageCount; i++) {
+		GLuint shader = glCreateShader(stages[i].m_type);
+		const char* source = stages[i].m_source.data();
+		GLint length = static_cast<GLint>(stages[i].m_source.size());
+		glShaderSource(shader, 1, &source, &length);
+		glCompileShader(shader);
+		glAttachShader(pending.m_program, shader);
+		pending.m_shaders[i] = shader;
+		pending.m_stageTypes[i] = stages[i].m_type;
+	}
+	pending.m_shaderCount = stageCount;
+	if (m_binaries) {
+		glProgramParameteri(pending.m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glLinkProgram(pending.m_program);
+	m_stats.m_compiled++;
+	return pending;
+}
+
+bool ProgramCache::is_complete(const PendingProgram& pending) const {
+	if (!m_parallelCompile || pending.m_fromBinary) {
+		return true;
+	}
+	GLint complete = GL_TRUE;
+	glGetProgramiv(pending.m_program, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete == GL_TRUE;
+}
+
+GLuint ProgramCache::finish(PendingProgram& pending) {
+	if (!pending.m_program) {
+		return 0;
+	}
+	auto waitStart = std::chrono::steady_clock::now();
+	GLint status;
+	glGetProgramiv(pending.m_program, GL_LINK_STATUS, &status);
+	m_stats.m_waitMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+
+	if (status == GL_FALSE) {
+		// a failed compile also fails the link, its log is the one that says what is wrong
+		for (uint32_t i = 0; i < pending.m_shaderCount; i++) {
+			GLint compiled;
+			glGetShaderiv(pending.m_shaders[i], GL_COMPILE_STATUS, &compiled);
+			if (compiled == GL_FALSE) {
+				GLint length;
+				glGetShaderiv(pending.m_shaders[i], GL_INFO_LOG_LENGTH, &length);
+				std::vector<char> log(length > 0 ? length : 1, '\0');
+				glGetShaderInfoLog(pending.m_shaders[i], length, nullptr, log.data());
+				UF_LOG_ERROR("shader compilation failed ({}): {}", shader_type_name(pending.m_stageTypes[i]), log.data());
+			}
+		}
+		GLint length;
+		glGetProgramiv(pending.m_program, GL_INFO_LOG_LENGTH, &length);
+		std::vector<char> log(length > 0 ? length : 1, '\0');
+		glGetProgramInfoLog(pending.m_program, length, nullptr, log.data());
+		UF_LOG_ERROR("program linking failed: {}", log.data());
+	}
+
+	for (uint32_t i = 0; i < pending.m_shaderCount; i++) {
+		glDetachShader(pending.m_program, pending.m_shaders[i]);
+		glDeleteShader(pending.m_shaders[i]);
+	}
+	pending.m_shaderCount = 0;
+
+	GLuint program = pending.m_program;
+	pending.m_program = 0;
+	if (status == GL_FALSE) {
+		glDeleteProgram(program);
+		return 0;
+	}
+	if (m_binaries && !pending.m_fromBinary) {
+		store_binary(pending.m_key, program);
+	}
+	return program;
+}
+
+bool ProgramCache::load_binary(uint64_t key, GLuint program) {
+	std::string path = get_binary_path(key);
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+	std::streamoff fileSize = file.tellg();
+	file.seekg(0);
+	ProgramBinaryHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	// the length is only trusted once it matches what actually follows the header
+	bool valid = file.gcount() == static_cast<std::streamsize>(sizeof(header))
+		&& header.m_magic == BINARY_MAGIC && header.m_version == BINARY_VERSION && header.m_key == key
+		&& header.m_length > 0 && static_cast<std::streamoff>(header.m_length) == fileSize - static_cast<std::streamoff>(sizeof(header));
+	std::vector<char> binary;
+	if (valid) {
+		binary.resize(header.m_length);
+		file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+		valid = file.gcount() == static_cast<std::streamsize>(binary.size());
+	}
+	file.close();
+
+	GLint status = GL_FALSE;
+	if (valid) {
+		glProgramBinary(program, header.m_format, binary.data(), static_cast<GLsizei>(binary.size()));
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+	}
+	if (status == GL_FALSE) {
+		// stale, truncated or rejected by the driver, a miss: drop it so the rebuilt program's binary takes its place
+		UF_LOG_WARN("discarding unusable program binary {}", path);
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		m_stats.m_binaryRejected++;
+		return false;
+	}
+	return true;
+}
+
+void ProgramCache::store_binary(uint64_t key, GLuint program) {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+	std::vector<char> binary(static_cast<size_t>(length));
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	ProgramBinaryHeader header = { BINARY_MAGIC, BINARY_VERSION, key, format, static_cast<uint32_t>(length) };
+	// written next to the final name and moved over it, a crash mid write never leaves a half binary behind
+	std::string path = get_binary_path(key);
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), length);
+		if (!file) {
+			UF_LOG_WARN("can not write program binary {}", tempPath);
+			return;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	if (error) {
+		UF_LOG_WARN("can not store program binary {}: {}", path, error.message());
+		std::filesystem::remove(tempPath, error);
+		return;
+	}
+	m_stats.m_stored++;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <glad/glad.h>
+
+// GL_KHR_parallel_shader_compile (same values as the ARB version), the generated loader does not include it
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+struct ShaderStageSource {
+	GLenum m_type = 0;
+	std::string_view m_source;
+};
+
+// a program whose compile / link has been issued but whose status nobody asked for yet,
+// asking is what makes the driver finish it on the calling thread
+struct PendingProgram {
+	static constexpr uint32_t MAX_STAGES = 2;
+
+	GLuint m_program = 0;
+	// still attached so their info logs can be read if the link fails
+	GLuint m_shaders[MAX_STAGES] = {};
+	GLenum m_stageTypes[MAX_STAGES] = {};
+	uint32_t m_shaderCount = 0;
+	uint64_t m_key = 0;
+	bool m_fromBinary = false;
+};
+
+struct ProgramCacheStats {
+	uint32_t m_prefetched = 0;
+	uint32_t m_binaryHits = 0;
+	// binaries the driver refused (usually after a driver update), rebuilt from source
+	uint32_t m_binaryRejected = 0;
+	uint32_t m_compiled = 0;
+	uint32_t m_stored = 0;
+	// time spent blocked in finish()
+	float m_waitMs = 0.0f;
+};
+
+// builds every gl program: linked binaries are kept on disk keyed by the sources and the driver, and
+// programs prefetched at startup compile on the driver's threads while the engine does other work
+class ProgramCache {
+public:
+	// programs belong to the engine's single context, so there is a single cache
+	static ProgramCache& get(void);
+
+	// needs a current context, an empty directory keeps binaries off disk
+	// without init() every program is compiled from source, one at a time
+	void init(const std::string& directory, GLADloadproc loadProc);
+	// deletes prefetched programs that were never picked up, must run before the context goes away
+	void clear(void);
+
+	// starts building a program ahead of the create() that needs it, that create() only waits for it
+	void prefetch(const ShaderStageSource* stages, uint32_t stageCount);
+	// the prefetched program for these sources, or one loaded from disk, or a freshly issued compile + link
+	PendingProgram begin(const ShaderStageSource* stages, uint32_t stageCount);
+	// blocks until the program is linked, stores fresh binaries, returns 0 (and logs why) on failure
+	GLuint finish(PendingProgram& pending);
+	// true once finish() would not block, without parallel compile the driver can not tell, so always true
+	bool is_complete(const PendingProgram& pending) const;
+
+	bool has_parallel_compile(void) const { return m_parallelCompile; }
+	bool has_binaries(void) const { return m_binaries; }
+	const ProgramCacheStats& get_stats(void) const { return m_stats; }
+
+private:
+	ProgramCache();
+
+	uint64_t make_key(const ShaderStageSource* stages, uint32_t stageCount) const;
+	std::string get_binary_path(uint64_t key) const;
+	// false if there is no binary or the driver rejected it, the program is then still unlinked
+	bool load_binary(uint64_t key, GLuint program);
+	void store_binary(uint64_t key, GLuint program);
+
+	std::string m_directory;
+	uint64_t m_driverHash;
+	bool m_binaries;
+	bool m_parallelCompile;
+	std::unordered_map<uint64_t, PendingProgram> m_prefetched;
+	ProgramCacheStats m_stats;
+};
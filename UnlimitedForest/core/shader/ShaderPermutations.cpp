@@ -0,0 +1,84 @@
+#include "ShaderPermutations.h"
+#include <log/Log.h>
+
+#include <vector>
+
+ShaderPermutations::ShaderPermutations() {}
+
+ShaderPermutations::~ShaderPermutations() {
+	destroy();
+}
+
+bool ShaderPermutations::create_from_files(const std::string& vertexPath, const std::string& fragmentPath) {
+	destroy();
+	if (!m_vertex.load(vertexPath) || !m_fragment.load(fragmentPath)) {
+		UF_LOG_ERROR("failed to load shader permutations of {} + {}", vertexPath, fragmentPath);
+		return false;
+	}
+	return true;
+}
+
+void ShaderPermutations::destroy() {
+	// each variant deletes its program
+	m_variants.clear();
+}
+
+const char* ShaderPermutations::get_feature_define(ShaderFeature feature) {
+	switch (feature) {
+	case SHADER_FEATURE_LOD_DITHER: return "UF_LOD_DITHER";
+	default: return nullptr;
+	}
+}
+
+std::string ShaderPermutations::make_variant_source(const std::string& source, uint32_t features) {
+	std::vector<const char*> defines;
+	for (uint32_t bit = 0; bit < SHADER_FEATURE_COUNT; bit++) {
+		if (features & (1u << bit)) {
+			defines.push_back(get_feature_define(static_cast<ShaderFeature>(1u << bit)));
+		}
+	}
+	return ShaderPreprocessor::add_defines(source, defines);
+}
+
+ShaderProgram* ShaderPermutations::get(uint32_t features) {
+	auto found = m_variants.find(features);
+	if (found != m_variants.end()) {
+		return found->second.get();
+	}
+	if (!is_valid()) {
+		return nullptr;
+	}
+
+	std::unique_ptr<ShaderProgram> variant = std::make_unique<ShaderProgram>();
+	if (!variant->create(make_variant_source(m_vertex.get_source(), features), make_variant_source(m_fragment.get_source(), features))) {
+		// compiler messages name files by number, this is what the numbers mean
+		UF_LOG_ERROR("shader variant {:#x} of {} + {} failed to build", features, m_vertex.get_files()[0], m_fragment.get_files()[0]);
+		for (size_t i = 0; i < m_vertex.get_files().size(); i++) {
+			UF_LOG_ERROR("  vertex source {}: {}", i, m_vertex.get_files()[i]);
+		}
+		for (size_t i = 0; i < m_fragment.get_files().size(); i++) {
+			UF_LOG_ERROR("  fragment source {}: {}", i, m_fragment.get_files()[i]);
+		}
+		variant.reset();
+	}
+	ShaderProgram* program = variant.get();
+	m_variants.emplace(features, std::move(variant));
+	return program;
+}
+
+void ShaderPermutations::prefetch(uint32_t features) const {
+	if (!is_valid() || m_variants.find(features) != m_variants.end()) {
+		return;
+	}
+	std::string vertexSource = make_variant_source(m_vertex.get_source(), features);
+	std::string fragmentSource = make_variant_source(m_fragment.get_source(), features);
+	const ShaderStageSource stages[] = { { GL_VERTEX_SHADER, vertexSource }, { GL_FRAGMENT_SHADER, fragmentSource } };
+	ProgramCache::get().prefetch(stages, 2);
+}
+
+void ShaderPermutations::prefetch_from_files(const std::string& vertexPath, const std::string& fragmentPath, uint32_t features) {
+	ShaderPermutations permutations;
+	if (permutations.create_from_files(vertexPath, fragmentPath)) {
+		permutations.prefetch(features);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ShaderPreprocessor.h"
+#include "ShaderProgram.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// compile time features a program variant is specialized for, each one is a #define in every stage
+// a permutation key is any combination of these bits
+enum ShaderFeature : uint32_t {
+	// lod cross-fade dither discard (UF_LOD_DITHER), only instances fading between two levels need it
+	SHADER_FEATURE_LOD_DITHER = 1 << 0,
+};
+constexpr uint32_t SHADER_FEATURE_COUNT = 1;
+
+// the variants of one vertex + fragment pair, keyed by their feature bits
+// each variant is compiled the first time it is asked for with a #define per feature in place of runtime
+// branches, so a draw runs a program that does exactly what its features need and nothing else
+// variants go through the ProgramCache like any program, so they are cached on disk per key as well
+class ShaderPermutations {
+public:
+	ShaderPermutations();
+	~ShaderPermutations();
+
+	ShaderPermutations(const ShaderPermutations&) = delete;
+	ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+	// reads and preprocesses both stages, no variant is built yet
+	bool create_from_files(const std::string& vertexPath, const std::string& fragmentPath);
+	void destroy(void);
+	bool is_valid(void) const { return !m_vertex.get_source().empty() && !m_fragment.get_source().empty(); }
+
+	// builds the variant on first use, nullptr if it does not build (logged once, never retried)
+	ShaderProgram* get(uint32_t features);
+	// starts the driver on a variant a later get() will ask for, see ProgramCache::prefetch
+	void prefetch(uint32_t features) const;
+	static void prefetch_from_files(const std::string& vertexPath, const std::string& fragmentPath, uint32_t features);
+
+	uint32_t get_variant_count(void) const { return static_cast<uint32_t>(m_variants.size()); }
+
+	// the define a single feature bit turns into
+	static const char* get_feature_define(ShaderFeature feature);
+	// a stage's source as the variant for these features compiles it
+	static std::string make_variant_source(const std::string& source, uint32_t features);
+
+private:
+	ShaderPreprocessor m_vertex;
+	ShaderPreprocessor m_fragment;
+	// nullptr marks a variant that failed to build
+	std::unordered_map<uint32_t, std::unique_ptr<ShaderProgram>> m_variants;
+};
@@ -0,0 +1,115 @@
+#include "ShaderPreprocessor.h"
+#include <log/Log.h>
+
+#include <algorithm>
+#include <fstream>
+
+namespace {
+	enum class IncludeLine {
+		NONE,
+		INCLUDE,
+		MALFORMED
+	};
+
+	// #include "name", whitespace allowed around the # and the name, anything else passes through untouched
+	IncludeLine parse_include(const std::string& line, std::string& name) {
+		size_t pos = line.find_first_not_of(" \t");
+		if (pos == std::string::npos || line[pos] != '#') {
+			return IncludeLine::NONE;
+		}
+		pos = line.find_first_not_of(" \t", pos + 1);
+		if (pos == std::string::npos || line.compare(pos, 7, "include") != 0) {
+			return IncludeLine::NONE;
+		}
+		size_t open = line.find('"', pos + 7);
+		size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+		if (close == std::string::npos || close == open + 1) {
+			return IncludeLine::MALFORMED;
+		}
+		name = line.substr(open + 1, close - open - 1);
+		return IncludeLine::INCLUDE;
+	}
+}
+
+bool ShaderPreprocessor::load(const std::string& path) {
+	m_source.clear();
+	m_files.clear();
+	if (!expand(std::filesystem::path(path).lexically_normal(), m_source)) {
+		m_source.clear();
+		return false;
+	}
+	return true;
+}
+
+bool ShaderPreprocessor::expand(const std::filesystem::path& path, std::string& out) {
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		UF_LOG_ERROR("could not open shader file: {}", path.string());
+		return false;
+	}
+	size_t fileIdx = m_files.size();
+	m_files.push_back(path.string());
+	// the root file keeps its own numbering, #version has to stay its first line
+	if (fileIdx > 0) {
+		out += "#line 1 " + std::to_string(fileIdx) + "\n";
+	}
+
+	std::string line;
+	uint32_t lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		std::string name;
+		IncludeLine include = parse_include(line, name);
+		if (include == IncludeLine::NONE) {
+			out += line;
+			out += '\n';
+			continue;
+		}
+		if (include == IncludeLine::MALFORMED) {
+			UF_LOG_ERROR("{}({}): expected #include \"file\"", path.string(), lineNumber);
+			return false;
+		}
+
+		std::filesystem::path includePath = (path.parent_path() / name).lexically_normal();
+		if (std::find(m_files.begin(), m_files.end(), includePath.string()) != m_files.end()) {
+			// already part of this source, the empty line keeps the numbering
+			out += '\n';
+			continue;
+		}
+		if (!expand(includePath, out)) {
+			UF_LOG_ERROR("included from {}({})", path.string(), lineNumber);
+			return false;
+		}
+		out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIdx) + "\n";
+	}
+	return true;
+}
+
+std::string ShaderPreprocessor::add_defines(const std::string& source, const std::vector<const char*>& defines) {
+	if (defines.empty()) {
+		return source;
+	}
+	// after the end of the #version line, or at the very top for a source without one
+	size_t version = source.find("#version");
+	size_t insertAt = 0;
+	if (version != std::string::npos) {
+		size_t lineEnd = source.find('\n', version);
+		insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+	}
+	size_t nextLine = static_cast<size_t>(std::count(source.begin(), source.begin() + insertAt, '\n')) + 1;
+
+	std::string result;
+	result.reserve(source.size() + defines.size() * 32 + 16);
+	result.append(source, 0, insertAt);
+	if (insertAt > 0 && result.back() != '\n') {
+		result += '\n';
+	}
+	for (const char* define : defines) {
+		result += "#define ";
+		result += define;
+		result += " 1\n";
+	}
+	result += "#line " + std::to_string(nextLine) + " 0\n";
+	result.append(source, insertAt, std::string::npos);
+	return result;
+}
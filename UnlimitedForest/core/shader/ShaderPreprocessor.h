@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// turns a shader file into the single self contained source gl compiles:
+// #include "path" lines (relative to the including file) are replaced by that file, every file is included
+// once per source so shared headers need no guards, and #line directives keep compiler messages pointing at
+// the right line, their source string number indexes get_files()
+// includes are expanded before the glsl preprocessor runs, so an #include inside an #ifdef is still expanded
+class ShaderPreprocessor {
+public:
+	// false (and logged) if the file or one of its includes can not be read
+	bool load(const std::string& path);
+
+	const std::string& get_source(void) const { return m_source; }
+	const std::vector<std::string>& get_files(void) const { return m_files; }
+
+	// source with a #define per name right after the #version line, which has to stay the first directive
+	static std::string add_defines(const std::string& source, const std::vector<const char*>& defines);
+
+private:
+	bool expand(const std::filesystem::path& path, std::string& out);
+
+	std::string m_source;
+	std::vector<std::string> m_files;
+};
@@ -0,0 +1,309 @@
+#include "ShaderProgram.h"
+#include "ShaderPreprocessor.h"
+#include <log/Log.h>
+#include <gl_state/GLStateCache.h>
+#include <utilities/Util.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	// bytes a single element of a uniform type occupies in the shadow buffer
+	size_t uniform_type_size(GLenum type) {
+		switch (type) {
+		case GL_FLOAT_VEC2:
+		case GL_INT_VEC2:
+		case GL_UNSIGNED_INT_VEC2:
+			return 8;
+		case GL_FLOAT_VEC3:
+		case GL_INT_VEC3:
+		case GL_UNSIGNED_INT_VEC3:
+			return 12;
+		case GL_FLOAT_VEC4:
+		case GL_INT_VEC4:
+		case GL_UNSIGNED_INT_VEC4:
+			return 16;
+		case GL_FLOAT_MAT3:
+			return 36;
+		case GL_FLOAT_MAT4:
+			return 64;
+		default:
+			// scalars, bools and sampler / image units
+			return 4;
+		}
+	}
+}
+
+ShaderProgram::ShaderProgram() : m_program(0), m_uploadsIssued(0), m_uploadsSkipped(0) {}
+
+ShaderProgram::~ShaderProgram() {
+	destroy();
+}
+
+uint64_t ShaderProgram::hash_name(std::string_view name) {
+	// names are short so this is cheap enough to do on lookup
+	return hash_fnv1a(name.data(), name.size());
+}
+
+std::string ShaderProgram::load_source(const std::string& path) {
+	ShaderPreprocessor preprocessor;
+	if (!preprocessor.load(path)) {
+		return "";
+	}
+	return preprocessor.get_source();
+}
+
+bool ShaderProgram::create_from_files(const std::string& vertexPath, const std::string& fragmentPath) {
+	std::string vertexSource = load_source(vertexPath);
+	std::string fragmentSource = load_source(fragmentPath);
+	if (vertexSource.empty() || fragmentSource.empty()) {
+		return false;
+	}
+	return create(vertexSource, fragmentSource);
+}
+
+bool ShaderProgram::create(const std::string& vertexSource, const std::string& fragmentSource) {
+	const ShaderStageSource stages[] = { { GL_VERTEX_SHADER, vertexSource }, { GL_FRAGMENT_SHADER, fragmentSource } };
+	if (!build(stages, 2)) {
+		UF_LOG_ERROR("failed to build shader program");
+		return false;
+	}
+	return true;
+}
+
+bool ShaderProgram::create_compute(const std::string& computeSource) {
+	const ShaderStageSource stage = { GL_COMPUTE_SHADER, computeSource };
+	if (!build(&stage, 1)) {
+		UF_LOG_ERROR("failed to build compute program");
+		return false;
+	}
+	return true;
+}
+
+bool ShaderProgram::create_compute_from_file(const std::string& computePath) {
+	std::string computeSource = load_source(computePath);
+	if (computeSource.empty()) {
+		return false;
+	}
+	return create_compute(computeSource);
+}
+
+void ShaderProgram::prefetch_from_files(const std::string& vertexPath, const std::string& fragmentPath) {
+	// a missing file is reported again by the create() that needs it
+	std::string vertexSource = load_source(vertexPath);
+	std::string fragmentSource = load_source(fragmentPath);
+	if (!vertexSource.empty() && !fragmentSource.empty()) {
+		const ShaderStageSource stages[] = { { GL_VERTEX_SHADER, vertexSource }, { GL_FRAGMENT_SHADER, fragmentSource } };
+		ProgramCache::get().prefetch(stages, 2);
+	}
+}
+
+void ShaderProgram::prefetch_compute_from_file(const std::string& computePath) {
+	std::string computeSource = load_source(computePath);
+	if (!computeSource.empty()) {
+		const ShaderStageSource stage = { GL_COMPUTE_SHADER, computeSource };
+		ProgramCache::get().prefetch(&stage, 1);
+	}
+}
+
+bool ShaderProgram::build(const ShaderStageSource* stages, uint32_t stageCount) {
+	destroy();
+
+	ProgramCache& cache = ProgramCache::get();
+	PendingProgram pending = cache.begin(stages, stageCount);
+	GLuint programObject = cache.finish(pending);
+	if (!programObject) {
+		return false;
+	}
+
+	m_program = programObject;
+	reflect();
+	CATCH_GL_ERROR("error creating shader program");
+	return true;
+}
+
+void ShaderProgram::destroy() {
+	if (m_program) {
+		GLStateCache::get().forget_program(m_program);
+		glDeleteProgram(m_program);
+		m_program = 0;
+	}
+	m_uniforms.clear();
+	m_attributes.clear();
+	m_uniformBlocks.clear();
+	m_storageBlocks.clear();
+	m_shadowOffsets.clear();
+	m_shadowSizes.clear();
+	m_shadowValid.clear();
+	m_shadowData.clear();
+}
+
+void ShaderProgram::bind() const {
+	GLStateCache::get().use_program(m_program);
+}
+
+void ShaderProgram::reflect() {
+	reflect_interface(GL_UNIFORM, m_uniforms);
+	reflect_interface(GL_PROGRAM_INPUT, m_attributes);
+	reflect_interface(GL_UNIFORM_BLOCK, m_uniformBlocks);
+	reflect_interface(GL_SHADER_STORAGE_BLOCK, m_storageBlocks);
+
+	// lay out a shadow slot for every default block uniform so setters can skip unchanged uploads
+	GLint maxLocation = -1;
+	for (const auto& [hash, uniform] : m_uniforms) {
+		maxLocation = std::max(maxLocation, uniform.m_location);
+	}
+	m_shadowOffsets.assign(maxLocation + 1, -1);
+	m_shadowSizes.assign(maxLocation + 1, 0);
+	m_shadowValid.assign(maxLocation + 1, 0);
+	size_t shadowSize = 0;
+	for (const auto& [hash, uniform] : m_uniforms) {
+		if (uniform.m_location < 0) {
+			continue;
+		}
+		m_shadowOffsets[uniform.m_location] = static_cast<int32_t>(shadowSize);
+		m_shadowSizes[uniform.m_location] = static_cast<uint8_t>(uniform_type_size(uniform.m_type));
+		shadowSize += m_shadowSizes[uniform.m_location];
+	}
+	m_shadowData.assign(shadowSize, 0);
+
+	UF_LOG_DEBUG("program {} reflected {} uniforms, {} attributes, {} uniform blocks, {} storage blocks",
+		m_program,
+		m_uniforms.size(),
+		m_attributes.size(),
+		m_uniformBlocks.size(),
+		m_storageBlocks.size()
+	);
+}
+
+void ShaderProgram::reflect_interface(GLenum programInterface, ResourceTable& table) {
+	GLint resourceCount = 0;
+	GLint maxNameLength = 0;
+	glGetProgramInterfaceiv(m_program, programInterface, GL_ACTIVE_RESOURCES, &resourceCount);
+	glGetProgramInterfaceiv(m_program, programInterface, GL_MAX_NAME_LENGTH, &maxNameLength);
+	std::vector<char> nameBuffer(maxNameLength > 0 ? maxNameLength : 1, '\0');
+
+	bool isBlock = programInterface == GL_UNIFORM_BLOCK || programInterface == GL_SHADER_STORAGE_BLOCK;
+	for (GLint i = 0; i < resourceCount; i++) {
+		GLsizei nameLength = 0;
+		glGetProgramResourceName(m_program, programInterface, i, static_cast<GLsizei>(nameBuffer.size()), &nameLength, nameBuffer.data());
+
+		ShaderResource resource;
+		resource.m_name.assign(nameBuffer.data(), nameLength);
+		// arrays reflect as name[0], strip it so lookups use the plain name
+		if (resource.m_name.size() > 3 && resource.m_name.compare(resource.m_name.size() - 3, 3, "[0]") == 0) {
+			resource.m_name.resize(resource.m_name.size() - 3);
+		}
+
+		if (isBlock) {
+			const GLenum props[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+			GLint values[2] = { -1, 0 };
+			glGetProgramResourceiv(m_program, programInterface, i, 2, props, 2, nullptr, values);
+			resource.m_blockIndex = i;
+			resource.m_binding = values[0];
+			resource.m_dataSize = values[1];
+		}
+		else if (programInterface == GL_UNIFORM) {
+			const GLenum props[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX };
+			GLint values[4] = { 0, 1, -1, -1 };
+			glGetProgramResourceiv(m_program, programInterface, i, 4, props, 4, nullptr, values);
+			resource.m_type = static_cast<GLenum>(values[0]);
+			resource.m_arraySize = values[1];
+			resource.m_location = values[2];
+			resource.m_blockIndex = values[3];
+		}
+		else {
+			const GLenum props[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION };
+			GLint values[3] = { 0, 1, -1 };
+			glGetProgramResourceiv(m_program, programInterface, i, 3, props, 3, nullptr, values);
+			resource.m_type = static_cast<GLenum>(values[0]);
+			resource.m_arraySize = values[1];
+			resource.m_location = values[2];
+		}
+
+		uint64_t hash = hash_name(resource.m_name);
+		table.emplace(hash, std::move(resource));
+	}
+}
+
+const ShaderResource* ShaderProgram::find(const ResourceTable& table, std::string_view name) {
+	auto it = table.find(hash_name(name));
+	// guard against the (unlikely) hash collision
+	if (it == table.end() || it->second.m_name != name) {
+		return nullptr;
+	}
+	return &it->second;
+}
+
+GLint ShaderProgram::get_uniform_location(std::string_view name) const {
+	const ShaderResource* uniform = find(m_uniforms, name);
+	return uniform ? uniform->m_location : -1;
+}
+
+const ShaderResource* ShaderProgram::find_uniform(std::string_view name) const {
+	return find(m_uniforms, name);
+}
+
+const ShaderResource* ShaderProgram::find_attribute(std::string_view name) const {
+	return find(m_attributes, name);
+}
+
+const ShaderResource* ShaderProgram::find_uniform_block(std::string_view name) const {
+	return find(m_uniformBlocks, name);
+}
+
+const ShaderResource* ShaderProgram::find_storage_block(std::string_view name) const {
+	return find(m_storageBlocks, name);
+}
+
+bool ShaderProgram::update_shadow(GLint location, const void* value, size_t size) {
+	if (location < 0 || location >= static_cast<GLint>(m_shadowOffsets.size()) || m_shadowOffsets[location] < 0) {
+		// not a reflected default block uniform, always upload
+		m_uploadsIssued++;
+		return true;
+	}
+	if (size > m_shadowSizes[location]) {
+		// wider than the uniform's type, it would overrun the next slot, gl reports the mismatch on upload
+		m_uploadsIssued++;
+		return true;
+	}
+	unsigned char* shadow = m_shadowData.data() + m_shadowOffsets[location];
+	if (m_shadowValid[location] && std::memcmp(shadow, value, size) == 0) {
+		m_uploadsSkipped++;
+		return false;
+	}
+	std::memcpy(shadow, value, size);
+	m_shadowValid[location] = 1;
+	m_uploadsIssued++;
+	return true;
+}
+
+void ShaderProgram::set_int(GLint location, GLint value) {
+	if (location >= 0 && update_shadow(location, &value, sizeof(value))) {
+		glUniform1i(location, value);
+	}
+}
+
+void ShaderProgram::set_float(GLint location, float value) {
+	if (location >= 0 && update_shadow(location, &value, sizeof(value))) {
+		glUniform1f(location, value);
+	}
+}
+
+void ShaderProgram::set_vec3(GLint location, const glm::vec3& value) {
+	if (location >= 0 && update_shadow(location, &value[0], sizeof(float) * 3)) {
+		glUniform3fv(location, 1, &value[0]);
+	}
+}
+
+void ShaderProgram::set_vec4(GLint location, const glm::vec4& value) {
+	if (location >= 0 && update_shadow(location, &value[0], sizeof(float) * 4)) {
+		glUniform4fv(location, 1, &value[0]);
+	}
+}
+
+void ShaderProgram::set_mat4(GLint location, const glm::mat4& value) {
+	if (location >= 0 && update_shadow(location, &value[0][0], sizeof(float) * 16)) {
+		glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "ProgramCache.h"
+
+// one reflected entry of a program's interface (uniform, vertex input or block)
+struct ShaderResource {
+	std::string m_name;
+	GLenum m_type = 0;
+	GLint m_arraySize = 1;
+	// uniform / attribute location, -1 for uniforms that live inside a block
+	GLint m_location = -1;
+	// uniforms: owning block index or -1, blocks: their resource index
+	GLint m_blockIndex = -1;
+	// blocks only
+	GLint m_binding = -1;
+	GLint m_dataSize = 0;
+};
+
+// linked gl program (built through the ProgramCache) with its interface reflected into hashed tables at link time
+// typed setters shadow the last uploaded value per location and skip the gl call when nothing changed
+class ShaderProgram {
+public:
+	ShaderProgram();
+	~ShaderProgram();
+
+	ShaderProgram(const ShaderProgram&) = delete;
+	ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+	// compiles, links and reflects, returns false (and logs why) on failure
+	bool create(const std::string& vertexSource, const std::string& fragmentSource);
+	bool create_from_files(const std::string& vertexPath, const std::string& fragmentPath);
+	// single compute stage program, dispatched with glDispatchCompute after bind()
+	bool create_compute(const std::string& computeSource);
+	bool create_compute_from_file(const std::string& computePath);
+	// starts the driver on a program a later create_*() will ask for, see ProgramCache::prefetch
+	static void prefetch_from_files(const std::string& vertexPath, const std::string& fragmentPath);
+	static void prefetch_compute_from_file(const std::string& computePath);
+	void destroy(void);
+
+	void bind(void) const;
+	GLuint get_id(void) const { return m_program; }
+	bool is_valid(void) const { return m_program != 0; }
+
+	// -1 if the uniform is not active, cache the result rather than looking up per draw
+	GLint get_uniform_location(std::string_view name) const;
+	const ShaderResource* find_uniform(std::string_view name) const;
+	const ShaderResource* find_attribute(std::string_view name) const;
+	const ShaderResource* find_uniform_block(std::string_view name) const;
+	const ShaderResource* find_storage_block(std::string_view name) const;
+
+	// program must be bound, a location of -1 is ignored like gl does
+	void set_int(GLint location, GLint value);
+	void set_float(GLint location, float value);
+	void set_vec3(GLint location, const glm::vec3& value);
+	void set_vec4(GLint location, const glm::vec4& value);
+	void set_mat4(GLint location, const glm::mat4& value);
+
+	uint64_t get_uploads_issued(void) const { return m_uploadsIssued; }
+	uint64_t get_uploads_skipped(void) const { return m_uploadsSkipped; }
+
+	// file with its #includes expanded (see ShaderPreprocessor), empty if it could not be read
+	static std::string load_source(const std::string& path);
+	static uint64_t hash_name(std::string_view name);
+
+private:
+	using ResourceTable = std::unordered_map<uint64_t, ShaderResource>;
+
+	// gets the linked program from the program cache, reflects it and takes ownership
+	bool build(const ShaderStageSource* stages, uint32_t stageCount);
+	void reflect(void);
+	void reflect_interface(GLenum programInterface, ResourceTable& table);
+	static const ShaderResource* find(const ResourceTable& table, std::string_view name);
+
+	// true if value differs from the shadow copy (and updates it), false if the upload can be skipped
+	bool update_shadow(GLint location, const void* value, size_t size);
+
+	GLuint m_program;
+
+	ResourceTable m_uniforms;
+	ResourceTable m_attributes;
+	ResourceTable m_uniformBlocks;
+	ResourceTable m_storageBlocks;
+
+	// per location offset into m_shadowData, sized from the reflected uniform types
+	std::vector<int32_t> m_shadowOffsets;
+	// bytes each slot holds, a setter wider than its uniform's type bypasses the shadow
+	std::vector<uint8_t> m_shadowSizes;
+	std::vector<uint8_t> m_shadowValid;
+	std::vector<unsigned char> m_shadowData;
+
+	uint64_t m_uploadsIssued;
+	uint64_t m_uploadsSkipped;
+};
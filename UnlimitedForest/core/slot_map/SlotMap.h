@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 32 bit generational handle into a SlotMap
+// low bits index the sparse slot array, high bits hold the generation of that slot
+// the generation is bumped every time a slot is freed so stale handles fail lookup instead of aliasing a new item
+struct SlotHandle {
+	static constexpr uint32_t INDEX_BITS = 20;
+	static constexpr uint32_t GENERATION_BITS = 32 - INDEX_BITS;
+	static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static constexpr uint32_t GENERATION_MASK = (1u << GENERATION_BITS) - 1;
+	// max generation is never handed out so this value can never be a live handle
+	static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+
+	uint32_t m_value = INVALID;
+
+	SlotHandle() = default;
+	explicit SlotHandle(uint32_t value) : m_value(value) {}
+	SlotHandle(uint32_t index, uint32_t generation)
+		: m_value((generation << INDEX_BITS) | (index & INDEX_MASK)) {}
+
+	uint32_t index(void) const { return m_value & INDEX_MASK; }
+	uint32_t generation(void) const { return m_value >> INDEX_BITS; }
+	bool is_valid(void) const { return m_value != INVALID; }
+
+	bool operator==(const SlotHandle& other) const { return m_value == other.m_value; }
+	bool operator!=(const SlotHandle& other) const { return m_value != other.m_value; }
+};
+
+// slot map with O(1) insert / erase / lookup and items packed densely for iteration
+// items are stored contiguously in m_dense, erase swaps the last item into the hole so order is not stable
+// sparse slots map handle index -> dense index, free slots are chained through m_denseIndex
+template<typename T>
+class SlotMap {
+public:
+	using iterator = typename std::vector<T>::iterator;
+	using const_iterator = typename std::vector<T>::const_iterator;
+
+	static constexpr size_t MAX_ITEMS = static_cast<size_t>(SlotHandle::INDEX_MASK) + 1;
+
+	// returns an invalid handle if the map is full
+	template<typename... Args>
+	SlotHandle emplace(Args&&... args) {
+		uint32_t slotIdx;
+		if (m_freeHead != NO_SLOT) {
+			slotIdx = m_freeHead;
+			m_freeHead = m_slots[slotIdx].m_denseIndex;
+		}
+		else {
+			if (m_slots.size() >= MAX_ITEMS) {
+				return SlotHandle();
+			}
+			slotIdx = static_cast<uint32_t>(m_slots.size());
+			m_slots.push_back({ NO_SLOT, 0 });
+		}
+
+		Slot& slot = m_slots[slotIdx];
+		slot.m_denseIndex = static_cast<uint32_t>(m_dense.size());
+		m_dense.emplace_back(std::forward<Args>(args)...);
+		m_denseToSlot.push_back(slotIdx);
+
+		return SlotHandle(slotIdx, slot.m_generation);
+	}
+
+	SlotHandle insert(const T& value) {
+		return emplace(value);
+	}
+
+	bool erase(const SlotHandle& handle) {
+		if (!contains(handle)) {
+			return false;
+		}
+		uint32_t slotIdx = handle.index();
+		uint32_t denseIdx = m_slots[slotIdx].m_denseIndex;
+		uint32_t lastIdx = static_cast<uint32_t>(m_dense.size() - 1);
+
+		// fill the hole with the last item to keep storage packed
+		if (denseIdx != lastIdx) {
+			m_dense[denseIdx] = std::move(m_dense[lastIdx]);
+			m_denseToSlot[denseIdx] = m_denseToSlot[lastIdx];
+			m_slots[m_denseToSlot[denseIdx]].m_denseIndex = denseIdx;
+		}
+		m_dense.pop_back();
+		m_denseToSlot.pop_back();
+
+		// retire the generation and push the slot on the free list
+		Slot& slot = m_slots[slotIdx];
+		slot.m_generation = (slot.m_generation + 1) % SlotHandle::GENERATION_MASK;
+		slot.m_denseIndex = m_freeHead;
+		m_freeHead = slotIdx;
+		return true;
+	}
+
+	bool contains(const SlotHandle& handle) const {
+		if (!handle.is_valid() || handle.index() >= m_slots.size()) {
+			return false;
+		}
+		const Slot& slot = m_slots[handle.index()];
+		return slot.m_generation == handle.generation() && slot.m_denseIndex < m_dense.size()
+			&& m_denseToSlot[slot.m_denseIndex] == handle.index();
+	}
+
+	// nullptr if the handle is stale or was never valid
+	T* get(const SlotHandle& handle) {
+		return contains(handle) ? &m_dense[m_slots[handle.index()].m_denseIndex] : nullptr;
+	}
+
+	const T* get(const SlotHandle& handle) const {
+		return contains(handle) ? &m_dense[m_slots[handle.index()].m_denseIndex] : nullptr;
+	}
+
+	// handle of the item currently at a dense position, used while iterating
+	SlotHandle handle_at(size_t denseIdx) const {
+		uint32_t slotIdx = m_denseToSlot[denseIdx];
+		return SlotHandle(slotIdx, m_slots[slotIdx].m_generation);
+	}
+
+	void reserve(size_t count) {
+		m_slots.reserve(count);
+		m_dense.reserve(count);
+		m_denseToSlot.reserve(count);
+	}
+
+	void clear(void) {
+		// bump every live generation so outstanding handles go stale
+		for (size_t i = 0, s = m_dense.size(); i < s; i++) {
+			uint32_t slotIdx = m_denseToSlot[i];
+			Slot& slot = m_slots[slotIdx];
+			slot.m_generation = (slot.m_generation + 1) % SlotHandle::GENERATION_MASK;
+			slot.m_denseIndex = m_freeHead;
+			m_freeHead = slotIdx;
+		}
+		m_dense.clear();
+		m_denseToSlot.clear();
+	}
+
+	size_t size(void) const { return m_dense.size(); }
+	bool empty(void) const { return m_dense.empty(); }
+
+	T* data(void) { return m_dense.data(); }
+	const T* data(void) const { return m_dense.data(); }
+	T& operator[](size_t denseIdx) { return m_dense[denseIdx]; }
+	const T& operator[](size_t denseIdx) const { return m_dense[denseIdx]; }
+
+	iterator begin(void) { return m_dense.begin(); }
+	iterator end(void) { return m_dense.end(); }
+	const_iterator begin(void) const { return m_dense.begin(); }
+	const_iterator end(void) const { return m_dense.end(); }
+
+private:
+	static constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+	struct Slot {
+		// dense position while alive, next free slot while on the free list
+		uint32_t m_denseIndex;
+		uint32_t m_generation;
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<T> m_dense;
+	std::vector<uint32_t> m_denseToSlot;
+	uint32_t m_freeHead = NO_SLOT;
+};
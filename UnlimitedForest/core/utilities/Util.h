@@ -1,7 +1,18 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
 
-
-
-
+// 64 bit fnv-1a, chain calls by passing the previous result as the seed
+inline uint64_t hash_fnv1a(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
@@ -0,0 +1,16 @@
+#version 450 core
+// depth prepass over the queue (see Renderer::draw_scene), color writes are masked off so only the
+// cross-fade dither is evaluated, the shaded pass then tests against the depth left here
+// without UF_LOD_DITHER this is empty and the driver can take its depth only fast path
+#ifdef UF_LOD_DITHER
+flat in float v_lodFade;
+#endif
+
+#include "include/lod_dither.glsl"
+
+void main()
+{
+#ifdef UF_LOD_DITHER
+    lod_dither(v_lodFade);
+#endif
+}
\ No newline at end of file
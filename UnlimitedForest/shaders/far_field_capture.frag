@@ -0,0 +1,83 @@
+#version 450 core
+in vec2 v_ndc;
+
+// cube face being captured and where from, see FarField::render_face
+uniform int u_Face;
+uniform vec3 u_CapturePosition;
+// the far field starts where the near scene ends and fades into the sky at the far distance
+uniform float u_NearRadius;
+uniform float u_FarDistance;
+
+out vec4 FragColor;
+
+const vec3 SKY_HORIZON = vec3(0.62, 0.72, 0.8);
+const vec3 SKY_ZENITH = vec3(0.25, 0.45, 0.75);
+const vec3 CANOPY_DARK = vec3(0.06, 0.2, 0.08);
+const vec3 CANOPY_LIGHT = vec3(0.2, 0.42, 0.18);
+const int MARCH_STEPS = 96;
+
+// direction through texel (s, t) of a face, in the order and orientation gl samples cubemaps
+vec3 face_direction(int face, vec2 st)
+{
+    switch (face) {
+    case 0: return vec3(1.0, -st.y, -st.x);
+    case 1: return vec3(-1.0, -st.y, st.x);
+    case 2: return vec3(st.x, 1.0, st.y);
+    case 3: return vec3(st.x, -1.0, -st.y);
+    case 4: return vec3(st.x, -st.y, 1.0);
+    default: return vec3(-st.x, -st.y, -1.0);
+    }
+}
+
+float hash(vec2 p)
+{
+    return fract(sin(dot(p, vec2(127.1, 311.7))) * 43758.5453);
+}
+
+float value_noise(vec2 p)
+{
+    vec2 cell = floor(p);
+    vec2 f = fract(p);
+    f = f * f * (3.0 - 2.0 * f);
+    return mix(
+        mix(hash(cell), hash(cell + vec2(1.0, 0.0)), f.x),
+        mix(hash(cell + vec2(0.0, 1.0)), hash(cell + vec2(1.0, 1.0)), f.x),
+        f.y
+    );
+}
+
+// rolling hills in world space, so consecutive captures from different places line up
+float terrain_height(vec2 p)
+{
+    return value_noise(p * 0.004) * 40.0 + value_noise(p * 0.013) * 12.0 - 10.0;
+}
+
+float canopy_height(vec2 p)
+{
+    return 6.0 + value_noise(p * 0.08) * 4.0;
+}
+
+void main()
+{
+    vec3 direction = normalize(face_direction(u_Face, v_ndc));
+    vec3 color = mix(SKY_HORIZON, SKY_ZENITH, clamp(direction.y * 2.0, 0.0, 1.0));
+
+    // geometric steps outward from the near scene's edge, far detail covers fewer pixels
+    float t = u_NearRadius;
+    float stepRatio = pow(u_FarDistance / u_NearRadius, 1.0 / float(MARCH_STEPS));
+    for (int i = 0; i < MARCH_STEPS; i++) {
+        vec3 p = u_CapturePosition + direction * t;
+        float ground = terrain_height(p.xz);
+        float canopy = canopy_height(p.xz);
+        if (p.y < ground + canopy) {
+            // lighter crowns, darker towards the floor, and haze with distance
+            float crown = clamp((p.y - ground) / canopy, 0.0, 1.0);
+            vec3 canopyColor = mix(CANOPY_DARK, CANOPY_LIGHT, value_noise(p.xz * 0.25)) * mix(0.6, 1.0, crown);
+            float haze = 1.0 - exp(-3.0 * t / u_FarDistance);
+            color = mix(canopyColor, SKY_HORIZON, haze);
+            break;
+        }
+        t *= stepRatio;
+    }
+    FragColor = vec4(color, 1.0);
+}
\ No newline at end of file
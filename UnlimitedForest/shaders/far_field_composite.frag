@@ -0,0 +1,14 @@
+#version 450 core
+in vec2 v_ndc;
+
+// inverse of projection * camera rotation, turns clip space into view rays
+uniform mat4 u_InverseViewRays;
+layout(binding = 0) uniform samplerCube u_Panorama;
+
+out vec4 FragColor;
+
+void main()
+{
+    vec4 ray = u_InverseViewRays * vec4(v_ndc, 1.0, 1.0);
+    FragColor = vec4(texture(u_Panorama, ray.xyz / ray.w).rgb, 1.0);
+}
\ No newline at end of file
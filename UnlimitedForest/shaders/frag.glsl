@@ -1,12 +1,19 @@
-#version 460 core
+#version 450 core
 in vec3 v_vectorColor;
+#ifdef UF_LOD_DITHER
+flat in float v_lodFade;
+#endif
 
-uniform mat4 u_ModelMatrix;
-uniform mat4 u_Perspective;
+#include "include/frame_uniforms.glsl"
 
 out vec4 FragColor;
 
+#include "include/lod_dither.glsl"
+
 void main()
 {
+#ifdef UF_LOD_DITHER
+    lod_dither(v_lodFade);
+#endif
     FragColor = vec4(v_vectorColor.r, v_vectorColor.g, v_vectorColor.b, 1.0f);
 }
\ No newline at end of file
@@ -0,0 +1,10 @@
+#version 450 core
+// one triangle covering the screen, no vertex buffer, v_ndc runs -1..1 over the visible part
+out vec2 v_ndc;
+
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    v_ndc = position;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 450 core
+in vec2 v_atlasUv;
+in vec3 v_position;
+in vec3 v_vectorColor;
+flat in vec3 v_frameDirection;
+flat in float v_radius;
+
+#include "include/frame_uniforms.glsl"
+
+// see Impostor in ImpostorBaker.h
+layout(binding = 0) uniform sampler2D u_Albedo;
+layout(binding = 1) uniform sampler2D u_NormalDepth;
+
+out vec4 FragColor;
+
+void main()
+{
+    vec4 albedo = texture(u_Albedo, v_atlasUv);
+    if (albedo.a < 0.5) {
+        discard;
+    }
+
+    // push the fragment off the quad to the baked surface so impostors intersect like the meshes would,
+    // depth 0 is the sphere's near side (towards the frame direction), 1 its far side
+    float depth = texture(u_NormalDepth, v_atlasUv).a;
+    vec4 clipPosition = u_ViewProjection * vec4(v_position + v_frameDirection * v_radius * (1.0 - 2.0 * depth), 1.0);
+    gl_FragDepth = clipPosition.z / clipPosition.w * 0.5 + 0.5;
+
+    FragColor = vec4(albedo.rgb * v_vectorColor, 1.0f);
+}
\ No newline at end of file
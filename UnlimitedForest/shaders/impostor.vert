@@ -0,0 +1,75 @@
+#version 450 core
+
+#include "include/frame_uniforms.glsl"
+
+// the main instance stream, see DrawData.h
+#include "include/instance.glsl"
+
+layout(std430, binding = 1) readonly buffer Instances {
+    Instance instances[];
+};
+
+// first instance of this species in the stream
+uniform int u_FirstInstance;
+// mesh space bounding sphere the frames were baked around, and frames per atlas side
+uniform vec3 u_ImpostorCenter;
+uniform float u_ImpostorRadius;
+uniform int u_ImpostorFrames;
+
+out vec2 v_atlasUv;
+out vec3 v_position;
+out vec3 v_vectorColor;
+flat out vec3 v_frameDirection;
+flat out float v_radius;
+
+const vec2 QUAD_CORNERS[6] = vec2[6](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+
+// hemi-octahedral frame layout, must match ImpostorBaker::get_frame_direction
+vec3 frame_direction(vec2 frame)
+{
+    vec2 uv = frame / float(u_ImpostorFrames - 1) * 2.0 - 1.0;
+    vec2 p = vec2(uv.x + uv.y, uv.x - uv.y) * 0.5;
+    return normalize(vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y));
+}
+
+// nearest frame to a mesh space direction, views from below the horizon use the horizon frames
+vec2 nearest_frame(vec3 direction)
+{
+    direction.y = max(direction.y, 0.0);
+    direction /= abs(direction.x) + direction.y + abs(direction.z);
+    vec2 uv = vec2(direction.x + direction.z, direction.x - direction.z) * 0.5 + 0.5;
+    return round(uv * float(u_ImpostorFrames - 1));
+}
+
+void main()
+{
+    Instance instance = instances[u_FirstInstance + gl_InstanceID];
+    mat3 basis = mat3(instance.model);
+    vec3 center = (instance.model * vec4(u_ImpostorCenter, 1.0)).xyz;
+    float scale = max(length(basis[0]), max(length(basis[1]), length(basis[2])));
+
+    // the camera direction in mesh space picks the frame, items are assumed to be rotated and uniformly scaled
+    vec3 toCamera = normalize(transpose(basis) * (u_CameraPosition - center));
+    vec2 frame = nearest_frame(toCamera);
+    vec3 direction = frame_direction(frame);
+
+    // the quad faces the frame's direction (not the camera) so it lines up with what was baked,
+    // the basis is the one the bake camera used, see ImpostorBaker.cpp
+    vec3 up = direction.y > 0.999 ? vec3(0.0, 0.0, -1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up, direction));
+    up = cross(direction, right);
+
+    vec2 corner = QUAD_CORNERS[gl_VertexID];
+    vec3 localPosition = u_ImpostorCenter + (right * corner.x + up * corner.y) * u_ImpostorRadius;
+    vec4 worldPosition = instance.model * vec4(localPosition, 1.0);
+    gl_Position = u_ViewProjection * worldPosition;
+
+    v_atlasUv = (frame + corner * 0.5 + 0.5) / float(u_ImpostorFrames);
+    v_position = worldPosition.xyz;
+    v_vectorColor = instance.color.rgb;
+    v_frameDirection = normalize(basis * direction);
+    v_radius = u_ImpostorRadius * scale;
+}
\ No newline at end of file
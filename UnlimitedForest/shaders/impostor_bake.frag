@@ -0,0 +1,21 @@
+#version 450 core
+in vec3 v_position;
+in vec3 v_vectorColor;
+
+// mesh space direction from the mesh towards this frame's camera
+uniform vec3 u_FrameDirection;
+
+layout(location = 0) out vec4 AlbedoColor;
+layout(location = 1) out vec4 NormalDepth;
+
+void main()
+{
+    // meshes carry no normals, the face normal is rebuilt from the position derivatives and turned to the camera
+    vec3 normal = normalize(cross(dFdx(v_position), dFdy(v_position)));
+    if (dot(normal, u_FrameDirection) < 0.0) {
+        normal = -normal;
+    }
+    AlbedoColor = vec4(v_vectorColor, 1.0f);
+    // depth is linear across the bounding sphere, 0 on the side facing the camera
+    NormalDepth = vec4(normal * 0.5 + 0.5, gl_FragCoord.z);
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#version 450 core
+layout(location = 0) in vec3 vectorPosition;
+layout(location = 1) in vec3 vectorColor;
+
+// orthographic view of the mesh bounding sphere from one atlas frame, see ImpostorBaker::bake
+uniform mat4 u_FrameViewProjection;
+// index of the mesh being baked into the decode stream, see VertexFormat.h
+uniform int u_Mesh;
+
+struct MeshDecode {
+    vec4 positionOffset;
+    vec4 positionScale;
+};
+
+layout(std430, binding = 7) readonly buffer MeshDecodes {
+    MeshDecode meshDecodes[];
+};
+
+out vec3 v_position;
+out vec3 v_vectorColor;
+
+void main()
+{
+    MeshDecode decode = meshDecodes[u_Mesh];
+    vec3 position = decode.positionOffset.xyz + vectorPosition * decode.positionScale.xyz;
+    gl_Position = u_FrameViewProjection * vec4(position, 1.0f);
+    v_position = position;
+    v_vectorColor = vectorColor;
+}
\ No newline at end of file
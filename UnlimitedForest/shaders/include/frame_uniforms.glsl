@@ -0,0 +1,8 @@
+// written once per frame by the renderer, see FrameUniforms.h
+layout(std140, binding = 0) uniform FrameUniforms {
+    mat4 u_View;
+    mat4 u_Projection;
+    mat4 u_ViewProjection;
+    vec3 u_CameraPosition;
+    float u_Time;
+};
\ No newline at end of file
@@ -0,0 +1,7 @@
+// one entry of the per-frame instance stream, see InstanceData in DrawData.h
+struct Instance {
+    mat4 model;
+    vec4 color;
+    // x: lod cross-fade
+    vec4 params;
+};
\ No newline at end of file
@@ -0,0 +1,24 @@
+// lod cross-fade dither, shared by every program that draws the mesh queue so the two levels of a fade
+// (and the depth prepass) cover exactly complementary pixels
+// only variants built with UF_LOD_DITHER get it (see ShaderPermutations.h), the others never discard
+#ifdef UF_LOD_DITHER
+
+// 4x4 ordered dither thresholds in (0, 1), screen space so the two levels of a cross-fade interleave exactly
+const float DITHER_THRESHOLDS[16] = float[16](
+     0.5 / 16.0,  8.5 / 16.0,  2.5 / 16.0, 10.5 / 16.0,
+    12.5 / 16.0,  4.5 / 16.0, 14.5 / 16.0,  6.5 / 16.0,
+     3.5 / 16.0, 11.5 / 16.0,  1.5 / 16.0,  9.5 / 16.0,
+    15.5 / 16.0,  7.5 / 16.0, 13.5 / 16.0,  5.5 / 16.0
+);
+
+// fade > 0 keeps that share of the dither pattern, < 0 keeps the complement (see InstanceData), never 0 here
+void lod_dither(float fade)
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+    float threshold = DITHER_THRESHOLDS[pixel.y * 4 + pixel.x];
+    if (fade > 0.0 ? threshold >= fade : threshold < -fade) {
+        discard;
+    }
+}
+
+#endif
\ No newline at end of file
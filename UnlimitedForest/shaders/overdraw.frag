@@ -0,0 +1,18 @@
+#version 450 core
+// overdraw view (see Renderer::draw_scene), blended additively so a pixel's brightness counts the fragments
+// shaded there: dark red is 1, red 8, yellow 16 and white 32 or more
+#ifdef UF_LOD_DITHER
+flat in float v_lodFade;
+#endif
+
+out vec4 FragColor;
+
+#include "include/lod_dither.glsl"
+
+void main()
+{
+#ifdef UF_LOD_DITHER
+    lod_dither(v_lodFade);
+#endif
+    FragColor = vec4(1.0 / 8.0, 1.0 / 16.0, 1.0 / 32.0, 1.0);
+}
\ No newline at end of file
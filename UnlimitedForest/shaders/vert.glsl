@@ -1,16 +1,59 @@
-#version 460 core
+#version 450 core
+// gl_DrawID is core in 4.6, the extension keeps 4.5 drivers (mesa llvmpipe) working
+#extension GL_ARB_shader_draw_parameters : require
 layout(location = 0) in vec3 vectorPosition;
 layout(location = 1) in vec3 vectorColor;
 
-uniform mat4 u_ModelMatrix;
-uniform mat4 u_Perspective;
-uniform mat4 u_ViewMatrix;
+#include "include/frame_uniforms.glsl"
+
+// per-frame draw streams, see DrawData.h
+#include "include/instance.glsl"
+
+struct Draw {
+    uint firstInstance;
+    uint instanceCount;
+    uint mesh;
+    uint lod;
+};
+
+layout(std430, binding = 1) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(std430, binding = 2) readonly buffer Draws {
+    Draw draws[];
+};
+
+// per mesh, stored positions may be quantized across the mesh bounds, see VertexFormat.h
+struct MeshDecode {
+    vec4 positionOffset;
+    vec4 positionScale;
+};
+
+layout(std430, binding = 7) readonly buffer MeshDecodes {
+    MeshDecode meshDecodes[];
+};
+
+// index of this multi draw's first entry in draws[]
+uniform int u_DrawOffset;
 
 out vec3 v_vectorColor;
+#ifdef UF_LOD_DITHER
+flat out float v_lodFade;
+#endif
+// the depth prepass and the shaded pass compare depths with GL_LEQUAL, both have to land on the same value
+invariant gl_Position;
 
 void main()
 {
-    vec4 newPosition = u_Perspective * u_ViewMatrix * u_ModelMatrix * vec4(vectorPosition, 1.0f);
+    Draw draw = draws[u_DrawOffset + gl_DrawIDARB];
+    Instance instance = instances[draw.firstInstance + gl_InstanceID];
+    MeshDecode decode = meshDecodes[draw.mesh];
+    vec3 position = decode.positionOffset.xyz + vectorPosition * decode.positionScale.xyz;
+    vec4 newPosition = u_ViewProjection * instance.model * vec4(position, 1.0f);
     gl_Position = newPosition;
-    v_vectorColor = vectorColor;
-}
+    v_vectorColor = vectorColor * instance.color.rgb;
+#ifdef UF_LOD_DITHER
+    v_lodFade = instance.params.x;
+#endif
+}
\ No newline at end of file